@@ -0,0 +1,70 @@
+// Compares the read cost of the built-in Clock time functions and their drift from
+// std::chrono::steady_clock.
+//
+// Usage: clock_benchmark [drift_seconds]
+#include <morai/Clock.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+/// Time @p iterations calls to @p time_function.
+/// @return Nanoseconds per call.
+double readCost(const morai::Clock::TimeFunction &time_function, const unsigned iterations)
+{
+  double sink = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iterations; ++i)
+  {
+    sink += time_function();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  // Keep the reads observable.
+  if (sink < 0)
+  {
+    std::cout << sink;
+  }
+  return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+/// Measure the difference between the time elapsed according to @p time_function and
+/// @c std::chrono::steady_clock over @p duration_s.
+/// @return The drift in microseconds.
+double drift(const morai::Clock::TimeFunction &time_function, const double duration_s)
+{
+  const auto start_time = std::chrono::steady_clock::now();
+  const double start_s = time_function();
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration_s));
+  const double elapsed_s = time_function() - start_s;
+  const double expected_s =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  return (elapsed_s - expected_s) * 1e6;
+}
+
+void report(const std::string_view name, const morai::Clock::TimeFunction &time_function,
+            const double drift_s)
+{
+  // Prime first use, e.g., TSC calibration.
+  (void)time_function();
+  std::cout << std::format("  {:<8} {:8.2f} {:12.1f}\n", name, readCost(time_function, 10'000'000),
+                           drift(time_function, drift_s));
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  const double drift_s = (argc > 1) ? std::atof(argv[1]) : 2.0;
+
+  std::cout << std::format("TSC available: {}\n", morai::Clock::tsc_available());
+  std::cout << std::format("  {:<8} {:>8} {:>12}\n", "clock", "ns/read",
+                           std::format("drift({}s) us", drift_s));
+  report("steady", morai::Clock::steady_clock_time_function, drift_s);
+  report("tsc", morai::Clock::tsc_time_function, drift_s);
+  report("coarse", morai::Clock::coarse_time_function, drift_s);
+  return 0;
+}
@@ -0,0 +1,155 @@
+// Compares SharedQueue backends under contention: rigtorp::MPMCQueue with a cache line per slot
+// against CompactQueue with packed and padded slots, for single and bulk operations.
+//
+// Usage: queue_benchmark [thread_count]
+#include <morai/CompactQueue.hpp>
+#include <morai/MPMCQueue.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using morai::CompactQueue;
+
+constexpr uint32_t Capacity = 1024;
+constexpr std::size_t BulkSize = 16;
+
+/// Adapts rigtorp::MPMCQueue to the CompactQueue interface.
+class PaddedQueue
+{
+public:
+  explicit PaddedQueue(uint32_t capacity)
+    : _queue(capacity)
+  {}
+
+  bool tryPush(void *item) noexcept { return _queue.try_push(item); }
+  void *tryPop() noexcept
+  {
+    void *item = nullptr;
+    _queue.try_pop(item);
+    return item;
+  }
+  std::size_t tryPushN(std::span<void *const> items) noexcept
+  {
+    return _queue.try_push_n(items.data(), items.size());
+  }
+  std::size_t tryPopN(std::span<void *> items) noexcept
+  {
+    return _queue.try_pop_n(items.data(), items.size());
+  }
+
+private:
+  rigtorp::MPMCQueue<void *> _queue;
+};
+
+/// Push and pop @p items_per_producer items through @p queue from @p pair_count producer and
+/// consumer pairs, @p batch items per operation.
+/// @return Million items per second.
+template <typename Queue>
+double throughput(Queue &queue, const unsigned pair_count, const uint64_t items_per_producer,
+                  const std::size_t batch)
+{
+  std::atomic<unsigned> ready = 0;
+  std::atomic_flag go = ATOMIC_FLAG_INIT;
+  std::atomic<uint64_t> remaining = items_per_producer * pair_count;
+  std::vector<std::jthread> threads;
+
+  for (unsigned i = 0; i < pair_count; ++i)
+  {
+    threads.emplace_back([&]() {
+      ready.fetch_add(1);
+      go.wait(false);
+      std::array<void *, BulkSize> items;
+      items.fill(&queue);
+      uint64_t pushed = 0;
+      while (pushed < items_per_producer)
+      {
+        const std::size_t count = std::min<uint64_t>(batch, items_per_producer - pushed);
+        const std::size_t done = (count == 1) ? queue.tryPush(items[0])
+                                              : queue.tryPushN(std::span{ items }.first(count));
+        pushed += done;
+        if (done == 0)
+        {
+          // Full. Let consumers run when threads outnumber cores.
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&]() {
+      ready.fetch_add(1);
+      go.wait(false);
+      std::array<void *, BulkSize> items;
+      while (remaining.load(std::memory_order_relaxed) > 0)
+      {
+        const std::size_t count = (batch == 1) ? (queue.tryPop() != nullptr)
+                                               : queue.tryPopN(std::span{ items }.first(batch));
+        if (count > 0)
+        {
+          remaining.fetch_sub(count, std::memory_order_relaxed);
+        }
+        else
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  while (ready.load() < threads.size())
+  {
+    std::this_thread::yield();
+  }
+  const auto start = std::chrono::steady_clock::now();
+  go.test_and_set();
+  go.notify_all();
+  threads.clear();
+  const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                             .count();
+  return static_cast<double>(items_per_producer * pair_count) / elapsed_s * 1e-6;
+}
+
+template <typename Queue, typename... Args>
+void report(std::string_view name, std::size_t bytes, const unsigned pair_count, Args... args)
+{
+  const uint64_t items = 2'000'000;
+  std::cout << std::format("  {:<20} {:>6} KB", name, bytes / 1024);
+  for (const std::size_t batch : { std::size_t{ 1 }, BulkSize })
+  {
+    Queue queue{ Capacity, args... };
+    std::cout << std::format(" {:10.1f}", throughput(queue, pair_count, items, batch));
+  }
+  std::cout << "\n";
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  const unsigned thread_count =
+    (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : std::thread::hardware_concurrency();
+  const unsigned pair_count = std::max(thread_count / 2, 1u);
+
+  std::cout << std::format("{} producers, {} consumers, {} slots (M items/s)\n", pair_count,
+                           pair_count, Capacity);
+  std::cout << std::format("  {:<20} {:>9} {:>10} {:>10}\n", "Queue", "Memory", "Single",
+                           "Bulk");
+  report<PaddedQueue>("Padded (rigtorp)", (Capacity + 1) * rigtorp::mpmc::hardwareInterferenceSize,
+                      pair_count);
+  for (const uint32_t slot_size : { 16u, 32u, 64u })
+  {
+    const CompactQueue sizing{ Capacity, slot_size };
+    report<CompactQueue>(std::format("Compact ({}B slots)", sizing.slotSize()),
+                         sizing.capacity() * sizing.slotSize(), pair_count, slot_size);
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+// Compares the cost of reading the time from multiple threads and the resulting ThreadPool
+// throughput for each PoolTimeSource.
+//
+// Usage: time_source_benchmark [thread_count]
+#include <morai/Clock.hpp>
+#include <morai/ThreadPool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using namespace std::chrono_literals;
+
+/// Time @p iterations calls to @p read from each of @p thread_count threads sharing @p clock.
+/// @return Nanoseconds per call.
+template <typename Read>
+double timeClockRead(morai::Clock &clock, const unsigned thread_count, const unsigned iterations,
+                     const Read &read)
+{
+  std::atomic<unsigned> ready = 0;
+  std::atomic_flag go = ATOMIC_FLAG_INIT;
+  std::atomic<int64_t> total_ns = 0;
+  std::vector<std::jthread> threads;
+  for (unsigned i = 0; i < thread_count; ++i)
+  {
+    threads.emplace_back([&]() {
+      ready.fetch_add(1);
+      go.wait(false);
+      double sink = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (unsigned j = 0; j < iterations; ++j)
+      {
+        sink += read(clock);
+      }
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      total_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+      // Keep the reads observable.
+      if (sink < 0)
+      {
+        std::cout << sink;
+      }
+    });
+  }
+
+  while (ready.load() < thread_count)
+  {
+    std::this_thread::yield();
+  }
+  go.test_and_set();
+  go.notify_all();
+  threads.clear();
+  return static_cast<double>(total_ns.load()) / (static_cast<double>(thread_count) * iterations);
+}
+
+/// Run yielding fibres on a pool using @p time_source for a fixed duration.
+/// @return Fibre resumes per second.
+double poolThroughput(const morai::PoolTimeSource time_source, const unsigned worker_count)
+{
+  morai::ThreadPoolParams params{};
+  params.worker_count = static_cast<int32_t>(worker_count);
+  params.time_source = time_source;
+  morai::ThreadPool pool{ params };
+
+  std::atomic<uint64_t> resumes = 0;
+  std::atomic_flag stop = ATOMIC_FLAG_INIT;
+  const auto fibre = [](std::atomic<uint64_t> &resumes, std::atomic_flag &stop) -> morai::Fibre {
+    uint64_t count = 0;
+    while (!stop.test())
+    {
+      ++count;
+      co_yield {};
+    }
+    resumes.fetch_add(count);
+  };
+
+  for (unsigned i = 0; i < worker_count * 64; ++i)
+  {
+    pool.start(fibre(resumes, stop));
+  }
+
+  const auto duration = 1s;
+  std::this_thread::sleep_for(duration);
+  stop.test_and_set();
+  pool.wait(5s);
+  return static_cast<double>(resumes.load()) / std::chrono::duration<double>(duration).count();
+}
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  const unsigned thread_count =
+    (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : std::thread::hardware_concurrency();
+  const unsigned iterations = 1'000'000;
+
+  morai::Clock clock;
+  clock.update();
+  std::cout << std::format("Clock reads, {} threads (ns/call)\n", thread_count);
+  std::cout << std::format("  epoch()  {:8.2f}\n",
+                           timeClockRead(clock, thread_count, iterations,
+                                         [](const morai::Clock &c) { return c.epoch(); }));
+  std::cout << std::format("  now()    {:8.2f}\n",
+                           timeClockRead(clock, thread_count, iterations,
+                                         [](const morai::Clock &c) { return c.now(); }));
+  std::cout << std::format("  update() {:8.2f}\n",
+                           timeClockRead(clock, thread_count, iterations,
+                                         [](morai::Clock &c) { return c.update(); }));
+
+  std::cout << std::format("ThreadPool, {} workers (resumes/s)\n", thread_count);
+  std::cout << std::format("  Ticker   {:12.0f}\n",
+                           poolThroughput(morai::PoolTimeSource::Ticker, thread_count));
+  std::cout << std::format("  Direct   {:12.0f}\n",
+                           poolThroughput(morai::PoolTimeSource::Direct, thread_count));
+  return 0;
+}
@@ -8,11 +8,9 @@
 #include <cxxopts.hpp>
 
 #include <array>
-#include <chrono>
 #include <iostream>
 #include <memory>
 #include <random>
-#include <thread>
 #include <vector>
 
 namespace
@@ -348,9 +346,9 @@ int main(int argc, char *argv[])
   bool quit = false;
   while (!quit)
   {
-    const auto now = std::chrono::steady_clock::now();
-    state->render_scheduler.update();
-    std::this_thread::sleep_until(now + std::chrono::duration<double>(state->render.target_dt));
+    // Update until the frame ends. This sleeps until a fibre is due or bodies arrive from the pool.
+    const double frame_end_s = state->render_scheduler.clock().now() + state->render.target_dt;
+    state->render_scheduler.runUntil(frame_end_s);
     quit = state->input.keyState(weaver::Key::Q) == weaver::KeyState::Down ||
            state->input.keyState(weaver::Key::Escape) == weaver::KeyState::Down;
   }
@@ -0,0 +1,135 @@
+#include "Clock.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MORAI_TSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif  // defined(__x86_64__) || defined(_M_X64)
+
+#if defined(__linux__)
+#include <time.h>
+#endif  // defined(__linux__)
+
+namespace morai
+{
+namespace
+{
+#ifdef MORAI_TSC
+/// Check CPUID for an invariant TSC: leaf 0x80000007, EDX bit 8.
+bool invariantTsc() noexcept
+{
+#if defined(_MSC_VER)
+  int regs[4] = {};
+  __cpuid(regs, 0x80000000);
+  if (static_cast<unsigned>(regs[0]) < 0x80000007u)
+  {
+    return false;
+  }
+  __cpuid(regs, 0x80000007);
+  return (regs[3] & (1 << 8)) != 0;
+#else   // defined(_MSC_VER)
+  unsigned eax = 0;
+  unsigned ebx = 0;
+  unsigned ecx = 0;
+  unsigned edx = 0;
+  if (!__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx))
+  {
+    return false;
+  }
+  return (edx & (1u << 8)) != 0;
+#endif  // defined(_MSC_VER)
+}
+
+/// Time stamp counter calibration against @c std::chrono::steady_clock.
+struct TscCalibration
+{
+  uint64_t base = 0;
+  double seconds_per_tick = 0;
+  bool valid = false;
+};
+
+TscCalibration measureTsc() noexcept
+{
+  if (!invariantTsc())
+  {
+    return {};
+  }
+
+  // Spin rather than sleep so the sample is not skewed by wake up latency.
+  using namespace std::chrono;
+  const auto calibration_time = milliseconds(10);
+  const auto start_time = steady_clock::now();
+  const uint64_t start_tsc = __rdtsc();
+  auto end_time = start_time;
+  while (end_time - start_time < calibration_time)
+  {
+    end_time = steady_clock::now();
+  }
+  const uint64_t end_tsc = __rdtsc();
+  if (end_tsc <= start_tsc)
+  {
+    return {};
+  }
+
+  return { .base = start_tsc,
+           .seconds_per_tick = duration<double>(end_time - start_time).count() /
+                               static_cast<double>(end_tsc - start_tsc),
+           .valid = true };
+}
+
+const TscCalibration &tscCalibration() noexcept
+{
+  static const TscCalibration calibration = measureTsc();
+  return calibration;
+}
+#endif  // MORAI_TSC
+}  // namespace
+
+double Clock::tsc_time_function() noexcept
+{
+#ifdef MORAI_TSC
+  const TscCalibration &calibration = tscCalibration();
+  if (calibration.valid)
+  {
+    return static_cast<double>(__rdtsc() - calibration.base) * calibration.seconds_per_tick;
+  }
+#endif  // MORAI_TSC
+  return steady_clock_time_function();
+}
+
+bool Clock::tsc_available() noexcept
+{
+#ifdef MORAI_TSC
+  return tscCalibration().valid;
+#else   // MORAI_TSC
+  return false;
+#endif  // MORAI_TSC
+}
+
+bool Clock::calibrateTsc() noexcept
+{
+  return tsc_available();
+}
+
+double Clock::coarse_time_function() noexcept
+{
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+  const auto read = []() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return now;
+  };
+  static const timespec base_time = read();
+  const timespec now = read();
+  // Subtract as integers to preserve precision.
+  return static_cast<double>(now.tv_sec - base_time.tv_sec) +
+         static_cast<double>(now.tv_nsec - base_time.tv_nsec) * 1e-9;
+#else   // defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+  return steady_clock_time_function();
+#endif  // defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+}
+}  // namespace morai
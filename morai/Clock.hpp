@@ -80,6 +80,11 @@ public:
   /// Get the current tick value from the last @c update() call.
   [[nodiscard]] uint64_t tick() const noexcept { return _time.load(); }
 
+  /// Invoke the @c TimeFunction without updating the @c epoch(). This avoids writing shared state
+  /// when multiple threads sample the time.
+  /// @return The current time (seconds).
+  [[nodiscard]] double now() const { return _now(); }
+
   /// Update the time value by invoking the @c TimeFunction and updating the @c epoch().
   /// @return The new epoch time.
   double update()
@@ -100,6 +105,32 @@ public:
     return duration<double>(elapsed).count();
   }
 
+  /// A time function reading the CPU time stamp counter, calibrated against
+  /// @c std::chrono::steady_clock by @c calibrateTsc(). Calibrates on the first call if not already
+  /// done, blocking briefly.
+  ///
+  /// Only used when the CPU reports an invariant TSC - constant rate across power states and cores.
+  /// Otherwise falls back to @c steady_clock_time_function(). See @c tsc_available().
+  ///
+  /// @return The epoch time (seconds) since calibration.
+  static double tsc_time_function() noexcept;
+
+  /// Check if @c tsc_time_function() reads the time stamp counter.
+  static bool tsc_available() noexcept;
+
+  /// Calibrate @c tsc_time_function() against @c std::chrono::steady_clock, if not already done.
+  /// The first call busy waits for about 10ms, so call this at startup rather than leaving it to
+  /// the first time sensitive read. A @c ThreadPool calibrates on construction.
+  /// @return True if @c tsc_time_function() reads the time stamp counter - see @c tsc_available().
+  static bool calibrateTsc() noexcept;
+
+  /// A low cost, low resolution time function using @c CLOCK_MONOTONIC_COARSE on Linux. The
+  /// resolution is the kernel tick, typically 1-4ms, so this suits time slicing and coarse sleeps.
+  /// Falls back to @c steady_clock_time_function() on other platforms.
+  ///
+  /// @return The epoch time (seconds) since the first call to this function.
+  static double coarse_time_function() noexcept;
+
 private:
   std::atomic_uint64_t _time{ 0 };
   const double _quantisation = DefaultQuantisation;
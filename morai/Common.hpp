@@ -1,8 +1,12 @@
 #pragma once
 
+#include "InlineFunction.hpp"
+
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <optional>
+#include <span>
 
 namespace morai
 {
@@ -11,9 +15,12 @@ struct SchedulerParams
 {
   /// Initial fibre queue size. This may grow (double) as required.
   uint32_t initial_queue_size = 1024u;
-  /// Size of the threadsafe move queue used for @c moveTo() operations. This is a fixed size queue
-  /// and fails move operations once full.
-  uint32_t move_queue_size = 1024u;
+  /// Resolution of the timing wheel used to park sleeping fibres (seconds). Sleeping fibres resume
+  /// no earlier than requested, but may resume up to this much later. See @c TimerWheel.
+  double timer_resolution_s = 1e-3;
+  /// Interval at which @c Scheduler::run() and @c Scheduler::runUntil() poll wait conditions while
+  /// every queued fibre is waiting on one (seconds). See @c Scheduler::nextDeadline().
+  double poll_interval_s = 1e-3;
   /// List of supported priority levels. One queue is created for each level at the
   /// @c initial_queue_size. The levels are sorted (ascending) before creating queues, but duplicate
   /// values yield undefined behaviour.
@@ -37,11 +44,38 @@ struct Time
   double dt = 0.0;
 };
 
+/// Limits the work done by a single @c Scheduler::update() call. The scheduler stops resuming
+/// fibres once either limit is reached, and continues from the same point on the next update.
+struct UpdateBudget
+{
+  /// Maximum number of fibres to resume. Unlimited by default.
+  std::size_t max_resumes = std::numeric_limits<std::size_t>::max();
+  /// Time limit measured from the @c Clock sample taken at the start of the update (seconds).
+  /// Checked after each resume, so at least one fibre is resumed. Unlimited by default.
+  double time_limit_s = std::numeric_limits<double>::infinity();
+};
+
+/// Reports the work done by a @c Scheduler::update() call.
+struct UpdateResult
+{
+  /// Number of fibres resumed.
+  std::size_t resumed = 0;
+  /// Number of queued fibres left unvisited because the @c UpdateBudget ran out. These include
+  /// cancelled entries not yet cleared from the queues.
+  std::size_t deferred = 0;
+};
+
+/// Inline storage capacity of a @c WaitCondition in bytes. Wait conditions capturing more than this
+/// fail to compile. Capture a pointer or @c std::shared_ptr to larger state instead.
+constexpr std::size_t WaitConditionCapacity = 48u;
+
 /// Function signature used for wait conditions - i.e., `co_await <condition>;` statements.
 /// See @c Fibre @c co_await handling.
 ///
+/// This is a move only, non-allocating callable - see @c InlineFunction.
+///
 /// @return True once the fibre may resume.
-using WaitCondition = std::function<bool()>;
+using WaitCondition = InlineFunction<bool(), WaitConditionCapacity>;
 
 class Fibre;
 
@@ -88,6 +122,19 @@ concept SchedulerType =
     { scheduler.move(fibre, priority) } -> std::same_as<bool>;
   };
 
+/// A @c SchedulerType which also accepts fibres in bulk via:
+///
+/// - `std::size_t move(std::span<Fibre> fibres);`
+///
+/// Fibres moving to the same scheduler during one update of their current scheduler are handed over
+/// with a single call - see @c MoveBatch. Their priorities are already assigned. The implementation
+/// must take every fibre, invalidating each, and return the number taken.
+template <typename Scheduler>
+concept BatchSchedulerType =
+  SchedulerType<Scheduler> && requires(Scheduler &scheduler, std::span<Fibre> fibres) {
+    { scheduler.move(fibres) } -> std::same_as<std::size_t>;
+  };
+
 /// Calculate the next power of two greater than or equal to the given @p value.
 constexpr uint8_t nextPowerOfTwo(uint8_t value)
 {
@@ -0,0 +1,181 @@
+#include "CompactQueue.hpp"
+
+#include <bit>
+#include <new>
+
+namespace morai
+{
+CompactQueue::CompactQueue(uint32_t capacity, uint32_t slot_size)
+{
+  const std::size_t slot_bytes = std::bit_ceil(std::max<std::size_t>(slot_size, sizeof(Slot)));
+  _slot_shift = static_cast<uint32_t>(std::countr_zero(slot_bytes));
+  _mask = std::bit_ceil(std::max<uint32_t>(capacity, 2u)) - 1;
+  // Slots are aligned to their size so padded slots start on a cache line boundary.
+  _slots = static_cast<std::byte *>(
+    ::operator new(this->capacity() * slot_bytes, std::align_val_t{ slot_bytes }));
+  for (uint64_t i = 0; i <= _mask; ++i)
+  {
+    Slot *item = new (_slots + (i << _slot_shift)) Slot{};
+    item->sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+CompactQueue::~CompactQueue()
+{
+  for (uint64_t i = 0; i <= _mask; ++i)
+  {
+    slot(i).~Slot();
+  }
+  ::operator delete(_slots, std::align_val_t{ slotSize() });
+}
+
+bool CompactQueue::tryPush(void *item) noexcept
+{
+  uint64_t head = _head.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    Slot &target = slot(head);
+    const uint64_t sequence = target.sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<int64_t>(sequence - head);
+    if (diff == 0)
+    {
+      if (_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed,
+                                      std::memory_order_relaxed))
+      {
+        target.item = item;
+        // Release publishes the item to consumers.
+        target.sequence.store(head + 1, std::memory_order_release);
+        return true;
+      }
+    }
+    else if (diff < 0)
+    {
+      // The slot still holds the item from the previous lap. Full.
+      return false;
+    }
+    else
+    {
+      // Another producer claimed the slot.
+      head = _head.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void *CompactQueue::tryPop() noexcept
+{
+  uint64_t tail = _tail.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    Slot &target = slot(tail);
+    const uint64_t sequence = target.sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<int64_t>(sequence - (tail + 1));
+    if (diff == 0)
+    {
+      if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed,
+                                      std::memory_order_relaxed))
+      {
+        void *item = target.item;
+        // Release returns the slot to producers for the next lap.
+        target.sequence.store(tail + _mask + 1, std::memory_order_release);
+        return item;
+      }
+    }
+    else if (diff < 0)
+    {
+      // Not yet pushed. Empty.
+      return nullptr;
+    }
+    else
+    {
+      // Another consumer claimed the slot.
+      tail = _tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+std::size_t CompactQueue::tryPushN(std::span<void *const> items) noexcept
+{
+  const std::size_t limit = std::min<std::size_t>(items.size(), capacity());
+  uint64_t head = _head.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    // Count the leading free slots. These cannot change until claimed by moving the head.
+    std::size_t ready = 0;
+    int64_t diff = 0;
+    for (; ready < limit; ++ready)
+    {
+      const uint64_t index = head + ready;
+      diff = static_cast<int64_t>(slot(index).sequence.load(std::memory_order_acquire) - index);
+      if (diff != 0)
+      {
+        break;
+      }
+    }
+
+    if (ready == 0)
+    {
+      if (diff < 0 || limit == 0)
+      {
+        return 0;
+      }
+      head = _head.load(std::memory_order_relaxed);
+      continue;
+    }
+
+    if (_head.compare_exchange_weak(head, head + ready, std::memory_order_relaxed,
+                                    std::memory_order_relaxed))
+    {
+      for (std::size_t i = 0; i < ready; ++i)
+      {
+        Slot &target = slot(head + i);
+        target.item = items[i];
+        target.sequence.store(head + i + 1, std::memory_order_release);
+      }
+      return ready;
+    }
+  }
+}
+
+std::size_t CompactQueue::tryPopN(std::span<void *> items) noexcept
+{
+  const std::size_t limit = std::min<std::size_t>(items.size(), capacity());
+  uint64_t tail = _tail.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    // Count the leading ready slots. These cannot change until claimed by moving the tail.
+    std::size_t ready = 0;
+    int64_t diff = 0;
+    for (; ready < limit; ++ready)
+    {
+      const uint64_t index = tail + ready;
+      diff = static_cast<int64_t>(slot(index).sequence.load(std::memory_order_acquire) - index - 1);
+      if (diff != 0)
+      {
+        break;
+      }
+    }
+
+    if (ready == 0)
+    {
+      if (diff < 0 || limit == 0)
+      {
+        return 0;
+      }
+      tail = _tail.load(std::memory_order_relaxed);
+      continue;
+    }
+
+    if (_tail.compare_exchange_weak(tail, tail + ready, std::memory_order_relaxed,
+                                    std::memory_order_relaxed))
+    {
+      for (std::size_t i = 0; i < ready; ++i)
+      {
+        Slot &target = slot(tail + i);
+        items[i] = target.item;
+        target.sequence.store(tail + i + _mask + 1, std::memory_order_release);
+      }
+      return ready;
+    }
+  }
+}
+}  // namespace morai
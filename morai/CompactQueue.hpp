@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace morai
+{
+/// A bounded, lock free, multi-producer, multi-consumer queue of pointers.
+///
+/// This is the compact alternative to @c rigtorp::MPMCQueue used by @c SharedQueue - see
+/// @c SharedQueueLayout. The capacity is a power of two so slot indices and laps are masks rather
+/// than divisions. Slots are packed densely by default - 16 bytes each - and may be padded to trade
+/// memory for less false sharing between adjacent slots. Items are pushed and popped in FIFO order.
+///
+/// @c tryPushN() and @c tryPopN() transfer a run of items with a single claim on the head or tail.
+///
+/// @par Implementation
+///
+/// Follows Dmitry Vyukov's bounded MPMC queue. Each slot holds a sequence number giving the index
+/// it next accepts a push for (sequence == index) or a pop for (sequence == index + 1).
+class CompactQueue
+{
+public:
+  /// Create a queue holding at least @p capacity items, rounded up to a power of two.
+  /// @param capacity The minimum capacity.
+  /// @param slot_size Bytes per slot, rounded up to a power of two no smaller than the natural
+  /// slot size. Zero packs slots densely. Use the cache line size or more to give each slot its own
+  /// cache line.
+  explicit CompactQueue(uint32_t capacity, uint32_t slot_size = 0);
+  /// Destructor. Remaining items are not owned by the queue and are discarded.
+  ~CompactQueue();
+
+  CompactQueue(const CompactQueue &) = delete;
+  CompactQueue(CompactQueue &&) = delete;
+  CompactQueue &operator=(const CompactQueue &) = delete;
+  CompactQueue &operator=(CompactQueue &&) = delete;
+
+  /// Get the queue capacity.
+  [[nodiscard]] std::size_t capacity() const noexcept { return _mask + 1; }
+  /// Get the bytes used per slot.
+  [[nodiscard]] std::size_t slotSize() const noexcept { return std::size_t{ 1 } << _slot_shift; }
+
+  /// Estimate the number of items in the queue (threadsafe).
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    const uint64_t head = _head.load(std::memory_order_relaxed);
+    const uint64_t tail = _tail.load(std::memory_order_relaxed);
+    return static_cast<std::size_t>(std::max<int64_t>(static_cast<int64_t>(head - tail), 0));
+  }
+  /// Check if the queue is empty. This may be inaccurate as other threads may modify the queue.
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  /// Try push an @p item (threadsafe).
+  /// @param item The item to push. Must not be null.
+  /// @return True on success, false when full.
+  [[nodiscard]] bool tryPush(void *item) noexcept;
+
+  /// Try pop the oldest item (threadsafe).
+  /// @return The item, or null when empty.
+  [[nodiscard]] void *tryPop() noexcept;
+
+  /// Try push the leading @p items with a single claim (threadsafe). Pushes as many as there are
+  /// free slots for.
+  /// @param items The items to push in order. Must not be null.
+  /// @return The number of items pushed.
+  [[nodiscard]] std::size_t tryPushN(std::span<void *const> items) noexcept;
+
+  /// Try pop up to @c items.size() of the oldest items with a single claim (threadsafe). Only the
+  /// leading items which are ready are popped.
+  /// @param items Receives the items in queue order.
+  /// @return The number of items popped.
+  [[nodiscard]] std::size_t tryPopN(std::span<void *> items) noexcept;
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence{ 0 };
+    void *item = nullptr;
+  };
+
+  [[nodiscard]] Slot &slot(uint64_t index) const noexcept
+  {
+    return *reinterpret_cast<Slot *>(_slots + ((index & _mask) << _slot_shift));
+  }
+
+  /// Slot storage. Each slot occupies `1 << _slot_shift` bytes.
+  std::byte *_slots = nullptr;
+  uint64_t _mask = 0;
+  uint32_t _slot_shift = 0;
+  /// Push index.
+  alignas(64) std::atomic<uint64_t> _head{ 0 };
+  /// Pop index.
+  alignas(64) std::atomic<uint64_t> _tail{ 0 };
+};
+}  // namespace morai
@@ -0,0 +1,169 @@
+#include "Event.hpp"
+
+#include "Log.hpp"
+
+#include <format>
+#include <utility>
+
+namespace morai
+{
+Event::Event(EventReset reset, bool initially_set) noexcept
+  : _set(initially_set)
+  , _reset(reset)
+{}
+
+Event::~Event()
+{
+  void *head = nullptr;
+  {
+    const std::scoped_lock guard(_mutex);
+    head = std::exchange(_head, nullptr);
+    _tail = nullptr;
+    _waiter_count = 0;
+  }
+
+  // Parked waiters are still counted by their schedulers. Wake them flagged for cancellation so
+  // their schedulers clean them up.
+  while (head)
+  {
+    Handle handle = Handle::from_address(head);
+    head = std::exchange(handle.promise().frame.link, nullptr);
+    handle.promise().frame.id.markForCancellation();
+    wake(handle);
+  }
+}
+
+std::size_t Event::waiterCount() const
+{
+  const std::scoped_lock guard(_mutex);
+  return _waiter_count;
+}
+
+void Event::set()
+{
+  void *head = nullptr;
+  {
+    const std::scoped_lock guard(_mutex);
+    if (_reset == EventReset::Manual)
+    {
+      _set.store(true, std::memory_order_release);
+      head = std::exchange(_head, nullptr);
+      _tail = nullptr;
+      _waiter_count = 0;
+    }
+    else if (_head)
+    {
+      // Pass the signal directly to the first waiter.
+      head = _head;
+      Handle handle = Handle::from_address(_head);
+      _head = std::exchange(handle.promise().frame.link, nullptr);
+      _tail = (_head) ? _tail : nullptr;
+      --_waiter_count;
+    }
+    else
+    {
+      _set.store(true, std::memory_order_release);
+    }
+  }
+
+  // Wake outside the lock.
+  while (head)
+  {
+    Handle handle = Handle::from_address(head);
+    head = std::exchange(handle.promise().frame.link, nullptr);
+    wake(handle);
+  }
+}
+
+Fibre::ParkAwaitable Event::parkAwaitable()
+{
+  return { .parker = { .park = &Event::park, .context = this }, .try_ready = &Event::tryReady };
+}
+
+bool Event::tryReady(void *event) noexcept
+{
+  return static_cast<Event *>(event)->tryConsume();
+}
+
+bool Event::park(void *event_ptr, Fibre &fibre)
+{
+  auto &event = *static_cast<Event *>(event_ptr);
+  Handle handle = fibre.__handle();
+  if (!handle.promise().frame.home) [[unlikely]]
+  {
+    log::error(std::format("Event: fibre {}:{} has no scheduler to wake into", fibre.id().id(),
+                           fibre.name()));
+    return false;
+  }
+
+  const Id id = fibre.id();
+  detail::IdTable::setParked(id, { .unpark = &Event::unpark, .context = &event });
+  std::unique_lock guard(event._mutex);
+  // Check again under lock - we may have been signalled since co_await. Also decline once marked
+  // for cancellation as a Scope may have failed to find us to unpark.
+  if (id.cancelled() || event.tryConsume())
+  {
+    guard.unlock();
+    detail::IdTable::clearParked(id);
+    return false;
+  }
+
+  handle = fibre.__release();
+  if (event._tail)
+  {
+    Handle::from_address(event._tail).promise().frame.link = handle.address();
+  }
+  else
+  {
+    event._head = handle.address();
+  }
+  event._tail = handle.address();
+  ++event._waiter_count;
+  return true;
+}
+
+bool Event::tryConsume() noexcept
+{
+  if (_reset == EventReset::Manual)
+  {
+    return _set.load(std::memory_order_acquire);
+  }
+  bool expected = true;
+  return _set.compare_exchange_strong(expected, false, std::memory_order_acq_rel);
+}
+
+void *Event::unpark(void *event_ptr, const Id &id)
+{
+  auto &event = *static_cast<Event *>(event_ptr);
+  const std::scoped_lock guard(event._mutex);
+  void *previous = nullptr;
+  for (void *waiter = event._head; waiter;)
+  {
+    detail::Frame &frame = Handle::from_address(waiter).promise().frame;
+    if (frame.id == id)
+    {
+      void *next = std::exchange(frame.link, nullptr);
+      if (previous)
+      {
+        Handle::from_address(previous).promise().frame.link = next;
+      }
+      else
+      {
+        event._head = next;
+      }
+      event._tail = (event._tail == waiter) ? previous : event._tail;
+      --event._waiter_count;
+      return waiter;
+    }
+    previous = waiter;
+    waiter = frame.link;
+  }
+  return nullptr;
+}
+
+void Event::wake(Handle handle)
+{
+  detail::IdTable::clearParked(handle.promise().frame.id);
+  handle.promise().frame.home->wake(Fibre{ handle });
+}
+}  // namespace morai
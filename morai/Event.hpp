@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Fibre.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace morai
+{
+/// @c Event reset behaviour.
+enum class EventReset : uint8_t
+{
+  /// The event stays set until explicitly @c Event::reset(). Setting the event wakes all waiters.
+  Manual,
+  /// Setting the event wakes a single waiter and the signal is consumed. The event remains set only
+  /// if there are no waiters.
+  Auto,
+};
+
+/// A signal which fibres may @c co_await without polling.
+///
+/// Awaiting an event which is not set parks the fibre: ownership of the fibre passes to the event
+/// and the fibre is linked into an intrusive FIFO waiter list through its coroutine frame. Parked
+/// fibres are not visited by their scheduler at all, so waiting costs nothing per update. On
+/// @c set() the woken fibres are handed back to their owning scheduler - see @c detail::Home - and
+/// resume on its next update.
+///
+/// @code
+/// morai::Event ready;
+/// scheduler.start([](morai::Event &ready) -> morai::Fibre {
+///   co_await ready;  // Parks until ready.set()
+///   std::cout << "Ready\n";
+/// }(ready));
+/// // ...
+/// ready.set();
+/// @endcode
+///
+/// @c set() and @c reset() are threadsafe and may be called from any thread or fibre. Waiters may
+/// belong to different schedulers.
+///
+/// A parked fibre is not owned by its scheduler: @c Scheduler::cancel() will not find it, but
+/// @c Id::markForCancellation() is honoured once the fibre is woken. A cancelled @c Scope detaches
+/// its parked children - see @c detail::Unparker. Destroying an event with parked waiters marks the
+/// waiters for cancellation and wakes them. Waiters whose scheduler has been destroyed are
+/// destroyed when woken.
+class Event
+{
+public:
+  /// Create an event.
+  /// @param reset The reset behaviour.
+  /// @param initially_set Create the event in the set state?
+  explicit Event(EventReset reset = EventReset::Manual, bool initially_set = false) noexcept;
+  /// Destructor - cancels and wakes any parked waiters.
+  ~Event();
+
+  Event(const Event &) = delete;
+  Event(Event &&) = delete;
+  Event &operator=(const Event &) = delete;
+  Event &operator=(Event &&) = delete;
+
+  /// Get the reset behaviour.
+  [[nodiscard]] EventReset resetMode() const noexcept { return _reset; }
+
+  /// Check if the event is currently set.
+  [[nodiscard]] bool isSet() const noexcept { return _set.load(std::memory_order_acquire); }
+
+  /// Returns the number of parked waiters.
+  [[nodiscard]] std::size_t waiterCount() const;
+
+  /// Set the event, waking waiters according to the @c resetMode().
+  void set();
+
+  /// Clear the event. Subsequent waiters park until the next @c set().
+  void reset() noexcept { _set.store(false, std::memory_order_release); }
+
+  /// Create the awaitable for `co_await event;`. Awaiting it consumes the signal for
+  /// @c EventReset::Auto events when already set, but creating it consumes nothing. For internal
+  /// use by @c Fibre::promise_type.
+  [[nodiscard]] Fibre::ParkAwaitable parkAwaitable();
+
+private:
+  using Handle = std::coroutine_handle<Fibre::promise_type>;
+
+  /// @c detail::Parker implementation.
+  static bool park(void *event, Fibre &fibre);
+  /// @c detail::Unparker implementation.
+  static void *unpark(void *event, const Id &id);
+  /// @c Fibre::ParkAwaitable::try_ready implementation. Consumes an @c EventReset::Auto signal.
+  static bool tryReady(void *event) noexcept;
+  /// Test the signal, consuming it for @c EventReset::Auto events.
+  [[nodiscard]] bool tryConsume() noexcept;
+  /// Clear the parked state of a woken fibre and hand it back to its scheduler.
+  static void wake(Handle handle);
+
+  mutable std::mutex _mutex;
+  /// Waiter list head - coroutine frame address linked via @c detail::Frame::link.
+  void *_head = nullptr;
+  /// Waiter list tail.
+  void *_tail = nullptr;
+  std::size_t _waiter_count = 0;
+  std::atomic_bool _set{ false };
+  EventReset _reset = EventReset::Manual;
+};
+}  // namespace morai
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace morai
+{
+/// An event count used to park idle threads until new work is published.
+///
+/// Waiting is a two phase operation which avoids lost wake ups:
+///
+/// @code
+/// for (;;)
+/// {
+///   if (tryWork()) continue;
+///   const auto key = event_count.prepareWait();
+///   if (tryWork()) { event_count.cancelWait(); continue; }
+///   event_count.wait(key);
+/// }
+/// @endcode
+///
+/// Publishers make work visible then call @c notifyOne() or @c notifyAll(). Notification is cheap
+/// when there are no waiters: a fence and a load. Waiting blocks using @c std::atomic::wait(),
+/// which is a futex on supported platforms.
+class EventCount
+{
+public:
+  /// Key identifying the notification epoch observed by @c prepareWait().
+  using Key = uint32_t;
+
+  /// Register the calling thread as a waiter. Must be followed by either @c cancelWait() or
+  /// @c wait(). Work must be rechecked between the two.
+  /// @return The key to pass to @c wait().
+  [[nodiscard]] Key prepareWait() noexcept
+  {
+    _waiters.fetch_add(1, std::memory_order_relaxed);
+    // Order the waiter registration before rechecking for work. Pairs with the fence in notify.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return _epoch.load(std::memory_order_relaxed);
+  }
+
+  /// Deregister the calling thread after @c prepareWait() when it found work.
+  void cancelWait() noexcept { _waiters.fetch_sub(1, std::memory_order_seq_cst); }
+
+  /// Block until notified after @c prepareWait() returned @p key. Returns immediately if there has
+  /// been a notification since.
+  void wait(Key key) noexcept
+  {
+    _epoch.wait(key, std::memory_order_acquire);
+    _waiters.fetch_sub(1, std::memory_order_seq_cst);
+  }
+
+  /// Wake one waiting thread, if any.
+  void notifyOne() noexcept
+  {
+    if (anyWaiters())
+    {
+      _epoch.fetch_add(1, std::memory_order_release);
+      _epoch.notify_one();
+    }
+  }
+
+  /// Wake all waiting threads.
+  void notifyAll() noexcept
+  {
+    if (anyWaiters())
+    {
+      _epoch.fetch_add(1, std::memory_order_release);
+      _epoch.notify_all();
+    }
+  }
+
+  /// Check if there are any threads waiting or preparing to wait. A hint only.
+  [[nodiscard]] bool waiting() const noexcept
+  {
+    return _waiters.load(std::memory_order_relaxed) != 0;
+  }
+
+  /// Get the number of threads waiting or preparing to wait. Sequentially consistent with the
+  /// deregistration in @c wait() and @c cancelWait().
+  [[nodiscard]] uint32_t waiters() const noexcept
+  {
+    return _waiters.load(std::memory_order_seq_cst);
+  }
+
+private:
+  [[nodiscard]] bool anyWaiters() noexcept
+  {
+    // Order publishing work before checking for waiters. Pairs with the fence in prepareWait().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return _waiters.load(std::memory_order_relaxed) != 0;
+  }
+
+  std::atomic<Key> _epoch{ 0 };
+  std::atomic<uint32_t> _waiters{ 0 };
+};
+}  // namespace morai
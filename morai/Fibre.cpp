@@ -1,10 +1,42 @@
 #include "Fibre.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
 namespace morai
 {
+void detail::Home::wake(Fibre &&fibre) noexcept
+{
+  if (_state.fetch_add(WakeIncrement, std::memory_order_acquire) & ClosedBit)
+  {
+    _state.fetch_sub(WakeIncrement, std::memory_order_relaxed);
+    // The scheduler is gone. Destroy the fibre while still holding its reference as destruction may
+    // wake joiners back into this home.
+    Fibre discard = std::move(fibre);
+  }
+  else
+  {
+    _wake(_context, std::move(fibre));
+    _state.fetch_sub(WakeIncrement, std::memory_order_release);
+  }
+  release();
+}
+
+void detail::Home::close() noexcept
+{
+  uint32_t state = _state.fetch_or(ClosedBit, std::memory_order_acq_rel);
+  // Wait out wakes which saw the home open. These only push into the scheduler inbox, so are brief.
+  while (state >= WakeIncrement)
+  {
+    std::this_thread::yield();
+    state = _state.load(std::memory_order_acquire);
+  }
+}
+
 void Fibre::Awaitable::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
 {
-  handle.promise().frame.resumption = resumption;
+  handle.promise().frame.setResumption(std::move(resumption));
 }
 
 void Fibre::FibreIdAwaitable::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
@@ -12,21 +44,99 @@ void Fibre::FibreIdAwaitable::await_suspend(std::coroutine_handle<promise_type>
   auto &promise = handle.promise();
   if (promise.frame.id != id)
   {
-    promise.frame.resumption = wait([id = id]() { return !id.running(); });
+    promise.frame.cold().parker = { .park = &FibreIdAwaitable::park, .context = this };
+    promise.frame.flags |= detail::Frame::ParkPendingBit;
   }
   else
   {
     // Self await. Set no condition, just a yield.
-    promise.frame.resumption = yield();
+    promise.frame.setResumption(yield());
   }
 }
 
-void Fibre::RescheduleAwaitable::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+bool Fibre::FibreIdAwaitable::park(void *awaitable, Fibre &fibre)
 {
-  handle.promise().frame.reschedule = value;
+  const Id id = static_cast<const FibreIdAwaitable *>(awaitable)->id;
+  auto &promise = fibre.__handle().promise();
+  if (!promise.frame.home) [[unlikely]]
+  {
+    // No scheduler to wake into. Fall back to polling.
+    promise.frame.setResumption(wait([id]() { return !id.running(); }));
+    return false;
+  }
+
+  // The awaitable lives in the suspended coroutine frame, so remains valid while parked.
+  const Id joiner = fibre.id();
+  detail::IdTable::setParked(joiner, { .unpark = &FibreIdAwaitable::unpark, .context = awaitable });
+  detail::IdSlot *slot = detail::IdTable::lockRunning(id);
+  // Decline once marked for cancellation as a Scope may have failed to find us to unpark.
+  if (!slot || joiner.cancelled())
+  {
+    // Already complete or cancelled.
+    if (slot)
+    {
+      detail::IdTable::unlock(slot);
+    }
+    detail::IdTable::clearParked(joiner);
+    return false;
+  }
+
+  const std::coroutine_handle<promise_type> handle = fibre.__release();
+  handle.promise().frame.link = slot->joiners;
+  slot->joiners = handle.address();
+  detail::IdTable::unlock(slot);
+  return true;
 }
 
-std::atomic<IdValueType> Fibre::_next_id{ 0 };
+void *Fibre::FibreIdAwaitable::unpark(void *awaitable, const Id &joiner)
+{
+  const Id id = static_cast<const FibreIdAwaitable *>(awaitable)->id;
+  detail::IdSlot *slot = detail::IdTable::lockRunning(id);
+  if (!slot)
+  {
+    // The target completed. Its joiners are being woken.
+    return nullptr;
+  }
+
+  void *found = nullptr;
+  for (void **link = &slot->joiners; *link;
+       link = &std::coroutine_handle<promise_type>::from_address(*link).promise().frame.link)
+  {
+    detail::Frame &frame = std::coroutine_handle<promise_type>::from_address(*link).promise().frame;
+    if (frame.id == joiner)
+    {
+      found = std::exchange(*link, std::exchange(frame.link, nullptr));
+      break;
+    }
+  }
+  detail::IdTable::unlock(slot);
+  return found;
+}
+
+void Fibre::promise_type::wakeJoiners(void *joiners) noexcept
+{
+  while (joiners)
+  {
+    const auto handle = std::coroutine_handle<promise_type>::from_address(joiners);
+    joiners = std::exchange(handle.promise().frame.link, nullptr);
+    detail::IdTable::clearParked(handle.promise().frame.id);
+    handle.promise().frame.home->wake(Fibre{ handle });
+  }
+}
+
+void Fibre::ParkAwaitable::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+{
+  detail::Frame &frame = handle.promise().frame;
+  frame.cold().parker = parker;
+  frame.flags |= detail::Frame::ParkPendingBit;
+}
+
+void Fibre::RescheduleAwaitable::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+{
+  detail::Frame &frame = handle.promise().frame;
+  frame.cold().reschedule = value;
+  frame.flags |= detail::Frame::ReschedulePendingBit;
+}
 
 Fibre::~Fibre()
 {
@@ -37,34 +147,43 @@ Fibre::~Fibre()
   }
 }
 
-[[nodiscard]] Resume Fibre::resume(const double epoch_time_s) noexcept
+[[nodiscard]] Resume Fibre::resume(const uint64_t tick, const double tick_period_s) noexcept
 {
-  auto &promise = _handle.promise();
-  const Resumption &resumption = promise.frame.resumption;
-  if (done() || promise.frame.id.cancelled())
+  detail::Frame &frame = _handle.promise().frame;
+  if (done() || frame.id.cancelled())
   {
     return { .mode = ResumeMode::Expire };
   }
 
-  if (resumption.condition)
+  if (frame.condition)
   {
-    if (!resumption.condition() && (resumption.time_s <= 0 || epoch_time_s < resumption.time_s))
+    if (!frame.condition() && (frame.deadline == 0 || tick < frame.deadline))
     {
       return { .mode = ResumeMode::Sleep };
     }
+    frame.condition = nullptr;
   }
-  else if (epoch_time_s < resumption.time_s)
+  else if (tick < frame.deadline)
   {
     return { .mode = ResumeMode::Sleep };
   }
 
-  // Resume will set promise.frame.resumption again so long as we haven't expired.
+  // Resume will set the resumption again so long as we haven't expired.
   // Only resume if we are not waiting on a move.
-  promise.frame.resumption = {};
-  if (!promise.frame.move_operation)
+  frame.deadline = 0;
+  if (!(frame.flags & detail::Frame::MovePendingBit))
   {
-    _handle.resume();
-    if (promise.frame.exception)
+    // Resume the innermost suspended Task when there is one. It transfers back up to the fibre
+    // coroutine on completion.
+    if (frame.leaf)
+    {
+      frame.leaf.resume();
+    }
+    else
+    {
+      _handle.resume();
+    }
+    if (frame.flags & detail::Frame::ExceptionBit)
     {
       return { .mode = ResumeMode::Exception };
     }
@@ -73,33 +192,53 @@ Fibre::~Fibre()
     {
       return { .mode = ResumeMode::Expire };
     }
-  }
 
-  // Check for move. This may may move a fibre immediately after it's last update - i.e.,
-  // immediately after the co_await moveTo() statement. On failure, the fibre will remain with the
-  // current scheduler. We must not update it, so the move_operation check around _handle.resume()
-  // prevents update from the wrong scheduler.
-  if (promise.frame.move_operation)
-  {
-    auto move_op = std::exchange(promise.frame.move_operation, {});
-    // Note: the move operation will invalidate this object on success as it's content is moved
-    // away. On failure the content is moved back here.
-    if (move_op(*this))
+    // Hand the fibre over to a waitable object. This must happen after the coroutine has fully
+    // suspended as another thread may wake the fibre as soon as it is parked.
+    if (frame.flags & detail::Frame::ParkPendingBit)
     {
-      return { ResumeMode::Moved };
+      frame.flags &= static_cast<uint8_t>(~detail::Frame::ParkPendingBit);
+      const detail::Parker parker = std::exchange(frame.cold_state->parker, {});
+      // A parked fibre keeps its home alive, so it may be woken after its scheduler is destroyed.
+      // Retain first as the frame is not ours once parked.
+      detail::Home *home = frame.home;
+      if (home)
+      {
+        home->retain();
+      }
+      if (parker.park(parker.context, *this))
+      {
+        return { .mode = ResumeMode::Parked };
+      }
+      if (home)
+      {
+        home->release();
+      }
+      // Declined - the waitable was signalled in the meantime. Resume next update.
     }
-    // Move failed. Target queue may be full. Return ownership to this object and try again next
-    // update.
-    std::swap(promise.frame.move_operation, move_op);
-    return { .mode = ResumeMode::Continue };
   }
 
-  // Add the epoch time to the resumption value to set the correct resume time.
-  if (promise.frame.resumption.time_s > 0)
+  // Check for move. The fibre has suspended immediately after the co_await moveTo() statement. The
+  // scheduler performs the move, possibly batched with other fibres moving to the same target. If
+  // the move fails, the fibre remains with the current scheduler and is not resumed until it moves.
+  if (frame.flags & detail::Frame::MovePendingBit)
+  {
+    return { .mode = ResumeMode::Move };
+  }
+
+  // Convert the relative resumption duration into an absolute deadline tick. Round up so the fibre
+  // sleeps for at least the requested duration.
+  if (frame.deadline > 0)
+  {
+    const auto tick_ns = static_cast<uint64_t>(std::max(std::llround(tick_period_s * 1e9), 1ll));
+    frame.deadline = tick + (frame.deadline + tick_ns - 1) / tick_ns;
+  }
+  if (frame.flags & detail::Frame::ReschedulePendingBit)
   {
-    promise.frame.resumption.time_s += epoch_time_s;
+    frame.flags &= static_cast<uint8_t>(~detail::Frame::ReschedulePendingBit);
+    return { .mode = ResumeMode::Continue,
+             .reschedule = std::exchange(frame.cold().reschedule, std::nullopt) };
   }
-  return { .mode = ResumeMode::Continue,
-           .reschedule = std::exchange(promise.frame.reschedule, std::nullopt) };
+  return { .mode = ResumeMode::Continue };
 }
 }  // namespace morai
@@ -2,13 +2,19 @@
 
 #include "Id.hpp"
 #include "Common.hpp"
+#include "FrameAllocator.hpp"
 #include "Move.hpp"
 #include "Resumption.hpp"
 
 #include <atomic>
 #include <coroutine>
+#include <cstddef>
 #include <exception>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <span>
+#include <string>
 #include <utility>
 
 namespace morai
@@ -17,25 +23,188 @@ class Fibre;
 
 namespace detail
 {
-/// Internal fibre data - stored in the @c Fibre::promise_type.
-struct Frame
+/// Identifies the scheduler which owns a fibre, so that parked fibres can be handed back to it.
+/// Set by the scheduler whenever it takes ownership of a fibre.
+///
+/// Reference counted as parked fibres may be woken after their scheduler is destroyed. The
+/// scheduler holds one reference and each parked fibre holds another until woken. The scheduler
+/// @c close()s its home on destruction, after which woken fibres are destroyed rather than handed
+/// back.
+class Home
+{
+public:
+  /// Function used to return a woken @p fibre to the scheduler @p context. Must be threadsafe.
+  using WakeFunction = void (*)(void *context, Fibre &&fibre);
+
+  /// Create a home with a single reference, owned by the caller.
+  Home(WakeFunction wake, void *context) noexcept
+    : _wake(wake)
+    , _context(context)
+  {}
+
+  Home(const Home &) = delete;
+  Home(Home &&) = delete;
+  Home &operator=(const Home &) = delete;
+  Home &operator=(Home &&) = delete;
+
+  /// Add a reference. Taken by a fibre before it parks.
+  void retain() noexcept { _references.fetch_add(1, std::memory_order_relaxed); }
+  /// Release a reference, deleting the home when it was the last.
+  void release() noexcept
+  {
+    if (_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      delete this;
+    }
+  }
+
+  /// Return a woken parked @p fibre to the scheduler and release the reference the fibre held. The
+  /// @p fibre is destroyed instead if the home has been closed. Threadsafe.
+  void wake(Fibre &&fibre) noexcept;
+
+  /// Close the home as the scheduler is destroyed. Blocks until any concurrent @c wake() has
+  /// finished handing its fibre to the scheduler. Later wakes destroy their fibre.
+  void close() noexcept;
+
+private:
+  /// @c _state bit set once closed.
+  static constexpr uint32_t ClosedBit = 1u;
+  /// @c _state increment for each @c wake() in progress.
+  static constexpr uint32_t WakeIncrement = 2u;
+
+  WakeFunction _wake;
+  void *_context;
+  std::atomic_uint32_t _references{ 1 };
+  /// The @c ClosedBit plus a count of wakes in progress, in @c WakeIncrement units.
+  std::atomic_uint32_t _state{ 0 };
+};
+
+/// A pending handoff of a suspended fibre to a waitable object such as an @c Event. Set by an
+/// awaitable on suspension and invoked by @c Fibre::resume() once the coroutine has fully
+/// suspended.
+struct Parker
+{
+  /// Attempt to take ownership of the @p fibre. On success the @p fibre must be released via
+  /// @c Fibre::__release() and true returned. Returning false leaves the fibre with its scheduler.
+  bool (*park)(void *context, Fibre &fibre) = nullptr;
+  /// Waitable object context for @c park().
+  void *context = nullptr;
+};
+
+/// A pending move to another scheduler. Set by @c co_await @c moveTo() and performed by the current
+/// scheduler once the fibre has suspended - see @c ResumeMode::Move and @c MoveBatch.
+struct MoveRequest
+{
+  /// Move the leading @p fibres to the scheduler @p target. All the @p fibres must have requested a
+  /// move to the same @p target via the same function. Moved fibres are invalidated and their
+  /// requests cleared. The remaining fibres stay valid, keeping their requests.
+  /// @return The number of fibres moved.
+  std::size_t (*move)(void *target, std::span<Fibre> fibres) = nullptr;
+  /// The target scheduler for @c move().
+  void *target = nullptr;
+  /// Priority to assign on the target. Preserves the current priority when empty.
+  std::optional<int32_t> priority{};
+};
+
+/// Notifies an observer when a fibre is destroyed, whether completed or cancelled - e.g., @c Scope.
+struct Completion
+{
+  /// Invoked from the fibre promise destructor after the fibre @c Id stops running.
+  void (*notify)(void *context) noexcept = nullptr;
+  /// Observer context for @c notify().
+  void *context = nullptr;
+};
+
+/// Rarely used fibre data. Allocated on first use - see @c Frame::cold().
+///
+/// Pending parks and moves live here rather than inline. The block is allocated once and reused for
+/// the life of the fibre, so fibres which park or move every frame allocate only on the first.
+struct ColdFrame
 {
-  /// Indicates when next to resume the fibre - see @c Resumption. Note the time value is
-  /// initially given as a relative time, but stored as an epoch time.
-  Resumption resumption{};
+  /// Optional fibre name - debug info only.
+  std::string name;
+  std::exception_ptr exception{};  ///< Exception storage.
   /// Set to a new target priority when priority rescheduling is requested.
   std::optional<Priority> reschedule{};
-  std::exception_ptr exception{};  ///< Exception storage.
-  /// Unique Id of this fibre.
-  Id id{};
+  /// Pending park operation. See @c Parker.
+  Parker parker{};
+  /// Pending move to another scheduler. See @c MoveRequest.
+  MoveRequest move{};
+  /// Completion observer. See @c Completion.
+  Completion completion{};
+};
+
+/// Internal fibre data - stored in the @c Fibre::promise_type.
+///
+/// Fields touched on every resume are packed at the front: the deadline, priority and flags in the
+/// first 16 bytes, followed by the @c Id, @c Task leaf and the wait condition, whose empty check
+/// reads only its leading ops pointer. Rarely used data lives in a lazily allocated @c ColdFrame,
+/// with @c flags marking pending cold state so that resuming a fibre does not touch the cold block
+/// unless there is something to do.
+struct Frame
+{
+  /// @c flags bit: a priority change is pending in @c ColdFrame::reschedule.
+  static constexpr uint8_t ReschedulePendingBit = 1u;
+  /// @c flags bit: an exception has been stored in @c ColdFrame::exception.
+  static constexpr uint8_t ExceptionBit = 2u;
+  /// @c flags bit: a park operation is pending in @c ColdFrame::parker.
+  static constexpr uint8_t ParkPendingBit = 4u;
+  /// @c flags bit: a move is pending in @c ColdFrame::move.
+  static constexpr uint8_t MovePendingBit = 8u;
+  /// @c flags bit: a completion observer is set in @c ColdFrame::completion.
+  static constexpr uint8_t CompletionBit = 16u;
+
+  /// Resumption deadline, zero for none - see @c Resumption::deadline. Initially given as a
+  /// relative duration, but stored as an absolute @c Clock::tick() once the fibre suspends.
+  uint64_t deadline = 0;
   /// Current fibre priority.
   int32_t priority = 0;
-  /// Optional fibre name - debug info only.
-  std::string name;
-  /// Set when a request to move to another scheduler is made. See @c moveTo(). Cleared after the
-  /// moved.
-  std::function<bool(Fibre &)> move_operation{};
+  /// Pending cold state bits. See @c ReschedulePendingBit etc.
+  uint8_t flags = 0;
+  /// Unique Id of this fibre.
+  Id id{};
+  /// The innermost suspended child @c Task, if any. Resumed in place of the fibre coroutine.
+  std::coroutine_handle<> leaf{};
+  /// Optional condition to wait on before resuming - see @c Resumption::condition.
+  WaitCondition condition{};
+  /// The scheduler which owns this fibre. Parked fibres are returned here when woken. Null until
+  /// first scheduled.
+  Home *home = nullptr;
+  /// Intrusive list link used while parked or being woken. Holds the next coroutine frame address.
+  void *link = nullptr;
+  /// Cold data block. Null until first used.
+  std::unique_ptr<ColdFrame> cold_state{};
+  /// The @c Clock::tick() at which the fibre was last queued. Only maintained by schedulers which
+  /// track wait times - see @c ThreadPoolParams::wait_statistics. Fills the tail padding left by
+  /// the wait condition alignment.
+  uint64_t queued_tick = 0;
+
+  /// Get the cold data block, allocating on first use.
+  ColdFrame &cold()
+  {
+    if (!cold_state)
+    {
+      cold_state = std::make_unique<ColdFrame>();
+    }
+    return *cold_state;
+  }
+
+  /// Set the pending @p resumption. The deadline remains relative until @c Fibre::resume() returns.
+  void setResumption(Resumption &&resumption) noexcept
+  {
+    deadline = resumption.deadline;
+    condition = std::move(resumption.condition);
+  }
 };
+
+// A resume which neither polls a condition nor has pending cold state reads only the first cache
+// line of the frame state.
+static_assert(offsetof(Frame, deadline) == 0 && offsetof(Frame, priority) < 16 &&
+                offsetof(Frame, flags) < 16,
+              "Frame deadline, priority and flags must lead the frame state");
+static_assert(offsetof(Frame, condition) + sizeof(void *) <= 64,
+              "Frame wait condition ops must lie in the first cache line");
+static_assert(sizeof(void *) != 8 || sizeof(Frame) <= 128, "Frame state has grown");
 }  // namespace detail
 
 /// The @c Fibre implements a coroutine interface for the fibre system. It tracks the current fibre
@@ -66,6 +235,7 @@ struct Frame
 /// - `co_await <Id>;` - resume after the fibre with the given @c Id is no longer running.
 /// - `co_await moveTo(scheduler[, priority]);` - move the fibre to another scheduler, optionally
 ///   at a new priority.
+/// - `co_await <Task>;` - run a child @c Task inline, resuming with its result.
 /// - `co_return;` - end fibre execution.
 class Fibre
 {
@@ -80,23 +250,32 @@ public:
     Resumption resumption;
     /// Check if the fibre can immediately continue (true) or fibre needs to suspend (false).
     bool await_ready() const { return resumption.condition && resumption.condition(); }
-    /// Suspend the fibre, migrating the @c resumption condition to the promise.
+    /// Suspend the fibre, moving the @c resumption condition into the promise.
     void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
     /// Resumption handling - no-op.
     void await_resume() noexcept {}
   };
 
   /// Implements the awaitable interface for @c Id types - i.e., @c co_await another fibre.
+  ///
+  /// The awaiting fibre is parked as a joiner in the target's @c detail::IdTable slot and is woken
+  /// when the target is destroyed, so joining costs nothing per update. This works across
+  /// schedulers and threads.
   struct FibreIdAwaitable
   {
-    /// Transient storage for resumption condition. Propagated to the promise on suspension.
+    /// The fibre to join.
     Id id;
     /// Check if the fibre can immediately continue (true) or fibre needs to suspend (false).
     bool await_ready() const { return !id.running(); }
-    /// Suspend the fibre, migrating the @c resumption condition to the promise.
+    /// Suspend the fibre, requesting it be parked as a joiner of @c id.
     void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
     /// Resumption handling - no-op.
     void await_resume() noexcept {}
+
+    /// @c detail::Parker implementation. Registers the @p fibre as a joiner of @c id.
+    static bool park(void *awaitable, Fibre &fibre);
+    /// @c detail::Unparker implementation. Unlinks the @p joiner from the joiners of @c id.
+    static void *unpark(void *awaitable, const Id &joiner);
   };
 
   /// Implements the awaitable interface for @c Priority rescheduling - i.e., @c co_await
@@ -110,6 +289,24 @@ public:
     void await_resume() noexcept {}
   };
 
+  /// Implements the awaitable interface for waitable objects which park the fibre until signalled
+  /// - e.g., @c Event. A parked fibre is owned by the waitable object, not the scheduler, and costs
+  /// nothing per scheduler update.
+  struct ParkAwaitable
+  {
+    /// The park operation to perform on suspension.
+    detail::Parker parker{};
+    /// Set when the fibre may continue immediately.
+    bool ready = false;
+    /// Optional readiness test on @c co_await, passed the @c Parker::context. Used by waitables
+    /// which consume a signal, so the signal is not lost when the awaitable is created but never
+    /// awaited.
+    bool (*try_ready)(void *context) noexcept = nullptr;
+    bool await_ready() const noexcept { return ready || (try_ready && try_ready(parker.context)); }
+    void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+    void await_resume() noexcept {}
+  };
+
   /// Implements the awaitable interface for @c MoveTo - i.e., @c co_await @c moveTo().
   template <typename Scheduler>
     requires SchedulerType<Scheduler>
@@ -126,14 +323,31 @@ public:
   {
     detail::Frame frame{};
 
-    /// Destructor - marks the @c Fibre @c Id as no longer running.
-    ~promise_type() { frame.id.setRunning(false); }
+    /// Destructor - marks the @c Fibre @c Id as no longer running, releases its slot, wakes any
+    /// joining fibres and notifies the @c detail::Completion observer.
+    ~promise_type()
+    {
+      wakeJoiners(detail::IdTable::release(frame.id));
+      if (frame.flags & detail::Frame::CompletionBit)
+      {
+        const detail::Completion &completion = frame.cold_state->completion;
+        completion.notify(completion.context);
+      }
+    }
+
+    /// Wake the @c detail::IdSlot::joiners list via each joiner's @c detail::Home.
+    static void wakeJoiners(void *joiners) noexcept;
+
+    /// Allocate the coroutine frame from the pooled @c FrameAllocator.
+    static void *operator new(std::size_t size) { return FrameAllocator::allocate(size); }
+    /// Release the coroutine frame to the @c FrameAllocator.
+    static void operator delete(void *ptr) noexcept { FrameAllocator::deallocate(ptr); }
 
     /// Convert to the owning @c Fibre object.
     Fibre get_return_object() noexcept
     {
       return Fibre{ std::coroutine_handle<promise_type>::from_promise(*this),
-                    Id{ Fibre::nextId() } };
+                    detail::IdTable::acquire() };
     }
 
     /// Initial suspension - always.
@@ -141,16 +355,20 @@ public:
     /// Final suspension - always.
     std::suspend_always final_suspend() noexcept { return {}; }
     /// Exception handling - store to be rethrown on @c Fibre::resume().
-    void unhandled_exception() noexcept { frame.exception = std::current_exception(); }
+    void unhandled_exception() noexcept
+    {
+      frame.cold().exception = std::current_exception();
+      frame.flags |= detail::Frame::ExceptionBit;
+    }
 
     /// Return type definition - void.
     void return_void() noexcept {}
 
     /// Yield type definition - @c Resumption.
-    /// @param value Immediately stored into the @c resumption member (time still relative).
+    /// @param value Immediately stored into the frame deadline and condition (time still relative).
     std::suspend_always yield_value(Resumption &&value) noexcept
     {
-      frame.resumption = std::move(value);
+      frame.setResumption(std::move(value));
       return {};
     }
 
@@ -171,19 +389,20 @@ public:
     /// General @c co_await handling for @c Resumption types. Handles @c sleep(), @c wait() or
     /// @c resumption().
     /// @param resumption The the resumption condition.
-    Awaitable await_transform(const Resumption &resumption) noexcept
+    Awaitable await_transform(Resumption &&resumption) noexcept
     {
-      return { .resumption = resumption };
+      return { .resumption = std::move(resumption) };
     }
     /// @c co_await handling for @c WaitCondition callbacks. This includes lambda expression
     /// handling.
     /// @param condition The callable wait condition. Resume when it returns @c true.
     Awaitable await_transform(WaitCondition condition) noexcept
     {
-      return { .resumption = wait(condition) };
+      return { .resumption = wait(std::move(condition)) };
     }
 
-    /// @c co_await a fibre @c Id. Waits until the @c Id is flagged as not running.
+    /// @c co_await a fibre @c Id. Waits until the @c Id is flagged as not running. The awaiting
+    /// fibre is parked until then.
     FibreIdAwaitable await_transform(const Id &id) { return { .id = id }; }
 
     /// @c co_await handling for @c Priority rescheduling.
@@ -194,23 +413,45 @@ public:
       return { .value = std::move(reschedule) };
     }
 
+    /// @c co_await handling for waitable objects which park the fibre - e.g., @c Event.
+    /// @param waitable The object to wait on. Must support `Fibre::ParkAwaitable parkAwaitable()`.
+    template <typename Waitable>
+      requires requires(Waitable &waitable) {
+        { waitable.parkAwaitable() } -> std::same_as<ParkAwaitable>;
+      }
+    ParkAwaitable await_transform(Waitable &waitable)
+    {
+      return waitable.parkAwaitable();
+    }
+
     template <typename Scheduler>
       requires SchedulerType<Scheduler>
     MoveAwaitable<Scheduler> await_transform(MoveTo<Scheduler> move_to)
     {
       return { .move = move_to };
     }
+
+    /// @c co_await handling for park operations created directly - e.g., @c Scope::whenAll().
+    ParkAwaitable await_transform(ParkAwaitable awaitable) noexcept { return awaitable; }
+
+    /// @c co_await handling for child coroutines - e.g., @c Task.
+    /// @param child The child coroutine. Must support an rvalue `childAwaitable()` function.
+    template <typename Child>
+      requires requires(Child &&child) { std::forward<Child>(child).childAwaitable(); }
+    auto await_transform(Child &&child)
+    {
+      return std::forward<Child>(child).childAwaitable();
+    }
   };
 
   /// Create an empty, invalid fibre.
   Fibre() = default;
-  /// Create a fiber around the given coroutine @p handle and @p Id.
+  /// Create a fiber around the given coroutine @p handle and @p Id. The @p id must be a running
+  /// @c Id acquired from the @c detail::IdTable.
   Fibre(std::coroutine_handle<promise_type> handle, Id id)
     : _handle{ handle }
   {
-    auto &promise = _handle.promise();
-    id.setRunning(true);
-    promise.frame.id = std::move(id);
+    _handle.promise().frame.id = id;
   }
   /// Create a fibre around the given coroutine @p handle - preserves the current @c Id. This should
   /// only be called for fibres after a @c __release().
@@ -235,14 +476,23 @@ public:
   /// Destructor - cleans up the coroutine.
   ~Fibre();
 
-  [[nodiscard]] Id id() const { return { (_handle) ? _handle.promise().frame.id : Id{} }; }
+  [[nodiscard]] Id id() const noexcept { return (_handle) ? _handle.promise().frame.id : Id{}; }
 
   [[nodiscard]] std::string_view name() const
   {
-    return (_handle) ? _handle.promise().frame.name : std::string_view{};
+    return (_handle && _handle.promise().frame.cold_state) ?
+             _handle.promise().frame.cold_state->name :
+             std::string_view{};
+  }
+  /// Set the fiber (debug) name. Setting an empty name on an unnamed fibre does not allocate.
+  void setName(std::string_view name)
+  {
+    detail::Frame &frame = _handle.promise().frame;
+    if (!name.empty() || frame.cold_state)
+    {
+      frame.cold().name = name;
+    }
   }
-  /// Set the fiber (debug) name.
-  void setName(std::string_view name) { _handle.promise().frame.name = name; }
 
   /// Get the fibre scheduling priority.
   [[nodiscard]] int32_t priority() const
@@ -271,46 +521,70 @@ public:
 
   /// Attempt to resume fibre execution.
   ///
-  /// This returns control to the fibre coroutine so long as the @c promise_type::resumption
-  /// conditions are met. There are two conditions which may be met:
+  /// This returns control to the fibre coroutine so long as the pending @c Resumption conditions
+  /// are met. There are two conditions which may be met:
   ///
-  /// - @p epoch_time_s is greater than or equal to @c Resumption::time_s and there is no
+  /// - @p tick is greater than or equal to @c Resumption::deadline and there is no
   ///   @c Resumption::condition.
   /// - There is a @c Resumption::condition and it has been met (returns @c true ), or the condition
-  ///   returns @c false, the @c Resumption::time_s is greater than zero and the @p epoch_time_s is
-  ///   greater than or equal to @c Resumption::time_s.
+  ///   returns @c false, the @c Resumption::deadline is set and @p tick is greater than or equal to
+  ///   @c Resumption::deadline.
   ///
-  /// Resuming the coroutine sets a new @p promise_time::resumption value via either a @c co_yield
-  /// or
-  /// @c co_await. This new @c Resumption has a relative @c time_s value, which is converted to an
-  /// epoch time before returning. No @c Resumption object is given when the fibre completes  -
-  /// @c co_return.
+  /// Resuming the coroutine sets a new pending @c Resumption via either a @c co_yield
+  /// or @c co_await. This new @c Resumption has a relative @c deadline in nanoseconds, which is
+  /// converted to an absolute tick value before returning. No @c Resumption object is given when
+  /// the fibre completes  - @c co_return.
   ///
-  /// @param epoch_time_s The current epoch time in seconds as given to @c Scheduler::update().
+  /// @param tick The current time in @c Clock::tick() units.
+  /// @param tick_period_s The duration of each tick in seconds - @c Clock::quantisation().
   /// @return The new fibre state, which tells the @c Scheduler what to do with next with this
   /// @c Fibre.
-  [[nodiscard]] Resume resume(const double epoch_time_s) noexcept;
+  [[nodiscard]] Resume resume(uint64_t tick, double tick_period_s) noexcept;
 
-  /// Get any exception raised during fibre execution.
-  std::exception_ptr exception() const noexcept
+  /// Set the scheduler which owns this fibre. For internal use by schedulers only.
+  void __setHome(detail::Home *home)
   {
-    return _handle ? _handle.promise().frame.exception : nullptr;
+    if (_handle)
+    {
+      _handle.promise().frame.home = home;
+    }
   }
 
-  /// Swap contents of this fiber with another - self swap supported.
-  void swap(Fibre &other) noexcept { std::swap(_handle, other._handle); }
-
-  /// Generate the next unique fibre Id value.
-  [[nodiscard]] static IdValueType nextId()
+  /// Set the completion observer. For internal use only - see @c Scope.
+  void __setCompletion(const detail::Completion &completion)
   {
-    IdValueType id = (_next_id += Id::Increment);
-    if ((id | Id::SpecialBits) == InvalidFibreValue) [[unlikely]]
+    if (_handle)
     {
-      id = (_next_id += Id::Increment);
+      detail::Frame &frame = _handle.promise().frame;
+      frame.cold().completion = completion;
+      frame.flags |= detail::Frame::CompletionBit;
     }
-    return id;
   }
 
+  /// Get the tick at which the fibre was last queued. For internal use by schedulers only.
+  [[nodiscard]] uint64_t __queuedTick() const { return _handle.promise().frame.queued_tick; }
+  /// Set the tick at which the fibre was queued. For internal use by schedulers only.
+  void __setQueuedTick(uint64_t tick) { _handle.promise().frame.queued_tick = tick; }
+
+  /// Get the pending resumption deadline tick, zero for none. For internal use only.
+  [[nodiscard]] uint64_t __deadline() const { return _handle.promise().frame.deadline; }
+  /// Check if the fibre is waiting on a resumption condition. For internal use only.
+  [[nodiscard]] bool __waiting() const
+  {
+    return static_cast<bool>(_handle.promise().frame.condition);
+  }
+
+  /// Get any exception raised during fibre execution.
+  std::exception_ptr exception() const noexcept
+  {
+    return (_handle && _handle.promise().frame.cold_state) ?
+             _handle.promise().frame.cold_state->exception :
+             nullptr;
+  }
+
+  /// Swap contents of this fiber with another - self swap supported.
+  void swap(Fibre &other) noexcept { std::swap(_handle, other._handle); }
+
   /// Release ownership of the internal coroutine handle. The caller is then responsible for
   /// calling @c handle.destroy() . For internal use only.
   std::coroutine_handle<promise_type> __release() { return std::exchange(_handle, {}); }
@@ -319,10 +593,53 @@ public:
 
 private:
   std::coroutine_handle<promise_type> _handle;
-  static std::atomic<IdValueType> _next_id;
 };
 
 
+namespace detail
+{
+/// @c MoveRequest::move implementation for the @c Scheduler type. Uses the bulk @c move() overload
+/// of a @c BatchSchedulerType, otherwise moves the fibres one at a time.
+template <typename Scheduler>
+  requires SchedulerType<Scheduler>
+std::size_t moveFibres(void *target, std::span<Fibre> fibres)
+{
+  Scheduler &scheduler = *static_cast<Scheduler *>(target);
+  if constexpr (BatchSchedulerType<Scheduler>)
+  {
+    // Batch schedulers never fail, so apply the requests up front.
+    for (Fibre &fibre : fibres)
+    {
+      Frame &frame = fibre.__handle().promise().frame;
+      frame.flags &= static_cast<uint8_t>(~Frame::MovePendingBit);
+      const MoveRequest request = std::exchange(frame.cold_state->move, {});
+      if (request.priority)
+      {
+        fibre.__setPriority(*request.priority);
+      }
+    }
+    return scheduler.move(fibres);
+  }
+  else
+  {
+    for (std::size_t i = 0; i < fibres.size(); ++i)
+    {
+      // Clear the request first. On success another thread may resume the fibre immediately.
+      Frame &frame = fibres[i].__handle().promise().frame;
+      frame.flags &= static_cast<uint8_t>(~Frame::MovePendingBit);
+      const MoveRequest request = std::exchange(frame.cold_state->move, {});
+      if (!scheduler.move(fibres[i], request.priority))
+      {
+        frame.cold_state->move = request;
+        frame.flags |= Frame::MovePendingBit;
+        return i;
+      }
+    }
+    return fibres.size();
+  }
+}
+}  // namespace detail
+
 template <typename Scheduler>
   requires SchedulerType<Scheduler>
 void Fibre::MoveAwaitable<Scheduler>::await_suspend(
@@ -330,10 +647,12 @@ void Fibre::MoveAwaitable<Scheduler>::await_suspend(
 {
   if (move.target)
   {
-    // Setup the move operation.
-    handle.promise().frame.move_operation = [move = this->move](Fibre &fibre) -> bool {
-      return move.target->move(fibre, move.priority);
-    };
+    // Request the move. The current scheduler performs it once the fibre has suspended.
+    detail::Frame &frame = handle.promise().frame;
+    frame.cold().move = { .move = &detail::moveFibres<Scheduler>,
+                          .target = move.target,
+                          .priority = move.priority };
+    frame.flags |= detail::Frame::MovePendingBit;
     move.target = nullptr;
   }
 }
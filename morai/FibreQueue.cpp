@@ -1,6 +1,7 @@
 #include "FibreQueue.hpp"
 
 #include <algorithm>
+#include <utility>
 
 namespace morai
 {
@@ -10,31 +11,72 @@ FibreQueue::FibreQueue(int32_t priority, uint32_t capacity)
   capacity = std::max<uint32_t>(capacity, 16u);
   capacity = nextPowerOfTwo(capacity);
   _buffer.resize(capacity);
+  _ids.resize(capacity);
 }
 
-FibreQueue::FibreQueue(FibreQueue &&other) noexcept = default;
-FibreQueue &FibreQueue::operator=(FibreQueue &&other) noexcept = default;
+FibreQueue::FibreQueue(FibreQueue &&other) noexcept
+  : _head(std::exchange(other._head, 0u))
+  , _tail(std::exchange(other._tail, 0u))
+  , _buffer(std::move(other._buffer))
+  , _ids(std::move(other._ids))
+  , _priority(other._priority)
+{
+  trackAll();
+}
+
+FibreQueue &FibreQueue::operator=(FibreQueue &&other) noexcept
+{
+  if (this != &other)
+  {
+    clear();
+    _head = std::exchange(other._head, 0u);
+    _tail = std::exchange(other._tail, 0u);
+    _buffer = std::move(other._buffer);
+    _ids = std::move(other._ids);
+    _priority = other._priority;
+    trackAll();
+  }
+  return *this;
+}
 
 FibreQueue::~FibreQueue()
 {
   clear();
 }
 
-bool FibreQueue::contains(const Id &id) const
+uint32_t FibreQueue::locate(const Id &id) const
 {
-  if (empty())
+  const detail::IdSlot *slot = detail::IdTable::find(id);
+  if (!slot || slot->owner.load(std::memory_order_relaxed) != this)
   {
-    return false;
+    return InvalidPosition;
   }
 
+  // The slot owner and position may be stale - e.g., the fibre has since been popped or moved to
+  // another scheduler. Validate against the Id array so the fibre frame is not touched.
+  const uint64_t position = slot->position.load(std::memory_order_relaxed);
+  if (position >= _ids.size() || _ids[position] != id)
+  {
+    return InvalidPosition;
+  }
+  return static_cast<uint32_t>(position);
+}
+
+void FibreQueue::track(const uint32_t position) const
+{
+  if (detail::IdSlot *slot = detail::IdTable::find(_ids[position]))
+  {
+    slot->owner.store(this, std::memory_order_relaxed);
+    slot->position.store(position, std::memory_order_relaxed);
+  }
+}
+
+void FibreQueue::trackAll() const
+{
   for (uint32_t i = _tail; i != _head; i = nextIndex(i))
   {
-    if (_buffer.at(i).id() == id)
-    {
-      return true;
-    }
+    track(i);
   }
-  return false;
 }
 
 void FibreQueue::push(Fibre &&fibre, PriorityPosition position)
@@ -48,14 +90,18 @@ void FibreQueue::push(Fibre &&fibre, PriorityPosition position)
   {
     const uint32_t insert_index = nextIndex(_head);
 
+    _ids[_head] = fibre.id();
     _buffer.at(_head) = std::move(fibre);
+    track(_head);
     _head = insert_index;
     return;
   }
 
   // Tail/front insertion.
   uint32_t insert_index = priorIndex(_tail);
+  _ids[insert_index] = fibre.id();
   _buffer.at(insert_index) = std::move(fibre);
+  track(insert_index);
   _tail = insert_index;
 }
 
@@ -67,6 +113,7 @@ Fibre FibreQueue::pop()
   }
 
   Fibre fibre = std::move(_buffer[_tail]);
+  _ids[_tail] = Id{};
   _tail = nextIndex(_tail);
   return fibre;
 }
@@ -74,34 +121,35 @@ Fibre FibreQueue::pop()
 void FibreQueue::grow()
 {
   std::vector<Fibre> new_buffer(_buffer.size() * 2);
+  std::vector<Id> new_ids(new_buffer.size());
   uint32_t new_head = 0u;
   while (!empty())
   {
+    new_ids[new_head] = _ids[_tail];
     new_buffer.at(new_head++) = pop();
   }
   _buffer.clear();
 
   std::swap(_buffer, new_buffer);
+  std::swap(_ids, new_ids);
   _head = new_head;
   _tail = 0u;
+  trackAll();
 }
 
 
 bool FibreQueue::cancel(const Id &id)
 {
-  if (!id.valid())
-  {
-    return false;
-  }
-
-  auto iter = std::ranges::find_if(_buffer, [&id](const Fibre &fibre) { return fibre.id() == id; });
-  if (iter == _buffer.end())
+  const uint32_t position = locate(id);
+  if (position == InvalidPosition)
   {
     return false;
   }
 
+  // Leave an empty fibre in place. These are skipped on pop.
   Fibre replace;
-  std::swap(*iter, replace);
+  std::swap(_buffer[position], replace);
+  _ids[position] = Id{};
   return true;
 }
 
@@ -109,6 +157,9 @@ void FibreQueue::clear()
 {
   _head = 0;
   _tail = 0;
+  // Clear the Ids first so a fibre destructor cancelling another fibre in this queue does not find
+  // it mid clear.
+  std::fill(_ids.begin(), _ids.end(), Id{});
   // Force fibre cleanup by clearing the buffer. Resize to capacity to restore usage.
   _buffer.clear();
   _buffer.resize(_buffer.capacity());
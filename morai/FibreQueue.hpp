@@ -19,6 +19,9 @@ namespace morai
 /// selecting a queue of the appropriate @c priority(). During a scheduler update, the queue is
 /// continually popped - @c pop() - until it returns a an invalid @c Fibre - see @c Fibre::valid().
 ///
+/// The queue keeps the @c Id of each fibre in an array parallel to the fibre handles, so that
+/// @c Id based lookup, cancellation and position tracking do not touch the coroutine frames.
+///
 /// Copy operations are disabled because @c Fibre objects are move-only.
 class FibreQueue
 {
@@ -51,9 +54,10 @@ public:
   /// Returns true if the queue is empty.
   [[nodiscard]] bool empty() const { return _head == _tail; }
 
-  /// Returns true if the queue contains a fibre with the given @p id.
+  /// Returns true if the queue contains a fibre with the given @p id. This is a constant time
+  /// lookup via the fibre's @c detail::IdTable slot.
   /// @param id The @c Id to search for. An invalid @c Id always returns false.
-  [[nodiscard]] bool contains(const Id &id) const;
+  [[nodiscard]] bool contains(const Id &id) const { return locate(id) != InvalidPosition; }
 
   /// Position to insert a fibre into the queue.
   /// @param fibre The fibre to move into the queue.
@@ -64,7 +68,8 @@ public:
   /// Pop the next item off the queue.
   [[nodiscard]] Fibre pop();
 
-  /// Cancel a fibre with the given @p id. The fibre immediately terminates.
+  /// Cancel a fibre with the given @p id. The fibre immediately terminates. This is a constant time
+  /// lookup via the fibre's @c detail::IdTable slot.
   /// @param id The @c Id of the fibre to cancel.
   /// @return True if the fibre was cancelled.
   [[nodiscard]] bool cancel(const Id &id);
@@ -73,6 +78,15 @@ public:
   void clear();
 
 private:
+  static constexpr uint32_t InvalidPosition = ~0u;
+
+  /// Find the buffer position of the fibre with the given @p id or @c InvalidPosition.
+  [[nodiscard]] uint32_t locate(const Id &id) const;
+  /// Record the queue position of the fibre at @p position in its @c detail::IdTable slot.
+  void track(uint32_t position) const;
+  /// Record the queue position of all queued fibres. Required when the buffer or queue is moved.
+  void trackAll() const;
+
   [[nodiscard]] bool full() const { return nextIndex(_head) == _tail; }
 
   [[nodiscard]] uint32_t nextIndex(const uint32_t index) const
@@ -90,6 +104,9 @@ private:
   uint32_t _head = 0;
   uint32_t _tail = 0;
   std::vector<Fibre> _buffer{};
+  /// Fibre @c Ids parallel to @c _buffer. Supports @c locate() and @c track() without touching
+  /// coroutine frames. Invalid for empty positions.
+  std::vector<Id> _ids{};
   int32_t _priority = 0;
 };
 }  // namespace morai
@@ -0,0 +1,445 @@
+#include "FrameAllocator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <new>
+
+namespace morai
+{
+namespace
+{
+constexpr std::size_t SlabSize = 64u * 1024u;
+/// Size class marker for frames allocated by the global @c operator new.
+constexpr uint32_t LargeClass = ~0u;
+/// Capacity of the per thread frame size statistics table. Additional sizes are not recorded.
+constexpr std::size_t SizeTableCapacity = 64u;
+
+struct ThreadCache;
+
+/// Header preceding each frame.
+struct BlockHeader
+{
+  ThreadCache *owner;   ///< Allocating cache. Null for large frames.
+  uint32_t size_class;  ///< Size class index or @c LargeClass.
+  uint32_t size;        ///< Requested frame size.
+};
+static_assert(sizeof(BlockHeader) <= FrameAllocator::HeaderSize);
+
+/// Free list link. Overlays the frame memory of a free block, immediately after the header.
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+[[nodiscard]] BlockHeader *headerOf(void *frame) noexcept
+{
+  return reinterpret_cast<BlockHeader *>(static_cast<std::byte *>(frame) -
+                                         FrameAllocator::HeaderSize);
+}
+
+[[nodiscard]] FreeBlock *freeBlockOf(BlockHeader *header) noexcept
+{
+  return reinterpret_cast<FreeBlock *>(reinterpret_cast<std::byte *>(header) +
+                                       FrameAllocator::HeaderSize);
+}
+
+[[nodiscard]] BlockHeader *headerOf(FreeBlock *block) noexcept
+{
+  return reinterpret_cast<BlockHeader *>(reinterpret_cast<std::byte *>(block) -
+                                         FrameAllocator::HeaderSize);
+}
+
+[[nodiscard]] constexpr std::size_t blockSize(const uint32_t size_class) noexcept
+{
+  return (size_class + 1u) * FrameAllocator::SizeClassGranularity;
+}
+
+/// Increment a counter which is only ever written by one thread, but may be read by others.
+void bump(std::atomic<uint64_t> &counter, const uint64_t delta = 1u) noexcept
+{
+  counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+std::atomic_bool stats_enabled{ false };
+
+/// A thread local cache of size class pools. Only the owning thread touches the pools, while other
+/// threads push released frames onto @c remote_free.
+struct alignas(64) ThreadCache
+{
+  struct SizeClass
+  {
+    FreeBlock *free = nullptr;        ///< Local free list.
+    std::byte *bump = nullptr;        ///< Next unused block in the current slab.
+    std::byte *bump_end = nullptr;    ///< End of the current slab.
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> frees{ 0 };
+    std::atomic<uint64_t> reserved{ 0 };
+  };
+
+  struct SizeEntry
+  {
+    std::atomic<uint32_t> size{ 0 };  ///< Zero marks an empty entry.
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> frees{ 0 };
+  };
+
+  std::array<SizeClass, FrameAllocator::SizeClassCount> classes{};
+  std::array<SizeEntry, SizeTableCapacity> sizes{};
+  /// Slab memory owned by this cache.
+  std::vector<std::byte *> slabs;
+  /// Frames released by other threads. Drained by the owning thread.
+  alignas(64) std::atomic<FreeBlock *> remote_free{ nullptr };
+
+  [[nodiscard]] void *pop(const uint32_t size_class)
+  {
+    SizeClass &pool = classes[size_class];
+    if (!pool.free) [[unlikely]]
+    {
+      drainRemote();
+    }
+
+    if (FreeBlock *block = pool.free) [[likely]]
+    {
+      pool.free = block->next;
+      return headerOf(block);
+    }
+
+    const std::size_t block_size = blockSize(size_class);
+    if (pool.bump + block_size > pool.bump_end) [[unlikely]]
+    {
+      newSlab(pool);
+    }
+
+    void *block = pool.bump;
+    pool.bump += block_size;
+    bump(pool.reserved);
+    return block;
+  }
+
+  void push(BlockHeader *header) noexcept
+  {
+    SizeClass &pool = classes[header->size_class];
+    FreeBlock *block = freeBlockOf(header);
+    block->next = pool.free;
+    pool.free = block;
+    bump(pool.frees);
+    recordFree(header->size);
+  }
+
+  void pushRemote(BlockHeader *header) noexcept
+  {
+    FreeBlock *block = freeBlockOf(header);
+    block->next = remote_free.load(std::memory_order_relaxed);
+    while (!remote_free.compare_exchange_weak(block->next, block, std::memory_order_release,
+                                              std::memory_order_relaxed))
+    {}
+  }
+
+  void drainRemote() noexcept
+  {
+    FreeBlock *block = remote_free.exchange(nullptr, std::memory_order_acquire);
+    while (block)
+    {
+      FreeBlock *next = block->next;
+      push(headerOf(block));
+      block = next;
+    }
+  }
+
+  void newSlab(SizeClass &pool)
+  {
+    auto *slab = static_cast<std::byte *>(
+      ::operator new(SlabSize, std::align_val_t{ FrameAllocator::SizeClassGranularity }));
+    slabs.emplace_back(slab);
+    pool.bump = slab;
+    pool.bump_end = slab + SlabSize;
+  }
+
+  void recordAllocation(const uint32_t size) noexcept
+  {
+    if (SizeEntry *entry = sizeEntry(size))
+    {
+      bump(entry->allocations);
+    }
+  }
+
+  void recordFree(const uint32_t size) noexcept
+  {
+    if (stats_enabled.load(std::memory_order_relaxed))
+    {
+      if (SizeEntry *entry = sizeEntry(size))
+      {
+        bump(entry->frees);
+      }
+    }
+  }
+
+  /// Find or insert the @c SizeEntry for @p size. Only called by the owning thread.
+  [[nodiscard]] SizeEntry *sizeEntry(const uint32_t size) noexcept
+  {
+    std::size_t index = (size / alignof(std::max_align_t)) % SizeTableCapacity;
+    for (std::size_t i = 0; i < SizeTableCapacity; ++i)
+    {
+      SizeEntry &entry = sizes[index];
+      const uint32_t entry_size = entry.size.load(std::memory_order_relaxed);
+      if (entry_size == size)
+      {
+        return &entry;
+      }
+      if (entry_size == 0)
+      {
+        entry.size.store(size, std::memory_order_release);
+        return &entry;
+      }
+      index = (index + 1) % SizeTableCapacity;
+    }
+    return nullptr;
+  }
+};
+
+/// Tracks all thread caches. Intentionally never destroyed so frames may be released during static
+/// destruction.
+struct Registry
+{
+  std::mutex mutex;
+  std::vector<ThreadCache *> caches;
+  std::vector<ThreadCache *> orphans;
+};
+
+Registry &registry()
+{
+  static auto *instance = new Registry;
+  return *instance;
+}
+
+thread_local ThreadCache *local_cache = nullptr;
+thread_local bool local_cache_released = false;
+
+/// Orphans the thread cache on thread exit.
+struct CacheReleaser
+{
+  CacheReleaser() = default;
+  CacheReleaser(const CacheReleaser &) = delete;
+  CacheReleaser &operator=(const CacheReleaser &) = delete;
+
+  ~CacheReleaser()
+  {
+    if (local_cache)
+    {
+      Registry &reg = registry();
+      const std::scoped_lock guard(reg.mutex);
+      reg.orphans.emplace_back(local_cache);
+    }
+    local_cache = nullptr;
+    local_cache_released = true;
+  }
+};
+
+thread_local CacheReleaser cache_releaser;
+
+/// Get the cache for the current thread, creating or adopting one as required. Returns null once
+/// the thread is exiting.
+[[nodiscard]] ThreadCache *threadCache()
+{
+  if (local_cache) [[likely]]
+  {
+    return local_cache;
+  }
+
+  if (local_cache_released)
+  {
+    return nullptr;
+  }
+
+  // Odr-use the releaser to ensure it is constructed for this thread.
+  [[maybe_unused]] const CacheReleaser *releaser = &cache_releaser;
+
+  Registry &reg = registry();
+  const std::scoped_lock guard(reg.mutex);
+  if (!reg.orphans.empty())
+  {
+    local_cache = reg.orphans.back();
+    reg.orphans.pop_back();
+  }
+  else
+  {
+    local_cache = reg.caches.emplace_back(new ThreadCache);
+  }
+  return local_cache;
+}
+
+[[nodiscard]] void *allocateLarge(const std::size_t size)
+{
+  auto *header =
+    static_cast<BlockHeader *>(::operator new(size + FrameAllocator::HeaderSize));
+  header->owner = nullptr;
+  header->size_class = LargeClass;
+  header->size = static_cast<uint32_t>(std::min<std::size_t>(size, ~uint32_t{ 0 }));
+  return reinterpret_cast<std::byte *>(header) + FrameAllocator::HeaderSize;
+}
+}  // namespace
+
+void *FrameAllocator::allocate(const std::size_t size)
+{
+  if (size > MaxPooledSize) [[unlikely]]
+  {
+    return allocateLarge(size);
+  }
+
+  ThreadCache *cache = threadCache();
+  if (!cache) [[unlikely]]
+  {
+    return allocateLarge(size);
+  }
+
+  const auto size_class = static_cast<uint32_t>((size + HeaderSize - 1u) / SizeClassGranularity);
+  auto *header = static_cast<BlockHeader *>(cache->pop(size_class));
+  header->owner = cache;
+  header->size_class = size_class;
+  header->size = static_cast<uint32_t>(size);
+  bump(cache->classes[size_class].allocations);
+  if (stats_enabled.load(std::memory_order_relaxed))
+  {
+    cache->recordAllocation(header->size);
+  }
+  return reinterpret_cast<std::byte *>(header) + HeaderSize;
+}
+
+void FrameAllocator::deallocate(void *ptr) noexcept
+{
+  if (!ptr)
+  {
+    return;
+  }
+
+  BlockHeader *header = headerOf(ptr);
+  if (header->size_class == LargeClass) [[unlikely]]
+  {
+    ::operator delete(header);
+    return;
+  }
+
+  if (header->owner == local_cache) [[likely]]
+  {
+    header->owner->push(header);
+    return;
+  }
+
+  header->owner->pushRemote(header);
+}
+
+void FrameAllocator::reserve(const std::size_t frame_size, const std::size_t count)
+{
+  if (frame_size > MaxPooledSize || count == 0)
+  {
+    return;
+  }
+
+  ThreadCache *cache = threadCache();
+  if (!cache)
+  {
+    return;
+  }
+
+  const auto size_class =
+    static_cast<uint32_t>((frame_size + HeaderSize - 1u) / SizeClassGranularity);
+  ThreadCache::SizeClass &pool = cache->classes[size_class];
+  cache->drainRemote();
+
+  std::size_t available = 0;
+  for (const FreeBlock *block = pool.free; block && available < count; block = block->next)
+  {
+    ++available;
+  }
+
+  // Carve the remaining blocks onto the free list. This touches each block, faulting in the slab
+  // pages now rather than on first use.
+  const std::size_t block_size = blockSize(size_class);
+  for (; available < count; ++available)
+  {
+    if (pool.bump + block_size > pool.bump_end)
+    {
+      cache->newSlab(pool);
+    }
+    auto *header = reinterpret_cast<BlockHeader *>(pool.bump);
+    pool.bump += block_size;
+    bump(pool.reserved);
+    FreeBlock *block = freeBlockOf(header);
+    block->next = pool.free;
+    pool.free = block;
+  }
+}
+
+void FrameAllocator::setStatsEnabled(const bool enable) noexcept
+{
+  stats_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool FrameAllocator::statsEnabled() noexcept
+{
+  return stats_enabled.load(std::memory_order_relaxed);
+}
+
+std::vector<FrameSizeStats> FrameAllocator::frameSizeStats()
+{
+  std::map<std::size_t, FrameSizeStats> collated;
+  Registry &reg = registry();
+  const std::scoped_lock guard(reg.mutex);
+  for (const ThreadCache *cache : reg.caches)
+  {
+    for (const auto &entry : cache->sizes)
+    {
+      const uint32_t size = entry.size.load(std::memory_order_acquire);
+      if (size == 0)
+      {
+        continue;
+      }
+
+      FrameSizeStats &stats = collated[size];
+      const uint64_t allocations = entry.allocations.load(std::memory_order_relaxed);
+      const uint64_t frees = entry.frees.load(std::memory_order_relaxed);
+      stats.frame_size = size;
+      stats.allocations += allocations;
+      // Stats may be enabled while frames are live, so frees can exceed allocations.
+      stats.live += allocations - std::min(allocations, frees);
+    }
+  }
+
+  std::vector<FrameSizeStats> stats;
+  stats.reserve(collated.size());
+  for (const auto &[size, entry] : collated)
+  {
+    stats.emplace_back(entry);
+  }
+  return stats;
+}
+
+std::vector<SizeClassStats> FrameAllocator::sizeClassStats()
+{
+  std::vector<SizeClassStats> stats(SizeClassCount);
+  for (uint32_t i = 0; i < SizeClassCount; ++i)
+  {
+    stats[i].block_size = blockSize(i);
+  }
+
+  Registry &reg = registry();
+  const std::scoped_lock guard(reg.mutex);
+  for (const ThreadCache *cache : reg.caches)
+  {
+    for (uint32_t i = 0; i < SizeClassCount; ++i)
+    {
+      const ThreadCache::SizeClass &pool = cache->classes[i];
+      const uint64_t allocations = pool.allocations.load(std::memory_order_relaxed);
+      const uint64_t frees = pool.frees.load(std::memory_order_relaxed);
+      stats[i].allocations += allocations;
+      stats[i].live += allocations - std::min(allocations, frees);
+      stats[i].reserved += pool.reserved.load(std::memory_order_relaxed);
+    }
+  }
+  return stats;
+}
+}  // namespace morai
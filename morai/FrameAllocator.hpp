@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace morai
+{
+/// Allocation statistics for coroutine frames of a single size. See @c FrameAllocator.
+///
+/// Each coroutine function has a fixed, compiler determined frame size, so these statistics
+/// effectively identify fibre entry points by their frame size.
+struct FrameSizeStats
+{
+  std::size_t frame_size = 0;  ///< Frame size in bytes as requested by the compiler.
+  uint64_t allocations = 0;    ///< Total number of frames allocated at this size.
+  uint64_t live = 0;           ///< Number of frames currently allocated at this size.
+};
+
+/// Allocation statistics for a single @c FrameAllocator size class.
+struct SizeClassStats
+{
+  std::size_t block_size = 0;  ///< Block size for this class, including the block header.
+  uint64_t allocations = 0;    ///< Total number of blocks allocated from this class.
+  uint64_t live = 0;           ///< Number of blocks currently allocated from this class.
+  uint64_t reserved = 0;       ///< Number of blocks carved from slabs for this class.
+};
+
+/// Pooled allocator for coroutine frames. Backs @c Fibre::promise_type @c operator new/delete.
+///
+/// Frames are served from size class slab pools in a thread local cache. Allocating pops a free
+/// list or bumps a pointer through the current slab, so frames allocated by the same thread - and
+/// hence the same @c Scheduler - are packed closely together in memory. Freeing a frame on the
+/// allocating thread pushes it back onto the local free list. Fibres may migrate between threads
+/// (see @c moveTo()) so a frame may be freed by another thread. Such frames are pushed onto a lock
+/// free remote free list owned by the allocating cache, which is reclaimed by the owning thread the
+/// next time its local free list runs dry.
+///
+/// Frames larger than @c MaxPooledSize fall back to the global @c operator new.
+///
+/// Thread caches outlive their threads. A cache is orphaned when its thread exits and is adopted by
+/// the next thread which requires a cache. Slab memory is retained for reuse and never released.
+///
+/// Use @c reserve() to pre-warm the current thread's pools and avoid allocation spikes on startup.
+/// Per size class statistics are always collected, while per frame size statistics - see
+/// @c frameSizeStats() - are only collected after @c setStatsEnabled(true) as they incur an extra
+/// lookup per allocation.
+class FrameAllocator
+{
+public:
+  /// Number of pooled size classes.
+  static constexpr std::size_t SizeClassCount = 32u;
+  /// Block size increment between size classes.
+  static constexpr std::size_t SizeClassGranularity = 64u;
+  /// Per block header overhead. Preserves the default @c new alignment.
+  static constexpr std::size_t HeaderSize = 16u;
+  /// Maximum frame size served from the pools.
+  static constexpr std::size_t MaxPooledSize = SizeClassCount * SizeClassGranularity - HeaderSize;
+
+  /// Allocate a frame of the given @p size.
+  /// @param size The frame size in bytes.
+  /// @return The frame memory. Never null - throws @c std::bad_alloc on failure.
+  [[nodiscard]] static void *allocate(std::size_t size);
+
+  /// Release a frame allocated with @c allocate(). May be called from any thread.
+  /// @param ptr The frame to release. Null is ignored.
+  static void deallocate(void *ptr) noexcept;
+
+  /// Pre-warm the current thread's pool such that at least @p count frames of @p frame_size bytes
+  /// can be allocated without requesting more memory.
+  ///
+  /// The @p frame_size can be found from @c frameSizeStats() in a profiling run.
+  ///
+  /// @param frame_size The frame size to reserve for.
+  /// @param count The number of frames to reserve.
+  static void reserve(std::size_t frame_size, std::size_t count);
+
+  /// Enable or disable per frame size statistics collection.
+  static void setStatsEnabled(bool enable) noexcept;
+  /// Query whether per frame size statistics collection is enabled.
+  [[nodiscard]] static bool statsEnabled() noexcept;
+
+  /// Collate per frame size statistics across all threads. Only populated while
+  /// @c statsEnabled(). Sorted by @c FrameSizeStats::frame_size.
+  ///
+  /// Frames released by another thread are accounted once reclaimed by the allocating thread, so
+  /// the @c FrameSizeStats::live count is approximate.
+  [[nodiscard]] static std::vector<FrameSizeStats> frameSizeStats();
+
+  /// Collate per size class statistics across all threads. Has the same @c live count caveats as
+  /// @c frameSizeStats().
+  [[nodiscard]] static std::vector<SizeClassStats> sizeClassStats();
+};
+}  // namespace morai
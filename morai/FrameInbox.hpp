@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Fibre.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <span>
+#include <thread>
+#include <utility>
+
+namespace morai
+{
+/// An unbounded, lock free, multi-producer inbox of fibres.
+///
+/// Fibres are linked intrusively through their coroutine frames - see @c detail::Frame::link - so
+/// pushing never allocates and never fails. This is used by schedulers to receive fibres woken on
+/// other threads, such as fibres parked on an @c Event.
+///
+/// @c push() is threadsafe and wait free - a single exchange on the list head. @c drain() takes all
+/// fibres pushed so far in a single exchange, so concurrent drains receive disjoint batches. Fibres
+/// are drained in push order.
+///
+/// @par Implementation
+///
+/// A producer marks its link as pending, exchanges itself in as the new head, then stores the
+/// previous head into its link. A drain which reaches a pending link waits for that producer to
+/// complete the store. The window is two instructions wide, so this is rare and brief.
+class FrameInbox
+{
+public:
+  using Handle = std::coroutine_handle<Fibre::promise_type>;
+
+  FrameInbox() = default;
+  /// Destructor - destroys any remaining fibres.
+  ~FrameInbox() { clear(); }
+
+  FrameInbox(const FrameInbox &) = delete;
+  FrameInbox(FrameInbox &&) = delete;
+  FrameInbox &operator=(const FrameInbox &) = delete;
+  FrameInbox &operator=(FrameInbox &&) = delete;
+
+  /// Check if the inbox is empty. This may be inaccurate as other threads may push.
+  /// @param order Memory order for the check. A @c std::memory_order_seq_cst check following a
+  /// sequentially consistent store sees any @c push() which did not see that store.
+  [[nodiscard]] bool empty(std::memory_order order = std::memory_order_relaxed) const noexcept
+  {
+    return _head.load(order) == nullptr;
+  }
+
+  /// Push a @p fibre into the inbox (threadsafe). Takes ownership via @c Fibre::__release().
+  /// @param fibre The fibre to push. Must be valid.
+  void push(Fibre &&fibre) noexcept
+  {
+    const Handle handle = fibre.__release();
+    pushChain(handle, handle);
+  }
+
+  /// Push all @p fibres into the inbox with a single exchange (threadsafe). Takes ownership via
+  /// @c Fibre::__release(). The @p fibres are drained in order, as if pushed one at a time.
+  /// @param fibres The fibres to push. Must be valid.
+  void push(std::span<Fibre> fibres) noexcept
+  {
+    if (fibres.empty())
+    {
+      return;
+    }
+
+    // Link the fibres privately, newest first. Published by the exchange in pushChain().
+    const Handle oldest = fibres.front().__release();
+    Handle newest = oldest;
+    for (Fibre &fibre : fibres.subspan(1))
+    {
+      const Handle handle = fibre.__release();
+      handle.promise().frame.link = newest.address();
+      newest = handle;
+    }
+    pushChain(oldest, newest);
+  }
+
+  /// Drain all fibres from the inbox, invoking @p func for each fibre in push order.
+  /// @param func Callable accepting a `Fibre &&` argument.
+  /// @return The number of fibres drained.
+  template <typename Func>
+  std::size_t drain(Func &&func)
+  {
+    void *head = _head.exchange(nullptr, std::memory_order_acquire);
+    if (!head)
+    {
+      return 0;
+    }
+
+    // The list is LIFO. Reverse it to restore push order.
+    void *fifo = nullptr;
+    while (head)
+    {
+      Handle handle = Handle::from_address(head);
+      head = waitLink(handle);
+      handle.promise().frame.link = fifo;
+      fifo = handle.address();
+    }
+
+    std::size_t count = 0;
+    while (fifo)
+    {
+      Handle handle = Handle::from_address(fifo);
+      fifo = std::exchange(handle.promise().frame.link, nullptr);
+      func(Fibre{ handle });
+      ++count;
+    }
+    return count;
+  }
+
+  /// Destroy all fibres in the inbox. Repeats until empty as destroying a fibre may wake others
+  /// into the inbox - e.g., fibres joining the destroyed fibre.
+  /// @return The number of fibres destroyed.
+  std::size_t clear()
+  {
+    std::size_t count = 0;
+    while (!empty())
+    {
+      count += drain([](Fibre &&fibre) { Fibre discard = std::move(fibre); });
+    }
+    return count;
+  }
+
+private:
+  /// Publish the privately linked chain from @p newest back to @p oldest with a single exchange.
+  void pushChain(Handle oldest, Handle newest) noexcept
+  {
+    std::atomic_ref<void *> link{ oldest.promise().frame.link };
+    link.store(pending(), std::memory_order_relaxed);
+    // Release publishes the frames and the pending link to drains. Acquire orders the link store
+    // after any drain of the previous head. Sequential consistency orders the push before a
+    // consumer's blocked state is checked - see empty(). This costs nothing extra on x86.
+    void *head = _head.exchange(newest.address(), std::memory_order_seq_cst);
+    link.store(head, std::memory_order_release);
+  }
+
+  /// Marker for a link which a producer has yet to store. Never a coroutine frame address.
+  [[nodiscard]] void *pending() noexcept { return this; }
+
+  /// Load the link from the frame of @p handle, waiting for an in progress @c push() to store it.
+  [[nodiscard]] void *waitLink(Handle handle) noexcept
+  {
+    std::atomic_ref<void *> link{ handle.promise().frame.link };
+    void *next = link.load(std::memory_order_acquire);
+    while (next == pending())
+    {
+      std::this_thread::yield();
+      next = link.load(std::memory_order_acquire);
+    }
+    return next;
+  }
+
+  std::atomic<void *> _head{ nullptr };
+};
+}  // namespace morai
@@ -0,0 +1,274 @@
+#include "Id.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace morai::detail
+{
+namespace
+{
+constexpr uint64_t tagIncrement = uint64_t{ 1 } << 32u;
+constexpr uint64_t linkMask = tagIncrement - 1u;
+
+/// A @c CancellationRouter registration.
+struct Route
+{
+  const void *owner = nullptr;
+  CancellationRouter::Handler handler = nullptr;
+  void *context = nullptr;
+};
+
+/// Registered routes. Few containers register, so a linear search suffices.
+struct Routes
+{
+  std::shared_mutex mutex;
+  std::vector<Route> routes;
+};
+
+Routes &routes()
+{
+  static Routes instance;
+  return instance;
+}
+
+/// Calculate the next slot generation, skipping the reserved zero generation.
+uint64_t nextGeneration(const uint64_t generation)
+{
+  const uint64_t next = (generation + 1u) & linkMask;
+  return (next) ? next : 1u;
+}
+}  // namespace
+
+std::atomic<IdSlot *> IdTable::_chunks[IdTable::ChunkCount] = {};
+std::atomic<uint64_t> IdTable::_free_head{ 0 };
+std::atomic<uint32_t> IdTable::_next_index{ 0 };
+
+Id IdTable::acquire()
+{
+  uint32_t index = 0;
+  uint64_t head = _free_head.load(std::memory_order_acquire);
+  for (;;)
+  {
+    const uint64_t link = head & linkMask;
+    if (link == 0)
+    {
+      index = allocateIndex();
+      break;
+    }
+
+    // The ABA tag ensures next_free remains consistent with head even if the slot is concurrently
+    // popped and pushed again.
+    const IdSlot *slot = find(static_cast<uint32_t>(link - 1u));
+    const uint64_t next = slot->next_free.load(std::memory_order_relaxed);
+    if (_free_head.compare_exchange_weak(head, ((head & ~linkMask) + tagIncrement) | next,
+                                         std::memory_order_acquire, std::memory_order_acquire))
+    {
+      index = static_cast<uint32_t>(link - 1u);
+      break;
+    }
+  }
+
+  IdSlot *slot = find(index);
+  uint64_t generation = slot->state.load(std::memory_order_relaxed) >> GenerationShift;
+  generation = (generation) ? generation : 1u;
+  slot->owner.store(nullptr, std::memory_order_relaxed);
+  slot->state.store((generation << GenerationShift) | RunningBit, std::memory_order_release);
+  return Id{ (generation << GenerationShift) | index };
+}
+
+void *IdTable::release(const Id &id) noexcept
+{
+  IdSlot *slot = find(id);
+  if (!slot)
+  {
+    return nullptr;
+  }
+
+  // Take the lock to detach the joiners.
+  uint64_t state = slot->state.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    if (state & LockBit)
+    {
+      state = slot->state.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (slot->state.compare_exchange_weak(state, state | LockBit, std::memory_order_acquire,
+                                          std::memory_order_relaxed))
+    {
+      break;
+    }
+  }
+  void *joiners = std::exchange(slot->joiners, nullptr);
+
+  // Bump the generation, clearing the running and cancellation bits and the lock. Outstanding Id
+  // values no longer match the slot.
+  slot->state.store(nextGeneration(id.generation()) << GenerationShift, std::memory_order_release);
+
+  const uint64_t link = static_cast<uint64_t>(id.index()) + 1u;
+  uint64_t head = _free_head.load(std::memory_order_relaxed);
+  do
+  {
+    slot->next_free.store(static_cast<uint32_t>(head & linkMask), std::memory_order_relaxed);
+  } while (!_free_head.compare_exchange_weak(head, ((head & ~linkMask) + tagIncrement) | link,
+                                             std::memory_order_release, std::memory_order_relaxed));
+  return joiners;
+}
+
+IdSlot *IdTable::lockRunning(const Id &id) noexcept
+{
+  IdSlot *slot = find(id);
+  if (!slot)
+  {
+    return nullptr;
+  }
+
+  uint64_t state = slot->state.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    if ((state >> GenerationShift) != id.generation() || !(state & RunningBit))
+    {
+      return nullptr;
+    }
+    if (state & LockBit)
+    {
+      state = slot->state.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (slot->state.compare_exchange_weak(state, state | LockBit, std::memory_order_acquire,
+                                          std::memory_order_relaxed))
+    {
+      return slot;
+    }
+  }
+}
+
+void IdTable::setParked(const Id &id, const Unparker &unparker) noexcept
+{
+  if (IdSlot *slot = lockRunning(id))
+  {
+    slot->unparker = unparker;
+    slot->state.fetch_or(ParkedBit, std::memory_order_relaxed);
+    unlock(slot);
+  }
+}
+
+void IdTable::clearParked(const Id &id) noexcept
+{
+  if (IdSlot *slot = lockRunning(id))
+  {
+    slot->unparker = {};
+    slot->state.fetch_and(~(ParkedBit | LockBit), std::memory_order_release);
+  }
+}
+
+void *IdTable::unpark(const Id &id) noexcept
+{
+  IdSlot *slot = lockRunning(id);
+  if (!slot)
+  {
+    return nullptr;
+  }
+
+  // The waitable cannot wake the fibre, nor be destroyed, until it clears the parked state, which
+  // needs the lock we hold.
+  void *address = nullptr;
+  if (slot->state.load(std::memory_order_relaxed) & ParkedBit)
+  {
+    address = slot->unparker.unpark(slot->unparker.context, id);
+    if (address)
+    {
+      slot->unparker = {};
+      slot->state.fetch_and(~ParkedBit, std::memory_order_relaxed);
+    }
+  }
+  unlock(slot);
+  return address;
+}
+
+uint32_t IdTable::allocateIndex()
+{
+  const uint32_t index = _next_index.fetch_add(1u, std::memory_order_relaxed);
+  const uint64_t biased = static_cast<uint64_t>(index) + (uint64_t{ 1 } << FirstChunkBits);
+  const unsigned chunk = static_cast<unsigned>(std::bit_width(biased)) - FirstChunkBits - 1u;
+  if (chunk >= ChunkCount)
+  {
+    throw std::length_error("Fibre Id table exhausted");
+  }
+
+  if (!_chunks[chunk].load(std::memory_order_acquire))
+  {
+    // First use of this chunk. Allocate and race to install it. Chunks are never released.
+    auto *slots = new IdSlot[std::size_t{ 1 } << (chunk + FirstChunkBits)];
+    IdSlot *expected = nullptr;
+    if (!_chunks[chunk].compare_exchange_strong(expected, slots, std::memory_order_acq_rel))
+    {
+      delete[] slots;
+    }
+  }
+
+  return index;
+}
+
+void CancellationRouter::add(const void *owner, Handler handler, void *context)
+{
+  Routes &table = routes();
+  const std::unique_lock lock(table.mutex);
+  table.routes.emplace_back(Route{ .owner = owner, .handler = handler, .context = context });
+}
+
+void CancellationRouter::remove(const void *owner)
+{
+  Routes &table = routes();
+  const std::unique_lock lock(table.mutex);
+  std::erase_if(table.routes, [owner](const Route &route) { return route.owner == owner; });
+}
+
+void CancellationRouter::route(const void *owner, const Id &id)
+{
+  if (!owner)
+  {
+    return;
+  }
+
+  Routes &table = routes();
+  const std::shared_lock lock(table.mutex);
+  const auto iter = std::ranges::find(table.routes, owner, &Route::owner);
+  if (iter != table.routes.end())
+  {
+    iter->handler(iter->context, id);
+  }
+}
+}  // namespace morai::detail
+
+namespace morai
+{
+void Id::markForCancellation() const noexcept
+{
+  detail::IdSlot *slot = detail::IdTable::find(*this);
+  if (!slot)
+  {
+    return;
+  }
+
+  uint64_t word = slot->state.load(std::memory_order_relaxed);
+  // Only flag a running fibre of the matching generation. The CAS guards against slot reuse.
+  while ((word >> detail::IdTable::GenerationShift) == generation() &&
+         (word & detail::IdTable::RunningBit) && !(word & detail::IdTable::CancellationBit))
+  {
+    if (slot->state.compare_exchange_weak(word, word | detail::IdTable::CancellationBit,
+                                          std::memory_order_relaxed))
+    {
+      // Pairs with the fence a container issues after taking ownership: either we see the new
+      // owner, or the container sees the mark.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      detail::CancellationRouter::route(slot->owner.load(std::memory_order_relaxed), *this);
+      return;
+    }
+  }
+}
+}  // namespace morai
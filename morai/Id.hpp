@@ -1,106 +1,252 @@
 #pragma once
 
+#include <atomic>
+#include <bit>
 #include <cstdint>
-#include <memory>
 
 namespace morai
 {
 using IdValueType = uint64_t;
 constexpr auto InvalidFibreValue = ~static_cast<IdValueType>(0);
 
-/// Id class for a fibre. Each fibre is uniquely identified by an Id.
+class Id;
+
+namespace detail
+{
+/// Detaches a parked fibre from the waitable object holding it - e.g., so a @c Scope can cancel a
+/// child parked on an @c Event. See @c IdTable::ParkedBit.
+struct Unparker
+{
+  /// Unlink the parked fibre @p id from the waitable. Called with the fibre's slot locked.
+  /// @return The fibre coroutine frame address, or null if the fibre is already being woken.
+  void *(*unpark)(void *context, const Id &id) = nullptr;
+  /// Waitable object context for @c unpark().
+  void *context = nullptr;
+};
+
+/// A fibre state slot in the @c IdTable.
+struct IdSlot
+{
+  /// State word: the slot generation in the high 32 bits and @c IdTable state bits in the low bits.
+  std::atomic<uint64_t> state{ 0 };
+  /// The container - e.g., @c FibreQueue - which last held the fibre. Only meaningful to that
+  /// container.
+  std::atomic<const void *> owner{ nullptr };
+  /// Position of the fibre in the @c owner container. Only meaningful to the @c owner.
+  std::atomic<uint64_t> position{ 0 };
+  /// Next free slot index plus one when in the free list. Zero terminates the list.
+  std::atomic<uint32_t> next_free{ 0 };
+  /// Fibres waiting for this fibre to complete - coroutine frame address list linked via
+  /// @c detail::Frame::link. Guarded by @c IdTable::LockBit.
+  void *joiners = nullptr;
+  /// The waitable this fibre is parked on. Valid while @c IdTable::ParkedBit is set. Guarded by
+  /// @c IdTable::LockBit.
+  Unparker unparker{};
+};
+
+/// Global, lock free table of fibre state slots addressed by @c Id.
 ///
-/// The Id itself is a wrapper around a shared value which holds the actual id. Conceptually it can
-/// be considered a shared pointer.
+/// An @c Id packs a slot index in the low 32 bits and a slot generation in the high 32 bits. Each
+/// slot holds an atomic state word carrying the generation of the fibre currently occupying the
+/// slot along with its running and cancellation bits. Releasing a slot bumps its generation, so
+/// stale @c Id values never match a reused slot.
 ///
-/// The @c ID does not represent a valid fibre if it's value is @c InvalidFibreValue - see
-/// @c valid(). The @c Id can also be used to check if the fibre is still alive or has been
-/// cleaned up and is no longer running - see @c running().
-class Id
+/// Slots are allocated in geometrically growing chunks which are never released, so slot addresses
+/// are stable and lookups need no locking. Released slots are recycled via a lock free free list.
+class IdTable
 {
 public:
-  /// Marks the @c Id as belonging to a running fibre.
+  /// Marks the slot as belonging to a running fibre.
   static constexpr uint64_t RunningBit = 1u;
-  /// Marks the @c Id  to request cancellation of the owning fibre.
+  /// Marks the slot to request cancellation of the owning fibre.
   static constexpr uint64_t CancellationBit = 2u;
   /// Collation of bits used to flag special states.
   static constexpr uint64_t SpecialBits = RunningBit | CancellationBit;
-  /// @c Id value generation increment to avoid special bits.
-  static constexpr uint64_t Increment = 4u;
+  /// Spin lock bit guarding @c IdSlot::joiners and @c IdSlot::unparker.
+  static constexpr uint64_t LockBit = 4u;
+  /// Set while the fibre is parked on a waitable object which supports @c unpark().
+  static constexpr uint64_t ParkedBit = 8u;
+  /// Bit shift for the generation in both @c Id values and slot state words.
+  static constexpr unsigned GenerationShift = 32u;
+
+  /// Log2 of the number of slots in the first chunk.
+  static constexpr unsigned FirstChunkBits = 10u;
+  /// Number of chunks. Each chunk is double the size of the previous chunk, covering 32-bit
+  /// indices.
+  static constexpr unsigned ChunkCount = 32u - FirstChunkBits;
+
+  /// Acquire a slot for a new fibre, marking it as running.
+  /// @return The new fibre @c Id.
+  [[nodiscard]] static Id acquire();
+
+  /// Release the slot for @p id, marking the fibre as no longer running and recycling the slot.
+  /// Must only be called once per acquired @c Id. Invalid ids are ignored.
+  /// @return The detached @c IdSlot::joiners list, which the caller must wake.
+  static void *release(const Id &id) noexcept;
+
+  /// Lock the slot for @p id, but only while it holds the matching running fibre. Use this to
+  /// register @c IdSlot::joiners. Must be paired with @c unlock().
+  /// @return The locked slot or null if @p id is not running.
+  [[nodiscard]] static IdSlot *lockRunning(const Id &id) noexcept;
+
+  /// Unlock a slot locked by @c lockRunning().
+  static void unlock(IdSlot *slot) noexcept
+  {
+    slot->state.fetch_and(~LockBit, std::memory_order_release);
+  }
 
-  Id() = default;
-  /// Construct an @c Id with the given value and set its running state.
-  ///
-  /// @param value The id value. Note that the @c RunningBit must not be set to ensure a valid Id.
-  /// In general only the @c Fibre class should set Id values.
-  /// @param running Mark the fibre @c Id as running?
-  explicit Id(IdValueType value, bool running = false)
-    : ptr_(std::make_shared<IdValueType>(value))
+  /// Record that the fibre @p id is parking on the waitable described by @p unparker. Call before
+  /// linking the fibre into the waitable, outside the waitable's lock. The waitable must then
+  /// decline to park a fibre marked for cancellation, checking under its lock.
+  static void setParked(const Id &id, const Unparker &unparker) noexcept;
+  /// Clear the state set by @c setParked(). Call once the fibre is unlinked from the waitable,
+  /// outside its lock, and before the fibre is woken or declined.
+  static void clearParked(const Id &id) noexcept;
+  /// Detach the parked fibre @p id from its waitable, if it supports @c Unparker.
+  /// @return The detached fibre's coroutine frame address, now owned by the caller, or null if the
+  /// fibre is not parked or is already being woken.
+  [[nodiscard]] static void *unpark(const Id &id) noexcept;
+
+  /// Lookup the slot at the given @p index.
+  /// @return The slot or null if @p index has not been allocated.
+  [[nodiscard]] static IdSlot *find(uint32_t index) noexcept
   {
-    setRunning(running);
+    const uint64_t biased = static_cast<uint64_t>(index) + (uint64_t{ 1 } << FirstChunkBits);
+    const unsigned chunk = static_cast<unsigned>(std::bit_width(biased)) - FirstChunkBits - 1u;
+    if (chunk >= ChunkCount)
+    {
+      return nullptr;
+    }
+    IdSlot *slots = _chunks[chunk].load(std::memory_order_acquire);
+    return (slots) ? slots + (biased - (uint64_t{ 1 } << (chunk + FirstChunkBits))) : nullptr;
   }
-  ~Id() = default;
 
-  Id(const Id &other) = default;
-  Id(Id &&other) noexcept = default;
-  Id &operator=(const Id &other) = default;
-  Id &operator=(Id &&other) noexcept = default;
+  /// Lookup the slot for the given @p id.
+  /// @return The slot or null for invalid or unknown ids.
+  [[nodiscard]] static IdSlot *find(const Id &id) noexcept;
+
+private:
+  [[nodiscard]] static uint32_t allocateIndex();
+
+  static std::atomic<IdSlot *> _chunks[ChunkCount];
+  /// Free list head: ABA tag in the high 32 bits, slot index plus one in the low 32 bits.
+  static std::atomic<uint64_t> _free_head;
+  /// Next never used slot index.
+  static std::atomic<uint32_t> _next_index;
+};
+
+/// Forwards @c Id::markForCancellation() to the container holding the fibre, for containers which
+/// do not otherwise visit the fibre until it is due - i.e., a scheduler's @c TimerWheel. Containers
+/// register under the address they store in @c IdSlot::owner.
+class CancellationRouter
+{
+public:
+  /// Invoked from the marking thread with a newly marked @c Id. Must be threadsafe, must not block
+  /// and must not mark other fibres.
+  using Handler = void (*)(void *context, const Id &id);
+
+  /// Register the @p handler for fibres held by @p owner.
+  static void add(const void *owner, Handler handler, void *context);
+  /// Remove the registration for @p owner. Blocks while the handler is being invoked.
+  static void remove(const void *owner);
+  /// Invoke the handler registered for @p owner, if any, with @p id.
+  static void route(const void *owner, const Id &id);
+};
+}  // namespace detail
+
+/// Id class for a fibre. Each fibre is uniquely identified by an Id.
+///
+/// The @c Id is a trivially copyable 64-bit handle into a global table of fibre state slots - see
+/// @c detail::IdTable. It packs the slot index and the slot generation, so an @c Id no longer
+/// matches once its fibre has completed and the slot is reused.
+///
+/// The @c ID does not represent a valid fibre if it's value is @c InvalidFibreValue - see
+/// @c valid(). The @c Id can also be used to check if the fibre is still alive or has been
+/// cleaned up and is no longer running - see @c running(). These queries are single atomic loads
+/// and are threadsafe.
+class Id
+{
+public:
+  Id() = default;
+  /// Construct an @c Id with the given raw value.
+  ///
+  /// In general only the @c detail::IdTable should create valid Id values. Arbitrary values are
+  /// safe, but will not be running.
+  ///
+  /// @param value The id value.
+  explicit constexpr Id(IdValueType value) noexcept
+    : _value(value)
+  {}
+
+  /// Reports the @c Id value.
+  [[nodiscard]] constexpr uint64_t id() const noexcept { return _value; }
 
-  /// Reports the @c Id value. This never reports the @c RunningBit.
-  [[nodiscard]] uint64_t id() const noexcept
+  /// Returns the slot index part of the @c Id.
+  [[nodiscard]] constexpr uint32_t index() const noexcept { return static_cast<uint32_t>(_value); }
+
+  /// Returns the slot generation part of the @c Id.
+  [[nodiscard]] constexpr uint32_t generation() const noexcept
   {
-    return (ptr_) ? (*ptr_ & ~RunningBit) : InvalidFibreValue;
+    return static_cast<uint32_t>(_value >> detail::IdTable::GenerationShift);
   }
 
   /// Returns true if this represents a valid @c Id.
-  [[nodiscard]] bool valid() const noexcept { return ptr_ && *ptr_ != InvalidFibreValue; }
+  [[nodiscard]] constexpr bool valid() const noexcept { return _value != InvalidFibreValue; }
 
   /// Returns true if the fibre associated with this @c Id is marked as running.
-  [[nodiscard]] bool running() const noexcept { return valid() && (*ptr_ & RunningBit); }
+  [[nodiscard]] bool running() const noexcept
+  {
+    return (state(std::memory_order_acquire) & detail::IdTable::RunningBit) != 0;
+  }
 
+  /// Returns true if the fibre associated with this @c Id has been marked for cancellation.
   [[nodiscard]] bool cancelled() const noexcept
   {
-    return valid() && ((*ptr_ & CancellationBit) != 0);
+    return (state(std::memory_order_relaxed) & detail::IdTable::CancellationBit) != 0;
   }
 
   /// Mark the fibre associated with this @c Id for cancellation. Once set this bit should not be
-  /// cleared. The fibre is cancelled the next time it is asked to resume.
-  void markForCancellation() noexcept { setBit(CancellationBit, true); }
+  /// cleared. The fibre is cancelled the next time it is asked to resume. A sleeping fibre parked
+  /// in a timing wheel is cancelled on its scheduler's next update - see
+  /// @c detail::CancellationRouter.
+  void markForCancellation() const noexcept;
 
 private:
-  /// Set the running state of this @c Id.
-  void setRunning(const bool running) noexcept { setBit(RunningBit, running); }
-
-  /// Helper function for setting one of the special bits.
-  void setBit(const uint64_t bit, bool on) noexcept
+  /// Load the slot state bits for this @c Id. Returns zero when the slot generation does not match.
+  [[nodiscard]] uint64_t state(std::memory_order order) const noexcept
   {
-    if (valid())
+    const detail::IdSlot *slot = detail::IdTable::find(*this);
+    if (!slot)
     {
-      if (on)
-      {
-        *ptr_ |= (bit & SpecialBits);
-      }
-      else
-      {
-        *ptr_ &= ~(bit & SpecialBits);
-      }
+      return 0;
     }
+    const uint64_t word = slot->state.load(order);
+    return ((word >> detail::IdTable::GenerationShift) == generation()) ?
+             (word & detail::IdTable::SpecialBits) :
+             0;
   }
 
-  friend class Fibre;
-
-  std::shared_ptr<IdValueType> ptr_;
+  IdValueType _value = InvalidFibreValue;
 };
 
 /// @c Id equality operator.
-inline bool operator==(const Id &lhs, const Id &rhs) noexcept
+inline constexpr bool operator==(const Id &lhs, const Id &rhs) noexcept
 {
   return lhs.id() == rhs.id();
 }
 
 /// @c Id inequality operator.
-inline bool operator!=(const Id &lhs, const Id &rhs) noexcept
+inline constexpr bool operator!=(const Id &lhs, const Id &rhs) noexcept
 {
   return lhs.id() != rhs.id();
 }
+
+namespace detail
+{
+inline IdSlot *IdTable::find(const Id &id) noexcept
+{
+  // Generation zero is never issued.
+  return (id.valid() && id.generation() != 0) ? find(id.index()) : nullptr;
+}
+}  // namespace detail
 }  // namespace morai
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace morai
+{
+template <typename Signature, std::size_t Capacity>
+class InlineFunction;
+
+/// A move only, type erased callable with fixed size inline storage. Never allocates.
+///
+/// This is a lightweight alternative to @c std::function for hot paths. The callable is stored in
+/// an internal buffer of @p Capacity bytes and constructing an @c InlineFunction from a callable
+/// which is too large, over-aligned or which may throw on move is a compile error. Trivially
+/// copyable callables - such as lambdas capturing only pointers, references and values - are moved
+/// with a plain memory copy.
+///
+/// As with @c std::function the call operator is @c const, but invokes the stored callable as
+/// non-const.
+///
+/// @tparam R The callable return type.
+/// @tparam Args The callable argument types.
+/// @tparam Capacity Inline storage capacity in bytes.
+template <typename R, typename... Args, std::size_t Capacity>
+class InlineFunction<R(Args...), Capacity>
+{
+public:
+  /// Inline storage capacity in bytes.
+  static constexpr std::size_t capacity = Capacity;
+
+  /// Create an empty function.
+  InlineFunction() noexcept = default;
+  /// Create an empty function.
+  InlineFunction(std::nullptr_t) noexcept {}
+
+  /// Create a function wrapping the callable @p func.
+  /// @param func The callable to store. Must fit within @c capacity bytes.
+  template <typename F>
+    requires(!std::is_same_v<std::remove_cvref_t<F>, InlineFunction> &&
+             std::is_invocable_r_v<R, std::decay_t<F> &, Args...>)
+  InlineFunction(F &&func) noexcept(std::is_nothrow_constructible_v<std::decay_t<F>, F &&>)
+  {
+    using Func = std::decay_t<F>;
+    static_assert(sizeof(Func) <= Capacity, "Callable is too large for InlineFunction storage");
+    static_assert(alignof(Func) <= alignof(std::max_align_t),
+                  "Callable is over-aligned for InlineFunction storage");
+    static_assert(std::is_nothrow_move_constructible_v<Func>,
+                  "InlineFunction callables must be nothrow move constructible");
+    ::new (static_cast<void *>(_storage)) Func(std::forward<F>(func));
+    _ops = &ops<Func>;
+  }
+
+  InlineFunction(InlineFunction &&other) noexcept { moveFrom(other); }
+
+  InlineFunction &operator=(InlineFunction &&other) noexcept
+  {
+    if (this != &other)
+    {
+      reset();
+      moveFrom(other);
+    }
+    return *this;
+  }
+
+  /// Clear the function.
+  InlineFunction &operator=(std::nullptr_t) noexcept
+  {
+    reset();
+    return *this;
+  }
+
+  InlineFunction(const InlineFunction &) = delete;
+  InlineFunction &operator=(const InlineFunction &) = delete;
+
+  ~InlineFunction() { reset(); }
+
+  /// Invoke the stored callable. The function must not be empty.
+  R operator()(Args... args) const
+  {
+    return _ops->invoke(static_cast<void *>(_storage), std::forward<Args>(args)...);
+  }
+
+  /// Check if the function holds a callable.
+  explicit operator bool() const noexcept { return _ops != nullptr; }
+
+  /// Destroy the stored callable, leaving the function empty.
+  void reset() noexcept
+  {
+    if (_ops && _ops->destroy)
+    {
+      _ops->destroy(static_cast<void *>(_storage));
+    }
+    _ops = nullptr;
+  }
+
+private:
+  /// Type erased operations for a stored callable.
+  struct Ops
+  {
+    R (*invoke)(void *storage, Args &&...args);
+    /// Size of the stored callable.
+    std::size_t size;
+    /// Move construct into @p dst then destroy @p src. Null for trivially copyable callables.
+    void (*relocate)(void *dst, void *src) noexcept;
+    /// Destroy the callable. Null for trivially destructible callables.
+    void (*destroy)(void *storage) noexcept;
+  };
+
+  template <typename Func>
+  static constexpr Ops ops = {
+    .invoke = [](void *storage, Args &&...args) -> R {
+      return std::invoke(*static_cast<Func *>(storage), std::forward<Args>(args)...);
+    },
+    .size = sizeof(Func),
+    .relocate = std::is_trivially_copyable_v<Func> ? nullptr :
+                                                     +[](void *dst, void *src) noexcept {
+                                                       auto *func = static_cast<Func *>(src);
+                                                       ::new (dst) Func(std::move(*func));
+                                                       func->~Func();
+                                                     },
+    .destroy = std::is_trivially_destructible_v<Func> ?
+                 nullptr :
+                 +[](void *storage) noexcept { static_cast<Func *>(storage)->~Func(); },
+  };
+
+  void moveFrom(InlineFunction &other) noexcept
+  {
+    if (!other._ops)
+    {
+      return;
+    }
+
+    if (other._ops->relocate)
+    {
+      other._ops->relocate(static_cast<void *>(_storage), static_cast<void *>(other._storage));
+    }
+    else
+    {
+      std::memcpy(_storage, other._storage, other._ops->size);
+    }
+    _ops = std::exchange(other._ops, nullptr);
+  }
+
+  /// Placed ahead of the storage so that empty checks touch the start of the object only.
+  const Ops *_ops = nullptr;
+  alignas(std::max_align_t) mutable std::byte _storage[Capacity];
+};
+}  // namespace morai
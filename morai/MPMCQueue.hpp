@@ -253,6 +253,45 @@ public:
     return try_emplace(std::forward<P>(v));
   }
 
+  /// Try to push up to count elements from in with a single claim on the head.
+  /// Only as many elements as there are leading free slots are pushed.
+  /// Returns the number of elements pushed.
+  size_t try_push_n(const T *in, size_t count) noexcept
+  {
+    static_assert(std::is_nothrow_copy_constructible<T>::value,
+                  "T must be nothrow copy constructible");
+    auto head = head_.load(std::memory_order_acquire);
+    for (;;)
+    {
+      size_t ready = 0;
+      while (ready < count && ready < capacity_ &&
+             turn(head + ready) * 2 ==
+               slots_[idx(head + ready)].turn.load(std::memory_order_acquire))
+      {
+        ++ready;
+      }
+      if (ready == 0)
+      {
+        auto const prevHead = head;
+        head = head_.load(std::memory_order_acquire);
+        if (head == prevHead)
+        {
+          return 0;
+        }
+      }
+      else if (head_.compare_exchange_strong(head, head + ready))
+      {
+        for (size_t i = 0; i < ready; ++i)
+        {
+          auto &slot = slots_[idx(head + i)];
+          slot.construct(in[i]);
+          slot.turn.store(turn(head + i) * 2 + 1, std::memory_order_release);
+        }
+        return ready;
+      }
+    }
+  }
+
   void pop(T &v) noexcept
   {
     auto const tail = tail_.fetch_add(1);
@@ -291,6 +330,43 @@ public:
     }
   }
 
+  /// Try to pop up to count consecutive elements into out with a single claim on
+  /// the tail. Only the leading elements which are ready are popped.
+  /// Returns the number of elements popped.
+  size_t try_pop_n(T *out, size_t count) noexcept
+  {
+    auto tail = tail_.load(std::memory_order_acquire);
+    for (;;)
+    {
+      size_t ready = 0;
+      while (ready < count && turn(tail + ready) * 2 + 1 ==
+                                slots_[idx(tail + ready)].turn.load(std::memory_order_acquire))
+      {
+        ++ready;
+      }
+      if (ready == 0)
+      {
+        auto const prevTail = tail;
+        tail = tail_.load(std::memory_order_acquire);
+        if (tail == prevTail)
+        {
+          return 0;
+        }
+      }
+      else if (tail_.compare_exchange_strong(tail, tail + ready))
+      {
+        for (size_t i = 0; i < ready; ++i)
+        {
+          auto &slot = slots_[idx(tail + i)];
+          out[i] = slot.move();
+          slot.destroy();
+          slot.turn.store(turn(tail + i) * 2 + 2, std::memory_order_release);
+        }
+        return ready;
+      }
+    }
+  }
+
   /// Returns the number of elements in the queue.
   /// The size can be negative when the queue is empty and there is at least one
   /// reader waiting. Since this is a concurrent queue the size is only a best
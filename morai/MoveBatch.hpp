@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Fibre.hpp"
+
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace morai
+{
+/// Collects fibres which requested a move to another scheduler - see @c ResumeMode::Move - so a
+/// scheduler can hand them over in bulk.
+///
+/// A scheduler pushes fibres as they request moves during an update, then calls @c flush(). The
+/// flush groups the fibres by target and moves each group with a single @c detail::MoveRequest
+/// call. A @c BatchSchedulerType target receives each group in one operation - e.g., a single
+/// atomic exchange for a @c Scheduler. Fibres keep their order within a group.
+///
+/// Not threadsafe. Each scheduler thread uses its own batch.
+class MoveBatch
+{
+public:
+  /// Check if there are no pending moves.
+  [[nodiscard]] bool empty() const noexcept { return _pending.empty(); }
+  /// Get the number of fibres pending a move.
+  [[nodiscard]] std::size_t size() const noexcept { return _pending.size(); }
+
+  /// Add a @p fibre which has requested a move.
+  void push(Fibre &&fibre) { _pending.emplace_back(std::move(fibre)); }
+
+  /// Move all pending fibres to their targets.
+  /// @param requeue Callable accepting a `Fibre &&` argument. Receives fibres the target declined.
+  /// These retain their requests and should be requeued to try again later.
+  template <typename Requeue>
+  void flush(Requeue &&requeue)
+  {
+    while (!_pending.empty())
+    {
+      // Take the fibres sharing the first fibre's target. Typically there is only one target.
+      const detail::MoveRequest key = request(_pending.front());
+      std::size_t kept = 0;
+      for (Fibre &fibre : _pending)
+      {
+        const detail::MoveRequest &next = request(fibre);
+        if (next.move == key.move && next.target == key.target)
+        {
+          _group.emplace_back(std::move(fibre));
+        }
+        else
+        {
+          _pending[kept++] = std::move(fibre);
+        }
+      }
+      _pending.resize(kept);
+
+      const std::size_t moved = key.move(key.target, _group);
+      for (Fibre &fibre : std::span{ _group }.subspan(moved))
+      {
+        requeue(std::move(fibre));
+      }
+      _group.clear();
+    }
+  }
+
+  /// Move a single @p fibre which has requested a move, bypassing the batch.
+  /// @return True on success, in which case the @p fibre becomes invalid.
+  static bool moveNow(Fibre &fibre)
+  {
+    const detail::MoveRequest &key = request(fibre);
+    return key.move(key.target, std::span{ &fibre, 1 }) == 1;
+  }
+
+  /// Destroy all pending fibres.
+  void clear() { _pending.clear(); }
+
+private:
+  [[nodiscard]] static detail::MoveRequest &request(Fibre &fibre)
+  {
+    return fibre.__handle().promise().frame.cold_state->move;
+  }
+
+  std::vector<Fibre> _pending;
+  /// Scratch buffer for the fibres moving to one target.
+  std::vector<Fibre> _group;
+};
+}  // namespace morai
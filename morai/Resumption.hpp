@@ -2,6 +2,8 @@
 
 #include "Common.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <chrono>
 
@@ -27,7 +29,10 @@ enum class ResumeMode : std::int8_t
   Continue,   ///< Fibre continued running come code - push back into the queue, may need
               ///< rescheduling.
   Sleep,      ///< Fibre is sleeping or waiting - push back into the queue.
-  Moved,      ///< Moved to another scheduler - do nothing more in the current scheduler.
+  Move,       ///< Requested a move to another scheduler. The fibre remains valid and the current
+              ///< scheduler must move it - see @c MoveBatch.
+  Parked,     ///< Parked on a waitable object such as an @c Event, which now owns the fibre. The
+              ///< fibre returns via its @c detail::Home when woken.
   Expire,     ///< Fibre has expired and requires cleanup - do nothing more.
   Exception,  ///< An exception was raised. Propagate or log the exception - do not reschedule.
 };
@@ -48,13 +53,39 @@ struct Resume
 /// or to use other supported @c co_await expressions - see @c Scheduler.
 struct Resumption
 {
-  /// Resumption time value. When set, this is specified as a relative time value. Internally this
-  /// value is converted into an absolute epoch time.
-  double time_s = 0;
+  /// Resumption deadline, zero for none. When set, this is specified as a relative duration in
+  /// nanoseconds. @c Fibre::resume() converts this into an absolute @c Clock::tick() value when the
+  /// fibre suspends, so deadlines are compared as integers from then on.
+  uint64_t deadline = 0;
   /// Optional condition to wait on before resuming.
   WaitCondition condition = {};
 };
 
+namespace detail
+{
+/// Convert a relative duration in seconds to a @c Resumption::deadline in whole nanoseconds. Zero
+/// or negative durations yield zero - no deadline. Positive durations yield at least 1ns.
+inline uint64_t toDeadline(const double duration_s) noexcept
+{
+  // Clamp to avoid undefined conversion of out of range values. This is several centuries.
+  constexpr double MaxDeadlineNs = 9e18;
+  if (!(duration_s > 0))
+  {
+    return 0;
+  }
+  const long long duration_ns = std::llround(std::min(duration_s * 1e9, MaxDeadlineNs));
+  return static_cast<uint64_t>(std::max(duration_ns, 1ll));
+}
+
+/// @overload
+template <typename Rep, typename Period>
+uint64_t toDeadline(const typename std::chrono::duration<Rep, Period> &duration) noexcept
+{
+  const auto duration_ns = std::chrono::ceil<std::chrono::nanoseconds>(duration).count();
+  return (duration_ns > 0) ? static_cast<uint64_t>(duration_ns) : 0u;
+}
+}  // namespace detail
+
 inline Priority reschedule(int32_t priority, PriorityPosition position = PriorityPosition::Back)
 {
   return { .priority = priority, .position = position };
@@ -99,13 +130,13 @@ inline Resumption yield()
 /// @param duration_s The sleep duration in seconds.
 inline Resumption sleep(const double duration_s)
 {
-  return Resumption{ .time_s = duration_s };
+  return Resumption{ .deadline = detail::toDeadline(duration_s) };
 }
 
 /// @overload
 inline Resumption sleep(const float duration_s)
 {
-  return Resumption{ .time_s = static_cast<double>(duration_s) };
+  return Resumption{ .deadline = detail::toDeadline(static_cast<double>(duration_s)) };
 }
 
 /// A helper function for specifying a sleep duration using a chrono duration.
@@ -128,7 +159,7 @@ inline Resumption sleep(const float duration_s)
 template <typename Rep, typename Period>
 Resumption sleep(const typename std::chrono::duration<Rep, Period> &duration)
 {
-  return { .time_s = std::chrono::duration<double>(duration).count() };
+  return { .deadline = detail::toDeadline(duration) };
 }
 
 /// A helper function for specifying a wait condition with optional timeout.
@@ -155,7 +186,7 @@ Resumption sleep(const typename std::chrono::duration<Rep, Period> &duration)
 /// @param timeout_s Optional timeout in seconds. Zero (or less) signifies no timeout.
 inline Resumption wait(WaitCondition condition, const double timeout_s = 0)
 {
-  return Resumption{ .time_s = timeout_s, .condition = std::move(condition) };
+  return Resumption{ .deadline = detail::toDeadline(timeout_s), .condition = std::move(condition) };
 }
 
 /// @overload
@@ -169,7 +200,7 @@ template <typename Rep, typename Period>
 Resumption wait(WaitCondition condition,
                 const typename std::chrono::duration<Rep, Period> &timeout_duration)
 {
-  return Resumption{ .time_s = std::chrono::duration<double>(timeout_duration).count(),
+  return Resumption{ .deadline = detail::toDeadline(timeout_duration),
                      .condition = std::move(condition) };
 }
 }  // namespace morai
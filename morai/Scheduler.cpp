@@ -1,21 +1,36 @@
 #include "Scheduler.hpp"
 
+#include "Finally.hpp"
 #include "Log.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <coroutine>
+#include <functional>
+#include <limits>
 
 namespace morai
 {
+namespace
+{
+/// Calculate the timing wheel granularity in ticks for the given @p resolution_s.
+uint64_t timerGranularity(const double resolution_s, const double quantisation)
+{
+  return static_cast<uint64_t>(std::max(std::llround(resolution_s / quantisation), 1ll));
+}
+}  // namespace
+
 Scheduler::Scheduler(SchedulerParams params, const ExceptionHandling exception_handling)
   : Scheduler{ Clock{}, std::move(params), exception_handling }
 {}
 
 Scheduler::Scheduler(Clock clock, SchedulerParams params,
                      const ExceptionHandling exception_handling)
-  : _move_queue(0, params.move_queue_size)
+  : _timers(timerGranularity(params.timer_resolution_s, clock.quantisation()))
   , _clock(std::move(clock))
   , _exception_handling(exception_handling)
+  , _poll_interval_s(params.poll_interval_s)
+  , _home(new detail::Home(&Scheduler::wakeFibre, this))
 {
   std::ranges::sort(params.priority_levels);
   // Ensure at least one queue.
@@ -28,18 +43,26 @@ Scheduler::Scheduler(Clock clock, SchedulerParams params,
   {
     _fibre_queues.emplace_back(priority_level, params.initial_queue_size);
   }
+  _cursors.resize(_fibre_queues.size());
+  detail::CancellationRouter::add(&_timers, &Scheduler::requestCancel, this);
 }
 
 Scheduler::Scheduler(Clock clock, ExceptionHandling exception_handling)
   : morai::Scheduler{ std::move(clock), SchedulerParams{}, exception_handling }
 {}
 
-Scheduler::~Scheduler() = default;
+Scheduler::~Scheduler()
+{
+  detail::CancellationRouter::remove(&_timers);
+  // Close first so fibres parked on external waitables are destroyed when woken rather than pushed
+  // into the inbox. This also covers joiners woken by destroying our own fibres below.
+  _home->close();
+  cancelAll();
+  _home->release();
+}
 
 Id Scheduler::start(Fibre &&fibre, int32_t priority, std::string_view name)
 {
-  // Fibre creation assigned the ID. We need to store it before moving the fibre.
-  Id fibre_id = fibre.id();
   fibre.__setPriority(priority);
   fibre.setName(name);
   return enqueue(std::move(fibre));
@@ -47,19 +70,27 @@ Id Scheduler::start(Fibre &&fibre, int32_t priority, std::string_view name)
 
 bool Scheduler::cancel(const Id fibre_id)
 {
-  if (!fibre_id.valid())
+  // Dispatch on the container recorded in the fibre's slot rather than searching each queue. The
+  // container validates the possibly stale location.
+  const detail::IdSlot *slot = detail::IdTable::find(fibre_id);
+  if (!slot)
   {
     return false;
   }
 
-  for (auto &queue : _fibre_queues)
+  const void *owner = slot->owner.load(std::memory_order_relaxed);
+  if (owner == &_timers)
   {
-    if (queue.cancel(fibre_id))
-    {
-      return true;
-    }
+    return _timers.cancel(fibre_id);
   }
-  return false;
+  const auto *queue = static_cast<const FibreQueue *>(owner);
+  const std::less<const FibreQueue *> before;
+  if (!owner || before(queue, _fibre_queues.data()) ||
+      !before(queue, _fibre_queues.data() + _fibre_queues.size()))
+  {
+    return false;
+  }
+  return _fibre_queues[static_cast<std::size_t>(queue - _fibre_queues.data())].cancel(fibre_id);
 }
 
 std::size_t Scheduler::cancel(std::span<const Id> fibre_ids)
@@ -78,52 +109,146 @@ void Scheduler::cancelAll()
   {
     queue.clear();
   }
-  _move_queue.clear();
+  std::ranges::fill(_cursors, 0);
+  _timers.clear();
+  _moves.clear();
+  _move_inbox.clear();
+  // Clear last - destroying fibres may wake joining fibres into the inbox.
+  _parked_count -= _inbox.clear();
 }
 
-void Scheduler::update()
+UpdateResult Scheduler::update(const UpdateBudget budget)
 {
   const double epoch_time_s = _clock.update();
   _time.dt = epoch_time_s - _time.epoch_time_s;
   _time.epoch_time_s = epoch_time_s;
+  const uint64_t tick = _clock.tick();
+
+  cancelSleepers();
+  wakeSleepers(tick);
+  pumpInbox();
+  pumpMoveInbox();
+
+  // Recounted as the queues are updated. See nextDeadline().
+  _ready_count = 0;
+  _poll_deadline = NoDeadline;
+
+  UpdateResult result;
+  const double deadline_s = epoch_time_s + budget.time_limit_s;
+  std::size_t index = 0;
+  while (index < _fibre_queues.size() && updateQueue(tick, index, budget, deadline_s, result))
+  {
+    ++index;
+  }
+
+  // Report the rest of the interrupted round, and the full rounds of the queues not reached.
+  for (; index < _fibre_queues.size(); ++index)
+  {
+    result.deferred += (_cursors[index] > 0) ? _cursors[index] : _fibre_queues[index].size();
+  }
+  // Deferred fibres are due next update.
+  _ready_count += result.deferred;
+
+  // Hand over fibres moving out together, one batch per target. Declined fibres retry next update.
+  _moves.flush(
+    [this](Fibre &&fibre) { push(selectQueue(fibre.priority(), true), std::move(fibre)); });
+  return result;
+}
+
+std::optional<double> Scheduler::nextDeadline() const
+{
+  const bool ready = _ready_count > 0 || !_inbox.empty() || !_move_inbox.empty() ||
+                     !_moves.empty() || _cancel_pending.load(std::memory_order_relaxed);
+  if (ready)
+  {
+    return _time.epoch_time_s;
+  }
+
+  std::optional<double> deadline_s;
+  if (std::ranges::any_of(_fibre_queues, [](const FibreQueue &queue) { return !queue.empty(); }))
+  {
+    // Only fibres polling wait conditions are queued. Poll again after the interval, or when the
+    // earliest wait times out.
+    deadline_s = std::min(_time.epoch_time_s + _poll_interval_s,
+                          static_cast<double>(_poll_deadline) * _clock.quantisation());
+  }
+  if (const std::optional<uint64_t> tick = _timers.nextExpiry())
+  {
+    const double expiry_s = static_cast<double>(*tick) * _clock.quantisation();
+    deadline_s = std::min(deadline_s.value_or(expiry_s), expiry_s);
+  }
+  return deadline_s;
+}
+
+void Scheduler::run()
+{
+  runUntil(std::numeric_limits<double>::infinity());
+}
 
-  for (auto &fibre_queue : _fibre_queues)
+bool Scheduler::runUntil(const double epoch_time_s)
+{
+  while (!_stop_requested.exchange(false, std::memory_order_acquire))
   {
-    updateQueue(epoch_time_s, fibre_queue);
+    update();
+    if (_time.epoch_time_s >= epoch_time_s)
+    {
+      return true;
+    }
+
+    const double wake_s = std::min(nextDeadline().value_or(epoch_time_s), epoch_time_s);
+    if (wake_s > _time.epoch_time_s)
+    {
+      waitUntil(wake_s);
+    }
   }
+  return false;
+}
+
+void Scheduler::stop()
+{
+  _stop_requested.store(true, std::memory_order_seq_cst);
+  notifyRunner();
 }
 
 bool Scheduler::move(Fibre &fibre, std::optional<int32_t> priority)
 {
-  // Grab the so that we only adjust the priority on success. The Fibre object will be invalid by
-  // then.
-  std::coroutine_handle<Fibre::promise_type> handle = fibre.__handle();
-  const bool pushed = _move_queue.tryPush(fibre);
-  if (pushed && priority)
+  // Set the priority before the push publishes the fibre to this scheduler.
+  if (priority)
   {
-    handle.promise().frame.priority = *priority;
+    fibre.__setPriority(*priority);
   }
-  return pushed;
+  _move_inbox.push(std::move(fibre));
+  notifyRunner();
+  return true;
+}
+
+std::size_t Scheduler::move(std::span<Fibre> fibres)
+{
+  _move_inbox.push(fibres);
+  notifyRunner();
+  return fibres.size();
 }
 
 Id Scheduler::enqueue(Fibre &&fibre)
 {
-  FibreQueue &fibres = selectQueue(fibre.priority(), false);
+  const std::size_t index = selectQueue(fibre.priority(), false);
   Id id = fibre.id();  // Cache Id before move.
-  fibres.push(std::move(fibre));
+  fibre.__setHome(_home);
+  push(index, std::move(fibre));
+  ++_ready_count;
   return id;
 }
 
-FibreQueue &Scheduler::selectQueue(int32_t priority, bool quiet)
+std::size_t Scheduler::selectQueue(int32_t priority, bool quiet)
 {
   size_t best_idx = 0;
 
   for (size_t i = 0; i < _fibre_queues.size(); ++i)
   {
-    FibreQueue &queue = _fibre_queues.at(i);
+    const FibreQueue &queue = _fibre_queues.at(i);
     if (priority == queue.priority())
     {
-      return queue;
+      return i;
     }
     else if (priority > queue.priority())
     {
@@ -135,43 +260,79 @@ FibreQueue &Scheduler::selectQueue(int32_t priority, bool quiet)
     }
   }
 
-  FibreQueue &queue = _fibre_queues.at(best_idx);
   if (!quiet)
   {
     log::error(std::format("Scheduler: Fibre priority mismatch: {} moved to {}", priority,
-                           queue.priority()));
+                           _fibre_queues.at(best_idx).priority()));
   }
 
-  return queue;
+  return best_idx;
+}
+
+void Scheduler::push(const std::size_t index, Fibre &&fibre, const PriorityPosition position)
+{
+  _fibre_queues[index].push(std::move(fibre), position);
+  // The round in progress covers the front of the queue, so a front insertion joins it. Fibres
+  // pushed to the back of a paused round join the next round, behind the fibres already resumed.
+  // The queue being updated takes in new fibres during the same update.
+  if (index == _active_queue || (position == PriorityPosition::Front && _cursors[index] > 0))
+  {
+    ++_cursors[index];
+  }
 }
 
-void Scheduler::updateQueue(const double epoch_time_s, FibreQueue &queue)
+bool Scheduler::updateQueue(const uint64_t tick, const std::size_t index,
+                            const UpdateBudget &budget, const double deadline_s,
+                            UpdateResult &result)
 {
-  // Move a pending item from the move queue.
-  pumpMoveQueue();
+  // A round updates each fibre in the queue once, counting down the cursor. The round may span
+  // multiple updates when the budget runs out. See push() for fibres added during the round.
+  FibreQueue &queue = _fibre_queues[index];
+  std::size_t &cursor = _cursors[index];
+  if (cursor == 0)
+  {
+    cursor = queue.size();
+  }
+  _active_queue = index;
+  const auto clear_active = finally([this]() { _active_queue = NoQueue; });
 
-  // Update N times where N is the size. Note the size may change during iteration as new fibres
-  // are added, or fibres removed. Expired fibres are not reinserted, so the size would shrink. We
-  // account for this by tracking expired_count. New fibres may cause unbounded growth.
-  size_t expired_count = 0;
-  for (size_t i = 0; i < queue.size() + expired_count; ++i)
+  const bool timed = std::isfinite(deadline_s);
+  for (; cursor > 0; --cursor)
   {
-    // On every iteration, we pump the move queue. It has limited capacity and hitting that capacity
-    // can cause deadlocks.
-    pumpMoveQueue();
+    if (result.resumed >= budget.max_resumes ||
+        (timed && result.resumed > 0 && _clock.now() >= deadline_s))
+    {
+      return false;
+    }
 
     Fibre fibre = queue.pop();
 
     if (!fibre.valid())
     {
+      // Cancelled hole.
       continue;
     }
 
-    const Resume resume = fibre.resume(epoch_time_s);
-    if (resume.mode == ResumeMode::Expire || resume.mode == ResumeMode::Moved) [[unlikely]]
+    const Resume resume = fibre.resume(tick, _clock.quantisation());
+    ++result.resumed;
+
+    if (resume.mode == ResumeMode::Expire) [[unlikely]]
     {
       // Expired. All done.
-      ++expired_count;
+      continue;
+    }
+
+    if (resume.mode == ResumeMode::Move) [[unlikely]]
+    {
+      // Moved out at the end of the update.
+      _moves.push(std::move(fibre));
+      continue;
+    }
+
+    if (resume.mode == ResumeMode::Parked)
+    {
+      // Now owned by a waitable object. Returns via the inbox.
+      ++_parked_count;
       continue;
     }
 
@@ -181,6 +342,8 @@ void Scheduler::updateQueue(const double epoch_time_s, FibreQueue &queue)
       std::exception_ptr ex = fibre.exception();
       if (_exception_handling == ExceptionHandling::Rethrow)
       {
+        // Account for this fibre before leaving the round.
+        --cursor;
         std::rethrow_exception(ex);
       }
 
@@ -201,40 +364,190 @@ void Scheduler::updateQueue(const double epoch_time_s, FibreQueue &queue)
         log::error(
           std::format("Scheduler fibre {}:{} unknown exception.", fibre.id().id(), fibre.name()));
       }
-      ++expired_count;
-      continue;  // Unreachable.
+      continue;
     }
 
+    std::size_t target_index = index;
+    PriorityPosition position = PriorityPosition::Back;
     if (resume.reschedule) [[unlikely]]
     {
       const Priority reschedule = *resume.reschedule;
       const int32_t initial_priority = fibre.priority();
       if (initial_priority != reschedule.priority)
       {
-        FibreQueue &new_queue = selectQueue(reschedule.priority, true);
-        if (&new_queue != &queue)
+        const std::size_t new_index = selectQueue(reschedule.priority, true);
+        if (new_index != index)
         {
           // Update fibre priority and reschedule.
           fibre.__setPriority(reschedule.priority);
-          new_queue.push(std::move(fibre), reschedule.position);
-          // "expired" in this context.
-          ++expired_count;
-          continue;
+          target_index = new_index;
+          position = reschedule.position;
         }
       }
     }
 
-    // Push the fibre back for the next update.
+    // Park sleeping fibres until they are due. This also covers fibres which have not been resumed.
+    if (tryPark(fibre, tick))
+    {
+      continue;
+    }
+
+    // Count the fibres due next update. Fibres waiting on a condition are only polled.
+    if (fibre.__waiting())
+    {
+      const uint64_t timeout_tick = fibre.__deadline();
+      if (timeout_tick > 0)
+      {
+        _poll_deadline = std::min(_poll_deadline, timeout_tick);
+      }
+    }
+    else
+    {
+      ++_ready_count;
+    }
+
+    if (target_index != index)
+    {
+      push(target_index, std::move(fibre), position);
+      continue;
+    }
+
+    // Push the fibre back for the next round. This must not extend the current round.
     queue.push(std::move(fibre));
   }
+  return true;
+}
+
+
+void Scheduler::pumpMoveInbox()
+{
+  _move_inbox.drain([this](Fibre &&fibre) { enqueue(std::move(fibre)); });
+}
+
+
+void Scheduler::wakeSleepers(const uint64_t tick)
+{
+  if (_timers.empty())
+  {
+    return;
+  }
+
+  _timers.advance(tick, _woken);
+  for (Fibre &fibre : _woken)
+  {
+    push(selectQueue(fibre.priority(), true), std::move(fibre));
+  }
+  _woken.clear();
+}
+
+
+bool Scheduler::tryPark(Fibre &fibre, const uint64_t tick)
+{
+  // Only pure sleeps are parked. Wait conditions must be polled.
+  const uint64_t deadline_tick = fibre.__deadline();
+  if (fibre.__waiting() || deadline_tick <= tick)
+  {
+    return false;
+  }
+
+  const Id id = fibre.id();
+  _timers.insert(std::move(fibre), deadline_tick);
+  // Pairs with the fence in Id::markForCancellation(): either the marking thread sees the wheel as
+  // the owner and routes to requestCancel(), or we see the mark here.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (id.cancelled())
+  {
+    _timers.cancel(id);
+  }
+  return true;
 }
 
 
-void Scheduler::pumpMoveQueue()
+void Scheduler::cancelSleepers()
 {
-  for (Fibre fibre = _move_queue.pop(); fibre.valid(); fibre = _move_queue.pop())
+  if (!_cancel_pending.load(std::memory_order_acquire))
   {
-    enqueue(std::move(fibre));
+    return;
+  }
+
+  std::vector<Id> requests;
+  {
+    const std::scoped_lock lock(_cancel_mutex);
+    requests.swap(_cancel_requests);
+    _cancel_pending.store(false, std::memory_order_relaxed);
+  }
+  // Fibres which have since woken are not found and expire when next resumed.
+  for (const Id &id : requests)
+  {
+    _timers.cancel(id);
+  }
+}
+
+
+void Scheduler::requestCancel(void *scheduler, const Id &id)
+{
+  auto *self = static_cast<Scheduler *>(scheduler);
+  {
+    const std::scoped_lock lock(self->_cancel_mutex);
+    self->_cancel_requests.emplace_back(id);
+    self->_cancel_pending.store(true, std::memory_order_seq_cst);
+  }
+  self->notifyRunner();
+}
+
+
+void Scheduler::pumpInbox()
+{
+  _parked_count -= _inbox.drain(
+    [this](Fibre &&fibre) { push(selectQueue(fibre.priority(), true), std::move(fibre)); });
+}
+
+
+void Scheduler::wakeFibre(void *scheduler, Fibre &&fibre)
+{
+  auto *self = static_cast<Scheduler *>(scheduler);
+  self->_inbox.push(std::move(fibre));
+  self->notifyRunner();
+}
+
+
+void Scheduler::waitUntil(const double epoch_time_s)
+{
+  std::unique_lock lock(_runner_mutex);
+  // Publish the waiting state, then check for work. Either this sees a push, or the pushing thread
+  // sees the waiting state - all sequentially consistent. See notifyRunner().
+  _runner_waiting.store(true, std::memory_order_seq_cst);
+  const auto woken = [this]() {
+    return _stop_requested.load(std::memory_order_seq_cst) ||
+           _cancel_pending.load(std::memory_order_seq_cst) ||
+           !_inbox.empty(std::memory_order_seq_cst) ||
+           !_move_inbox.empty(std::memory_order_seq_cst);
+  };
+
+  if (std::isinf(epoch_time_s))
+  {
+    _runner_cv.wait(lock, woken);
+  }
+  else
+  {
+    // Round up so as not to wake before the deadline and spin.
+    const auto wait_duration = std::chrono::ceil<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(epoch_time_s - _clock.now()));
+    _runner_cv.wait_for(lock, wait_duration, woken);
+  }
+  _runner_waiting.store(false, std::memory_order_relaxed);
+}
+
+
+void Scheduler::notifyRunner()
+{
+  if (_runner_waiting.load(std::memory_order_seq_cst))
+  {
+    // Lock so the notification cannot fall between the runner's check and its wait.
+    {
+      const std::scoped_lock lock(_runner_mutex);
+    }
+    _runner_cv.notify_one();
   }
 }
 }  // namespace morai
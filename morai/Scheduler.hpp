@@ -3,9 +3,16 @@
 #include "Clock.hpp"
 #include "Common.hpp"
 #include "FibreQueue.hpp"
-#include "SharedQueue.hpp"
+#include "FrameInbox.hpp"
+#include "MoveBatch.hpp"
+#include "TimerWheel.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
+#include <optional>
 #include <span>
 #include <string_view>
 
@@ -87,6 +94,18 @@ namespace morai
 ///   @c Scheduler. New fibres are updated on the *next* @c update() call.
 /// - Fibres may cancel other fibres in the same @c Scheduler. This prevents any further updates of
 ///   the target fibre.
+/// - Sleeping fibres - `co_await <duration>;` or @c sleep() - are parked in a @c TimerWheel and
+///   cost nothing per @c update() until they are due. The wheel resolution is set by
+///   @c SchedulerParams::timer_resolution_s. A sleeping fibre flagged via
+///   @c Id::markForCancellation() is cancelled on the next @c update(). Wait conditions - including
+///   those with a timeout - are still polled every update.
+/// - Fibres awaiting an @c Event are parked on the event and cost nothing per @c update() until
+///   the event is set. Parked fibres count towards @c runningCount().
+/// - An @c UpdateBudget bounds the work done by an @c update() call, such as to hold a frame rate.
+///   Fibres left over resume first on the next @c update().
+/// - @c run() and @c runUntil() update in a loop, blocking while no fibre is due. The thread wakes
+///   for the next sleeping fibre, a @c move() or an @c Event woken fibre - see @c nextDeadline().
+///   Wait conditions are polled at the @c SchedulerParams::poll_interval_s while blocking.
 class Scheduler
 {
 public:
@@ -105,6 +124,9 @@ public:
   /// Returns true if there are no running fibres.
   [[nodiscard]] bool empty() const noexcept { return runningCount() == 0; }
   /// Returns the number of running fibres regardless of suspended state.
+  ///
+  /// Fibres moved in by @c move() are not counted individually until the next @c update() drains
+  /// them. Until then any number of pending moves counts as one, so @c empty() remains accurate.
   [[nodiscard]] std::size_t runningCount() const noexcept
   {
     std::size_t count = 0;
@@ -112,7 +134,7 @@ public:
     {
       count += queue.size();
     }
-    return count + _move_queue.size();
+    return count + !_move_inbox.empty() + _moves.size() + _timers.size() + _parked_count;
   }
 
   /// get the internal time value. Based on the last @c update() call.
@@ -160,6 +182,8 @@ public:
   /// Unlike @c Id::markForCancellation(), this function immediately cancels the fibre, but only if
   /// it is managed by this scheduler.
   ///
+  /// The fibre is located directly via its @c Id slot rather than by searching the queues.
+  ///
   /// @param fibre_id @c Id of the fibre to cancel.
   /// @return True if a fibre matching the @p fibre_id was found an cancelled.
   bool cancel(Id fibre_id);
@@ -175,34 +199,164 @@ public:
   /// defined, but must be monotonically increasing.
   /// @c std::chrono::system_clock::now().time_since_epoch() makes for a
   /// reasonable default.
-  void update();
+  ///
+  /// The @p budget limits the number of fibres resumed. Queues are visited in priority order and
+  /// each keeps a cursor into its current round, so when the budget runs out the next update
+  /// resumes the remaining fibres of that round. Higher priority queues start a new round every
+  /// update, before any lower priority queue continues, so lower priority work is deferred first.
+  ///
+  /// Sleeping, woken and moved fibres are always collected into the queues, regardless of budget.
+  ///
+  /// @param budget Limits on the work done by this update. Unlimited by default.
+  /// @return The number of fibres resumed and deferred.
+  UpdateResult update(UpdateBudget budget = {});
+  /// @overload
+  UpdateResult update(std::size_t max_resumes)
+  {
+    return update(UpdateBudget{ .max_resumes = max_resumes });
+  }
+  /// @overload
+  template <typename Rep, typename Period>
+  UpdateResult update(std::chrono::duration<Rep, Period> time_limit)
+  {
+    return update(
+      UpdateBudget{ .time_limit_s = std::chrono::duration<double>(time_limit).count() });
+  }
+
+  /// Get the epoch time at which the next fibre is due (seconds), in the same time base as
+  /// @c time().
+  ///
+  /// This is the last @c update() time when any fibre is ready to resume, including fibres moved or
+  /// woken in since. Fibres polling a wait condition are not counted as ready. While any are
+  /// queued the deadline is at most @c SchedulerParams::poll_interval_s after the last update, or
+  /// the earliest wait timeout if sooner. Otherwise it is the earliest sleep expiry, rounded down
+  /// to the @c SchedulerParams::timer_resolution_s.
+  ///
+  /// @return The next deadline, or @c std::nullopt if there are only fibres parked on waitable
+  /// objects, or none at all.
+  [[nodiscard]] std::optional<double> nextDeadline() const;
+
+  /// Update fibres until @c stop() is called, blocking while no fibre is due.
+  ///
+  /// The thread sleeps until the @c nextDeadline(), or until another thread moves a fibre in or
+  /// wakes a parked fibre - e.g., via @c Event::set(). An idle scheduler thus consumes no CPU.
+  /// Fibres polling wait conditions are polled every @c SchedulerParams::poll_interval_s while
+  /// nothing else is due.
+  ///
+  /// Blocking assumes the @c clock() advances in real time seconds, as the default @c Clock does.
+  /// Other threads must use @c move() rather than @c start() as the scheduler is not threadsafe.
+  void run();
+
+  /// Update fibres as per @c run() until the @c clock() reaches @p epoch_time_s or @c stop() is
+  /// called. This makes for a frame loop which sleeps between frames, but still resumes fibres
+  /// due within the frame.
+  ///
+  /// @param epoch_time_s The @c clock() time at which to return.
+  /// @return True if the time was reached, false if stopped.
+  bool runUntil(double epoch_time_s);
+
+  /// Make the current, or the next, @c run() or @c runUntil() call return after its current
+  /// @c update() (threadsafe). May be called from a fibre.
+  void stop();
 
   /// Move a fibre into this scheduler (threadsafe). This implements the scheduler move operations.
   ///
-  /// On success the @p fibre coroutine handle is moved out of the @p fibre object into a new
-  /// @c Fibre object, invalidating the @p fibre argument. On failure @p fibre remains valid.
-  /// Success is indicated by the return value.
+  /// The @p fibre coroutine handle is moved out of the @p fibre object, invalidating the @p fibre
+  /// argument. This never fails.
   ///
-  /// The fibre is added to a threadsafe queue which is drained during @c update(). This places the
-  /// fibre into the most appropriate priority queue (lower bound). Note that deadlocks may be
-  /// possible as the threadsafe queue blocks when full.
+  /// The fibre is pushed into a lock free inbox, costing a single atomic exchange. The inbox is
+  /// drained once at the start of each @c update(), placing the fibre into the most appropriate
+  /// priority queue (lower bound).
   ///
   /// @param fibre A reference to the fibre to move.
-  /// @return True on success, in which case the @p fibre argument becomes invalid.
+  /// @return True. The @p fibre argument becomes invalid.
   bool move(Fibre &fibre, std::optional<int32_t> priority = std::nullopt);
 
+  /// Move @p fibres into this scheduler with a single atomic exchange (threadsafe). The fibres keep
+  /// their current priorities. See @c BatchSchedulerType.
+  ///
+  /// @param fibres The fibres to move. All become invalid.
+  /// @return The number of fibres moved - always @c fibres.size().
+  std::size_t move(std::span<Fibre> fibres);
+
 private:
+  static constexpr std::size_t NoQueue = ~std::size_t{ 0 };
+  /// @c _poll_deadline value when no polling fibre has a timeout.
+  static constexpr uint64_t NoDeadline = ~uint64_t{ 0 };
+
   Id enqueue(Fibre &&fibre);
 
-  FibreQueue &selectQueue(int32_t priority, bool quiet);
-  void updateQueue(double epoch_time_s, FibreQueue &queue);
+  /// Select the index of the queue matching @p priority (lower bound).
+  [[nodiscard]] std::size_t selectQueue(int32_t priority, bool quiet);
+  /// Push a @p fibre into the queue at @p index, extending its current round if the fibre joins it.
+  void push(std::size_t index, Fibre &&fibre, PriorityPosition position = PriorityPosition::Back);
+  /// Update the queue at @p index until its current round completes or the @p budget runs out.
+  /// @return True if the round completed.
+  bool updateQueue(uint64_t tick, std::size_t index, const UpdateBudget &budget, double deadline_s,
+                   UpdateResult &result);
 
-  void pumpMoveQueue();
+  /// Move fibres from the @c _move_inbox into the ready queues.
+  void pumpMoveInbox();
+  /// Move fibres from the timing wheel into the ready queues once their sleep expires.
+  void wakeSleepers(uint64_t tick);
+  /// Park the @p fibre in the timing wheel if it is purely sleeping beyond @p tick.
+  [[nodiscard]] bool tryPark(Fibre &fibre, uint64_t tick);
+  /// Cancel sleeping fibres in the @c _cancel_requests.
+  void cancelSleepers();
+  /// @c detail::CancellationRouter handler. Queues @p id in the @c _cancel_requests (threadsafe).
+  static void requestCancel(void *scheduler, const Id &id);
+  /// Move woken fibres from the @c _inbox into the ready queues.
+  void pumpInbox();
+  /// @c detail::Home wake function. Pushes the @p fibre into the @c _inbox (threadsafe).
+  static void wakeFibre(void *scheduler, Fibre &&fibre);
+  /// Block until the @c clock() reaches @p epoch_time_s, or until woken by @c notifyRunner().
+  void waitUntil(double epoch_time_s);
+  /// Wake a thread blocked in @c waitUntil(), if any (threadsafe). Call after publishing work.
+  void notifyRunner();
 
   std::vector<FibreQueue> _fibre_queues;
-  SharedQueue _move_queue;
+  /// Number of fibres left in the current round of each queue, parallel to @c _fibre_queues. Zero
+  /// when the round is complete, in which case the next update starts a new round.
+  std::vector<std::size_t> _cursors;
+  /// Index of the queue being updated, or @c NoQueue outside @c updateQueue().
+  std::size_t _active_queue = NoQueue;
+  /// Receives fibres moved in from other schedulers, possibly from other threads. See @c move().
+  FrameInbox _move_inbox;
+  /// Fibres moving out to other schedulers. Collected during @c update() and flushed at the end.
+  MoveBatch _moves;
+  /// Parks sleeping fibres until they are due. See @c tryPark().
+  TimerWheel _timers;
+  /// Scratch buffer for fibres expiring from @c _timers.
+  std::vector<Fibre> _woken;
+  /// Ids of sleeping fibres marked for cancellation, possibly from other threads. Guarded by
+  /// @c _cancel_mutex.
+  std::vector<Id> _cancel_requests;
+  /// Set while @c _cancel_requests is not empty.
+  std::atomic_bool _cancel_pending{ false };
+  std::mutex _cancel_mutex;
+  /// Receives fibres woken from a waitable object, such as an @c Event, possibly from other
+  /// threads.
+  FrameInbox _inbox;
+  /// Number of fibres parked on waitable objects. These are owned by the waitable objects.
+  std::size_t _parked_count = 0;
   Time _time{};
   Clock _clock{};
   ExceptionHandling _exception_handling = ExceptionHandling::Log;
+  /// See @c SchedulerParams::poll_interval_s.
+  double _poll_interval_s = 1e-3;
+  /// Number of queued fibres due next update, counted by the last @c update() and by @c start().
+  /// May overcount after @c cancel(), costing an extra update. Excludes fibres polling a wait
+  /// condition.
+  std::size_t _ready_count = 0;
+  /// Earliest timeout tick of the fibres polling a wait condition, or @c NoDeadline.
+  uint64_t _poll_deadline = NoDeadline;
+  /// Home assigned to our fibres. We hold one reference, parked fibres hold the others.
+  detail::Home *_home = nullptr;
+  /// Set while a @c run() loop is blocked, or about to block, in @c waitUntil().
+  std::atomic_bool _runner_waiting{ false };
+  /// Set by @c stop(). Cleared when a @c run() loop returns.
+  std::atomic_bool _stop_requested{ false };
+  std::mutex _runner_mutex;
+  std::condition_variable _runner_cv;
 };
 }  // namespace morai
@@ -0,0 +1,334 @@
+#include "Scope.hpp"
+
+#include "Log.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <mutex>
+
+namespace morai
+{
+namespace
+{
+using Handle = std::coroutine_handle<Fibre::promise_type>;
+
+/// Intrusive FIFO list of parked fibres, linked via @c detail::Frame::link.
+struct WaiterList
+{
+  void *head = nullptr;
+  void *tail = nullptr;
+
+  [[nodiscard]] bool empty() const noexcept { return head == nullptr; }
+
+  void push(Handle handle) noexcept
+  {
+    handle.promise().frame.link = nullptr;
+    if (tail)
+    {
+      Handle::from_address(tail).promise().frame.link = handle.address();
+    }
+    else
+    {
+      head = handle.address();
+    }
+    tail = handle.address();
+  }
+
+  /// Detach the first waiter only.
+  [[nodiscard]] void *popFront() noexcept
+  {
+    void *front = head;
+    head = std::exchange(Handle::from_address(front).promise().frame.link, nullptr);
+    tail = (head) ? tail : nullptr;
+    return front;
+  }
+
+  /// Detach all waiters.
+  [[nodiscard]] void *take() noexcept
+  {
+    tail = nullptr;
+    return std::exchange(head, nullptr);
+  }
+
+  /// Detach the waiter with the given @p id.
+  /// @return The detached waiter, or null if not found.
+  [[nodiscard]] void *remove(const Id &id) noexcept
+  {
+    void *previous = nullptr;
+    for (void *waiter = head; waiter;)
+    {
+      detail::Frame &frame = Handle::from_address(waiter).promise().frame;
+      if (frame.id == id)
+      {
+        void *next = std::exchange(frame.link, nullptr);
+        if (previous)
+        {
+          Handle::from_address(previous).promise().frame.link = next;
+        }
+        else
+        {
+          head = next;
+        }
+        tail = (tail == waiter) ? previous : tail;
+        return waiter;
+      }
+      previous = waiter;
+      waiter = frame.link;
+    }
+    return nullptr;
+  }
+};
+
+/// Wake a detached list of waiters via their @c detail::Home.
+void wakeAll(void *head) noexcept
+{
+  while (head)
+  {
+    Handle handle = Handle::from_address(head);
+    head = std::exchange(handle.promise().frame.link, nullptr);
+    detail::IdTable::clearParked(handle.promise().frame.id);
+    handle.promise().frame.home->wake(Fibre{ handle });
+  }
+}
+
+/// Check the fibre can be woken, logging an error if not.
+bool canPark(Fibre &fibre)
+{
+  if (!fibre.__handle().promise().frame.home) [[unlikely]]
+  {
+    log::error(std::format("Scope: fibre {}:{} has no scheduler to wake into", fibre.id().id(),
+                           fibre.name()));
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+struct Scope::State
+{
+  /// Reference count: one for the scope plus one per running child.
+  std::atomic<uint32_t> references{ 1 };
+  /// Number of running children.
+  std::atomic<int64_t> running{ 0 };
+  /// Number of completions not yet consumed by @c whenAny().
+  std::atomic<int64_t> completed{ 0 };
+  /// Number of fibres in @c any_waiters, readable without the lock. Only modified under the
+  /// @c mutex.
+  std::atomic<int64_t> any_waiting{ 0 };
+  std::mutex mutex;
+  WaiterList all_waiters;
+  WaiterList any_waiters;
+
+  void release() noexcept
+  {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      delete this;
+    }
+  }
+
+  /// Consume a completion, if any.
+  bool consumeCompletion() noexcept
+  {
+    int64_t completions = completed.load(std::memory_order_seq_cst);
+    while (completions > 0)
+    {
+      if (completed.compare_exchange_weak(completions, completions - 1, std::memory_order_seq_cst))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Try consume a completion for @c whenAny(). Returns true if a completion was consumed or there
+  /// are no running children.
+  bool tryConsume() noexcept
+  {
+    return consumeCompletion() || running.load(std::memory_order_acquire) == 0;
+  }
+};
+
+Scope::Scope(void *scheduler, StartFunction start, CancelFunction cancel)
+  : _scheduler(scheduler)
+  , _start(start)
+  , _cancel(cancel)
+  , _state(new State)
+{}
+
+Scope::~Scope()
+{
+  cancel();
+  _state->release();
+}
+
+Id Scope::start(Fibre &&fibre, int32_t priority, std::string_view name)
+{
+  if (!fibre.valid())
+  {
+    return {};
+  }
+
+  // Count before starting as the child may complete on another thread immediately.
+  _state->references.fetch_add(1, std::memory_order_relaxed);
+  _state->running.fetch_add(1, std::memory_order_acq_rel);
+  fibre.__setCompletion({ .notify = &Scope::complete, .context = _state });
+
+  if (_children.size() == _children.capacity())
+  {
+    std::erase_if(_children, [](const Id &id) { return !id.running(); });
+  }
+  const Id id = _start(_scheduler, std::move(fibre), priority, name);
+  _children.emplace_back(id);
+  return id;
+}
+
+std::size_t Scope::runningCount() const noexcept
+{
+  return static_cast<std::size_t>(_state->running.load(std::memory_order_acquire));
+}
+
+void Scope::cancel()
+{
+  // Detach the list first as cancelling destroys fibres, which may run arbitrary code.
+  const std::vector<Id> children = std::exchange(_children, {});
+  for (const Id &id : children)
+  {
+    // Mark first so a child which is parking concurrently declines, and a sleeping child is routed
+    // out of a ThreadPool timing wheel.
+    id.markForCancellation();
+    _cancel(_scheduler, id);
+    // Hand a parked child back to its scheduler, which expires it.
+    wakeAll(detail::IdTable::unpark(id));
+  }
+}
+
+Fibre::ParkAwaitable Scope::whenAll()
+{
+  return { .parker = { .park = &Scope::parkAll, .context = _state },
+           .ready = _state->running.load(std::memory_order_acquire) == 0 };
+}
+
+Fibre::ParkAwaitable Scope::whenAny()
+{
+  // Consume on co_await rather than here.
+  return { .parker = { .park = &Scope::parkAny, .context = _state },
+           .try_ready = &Scope::readyAny };
+}
+
+void Scope::complete(void *state_ptr) noexcept
+{
+  auto *state = static_cast<State *>(state_ptr);
+  const bool last = state->running.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  if (!last)
+  {
+    // Not the last child. Publish the completion, then check for whenAny() waiters. Pairs with
+    // parkAny(), which counts itself waiting before checking for completions, so either we see the
+    // waiter or it sees the completion.
+    state->completed.fetch_add(1, std::memory_order_seq_cst);
+    if (state->any_waiting.load(std::memory_order_seq_cst) == 0)
+    {
+      state->release();
+      return;
+    }
+  }
+
+  void *wake_all = nullptr;
+  void *wake_any = nullptr;
+  {
+    const std::scoped_lock guard(state->mutex);
+    if (last)
+    {
+      // Nothing left to wait for. Wake everything. The last completion is consumed by the woken
+      // whenAny() waiters, if any.
+      wake_all = state->all_waiters.take();
+      wake_any = state->any_waiters.take();
+      state->any_waiting.store(0, std::memory_order_relaxed);
+      state->completed.fetch_add(wake_any ? 0 : 1, std::memory_order_release);
+    }
+    else if (!state->any_waiters.empty() && state->consumeCompletion())
+    {
+      // Hand a completion to the first waiter. It may already have been consumed elsewhere.
+      wake_any = state->any_waiters.popFront();
+      state->any_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  wakeAll(wake_all);
+  wakeAll(wake_any);
+  state->release();
+}
+
+bool Scope::parkAll(void *state_ptr, Fibre &fibre)
+{
+  auto *state = static_cast<State *>(state_ptr);
+  if (!canPark(fibre))
+  {
+    return false;
+  }
+
+  const Id id = fibre.id();
+  detail::IdTable::setParked(id, { .unpark = &Scope::unparkAll, .context = state });
+  std::unique_lock guard(state->mutex);
+  // Check again under lock - children may have completed since co_await. Also decline once marked
+  // for cancellation as a Scope may have failed to find us to unpark.
+  if (id.cancelled() || state->running.load(std::memory_order_acquire) == 0)
+  {
+    guard.unlock();
+    detail::IdTable::clearParked(id);
+    return false;
+  }
+  state->all_waiters.push(fibre.__release());
+  return true;
+}
+
+bool Scope::readyAny(void *state) noexcept
+{
+  return static_cast<State *>(state)->tryConsume();
+}
+
+bool Scope::parkAny(void *state_ptr, Fibre &fibre)
+{
+  auto *state = static_cast<State *>(state_ptr);
+  if (!canPark(fibre))
+  {
+    return false;
+  }
+
+  const Id id = fibre.id();
+  detail::IdTable::setParked(id, { .unpark = &Scope::unparkAny, .context = state });
+  std::unique_lock guard(state->mutex);
+  // Count as waiting before checking again - a child may have completed since co_await. See
+  // complete().
+  state->any_waiting.fetch_add(1, std::memory_order_seq_cst);
+  if (id.cancelled() || state->tryConsume())
+  {
+    state->any_waiting.fetch_sub(1, std::memory_order_relaxed);
+    guard.unlock();
+    detail::IdTable::clearParked(id);
+    return false;
+  }
+  state->any_waiters.push(fibre.__release());
+  return true;
+}
+
+void *Scope::unparkAll(void *state_ptr, const Id &id)
+{
+  auto *state = static_cast<State *>(state_ptr);
+  const std::scoped_lock guard(state->mutex);
+  return state->all_waiters.remove(id);
+}
+
+void *Scope::unparkAny(void *state_ptr, const Id &id)
+{
+  auto *state = static_cast<State *>(state_ptr);
+  const std::scoped_lock guard(state->mutex);
+  void *waiter = state->any_waiters.remove(id);
+  if (waiter)
+  {
+    state->any_waiting.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return waiter;
+}
+}  // namespace morai
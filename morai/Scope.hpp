@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Fibre.hpp"
+
+#include <concepts>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace morai
+{
+/// A structured concurrency scope - or nursery - which owns a group of child fibres.
+///
+/// Children are started on a @c Scheduler or @c ThreadPool via the scope, and the scope tracks
+/// their completion using an atomic countdown, notified as each child is destroyed. A fibre may
+/// then `co_await scope.whenAll();` or `co_await scope.whenAny();` to park until children
+/// complete. The awaiting fibre is woken once, rather than polling each child @c Id every update.
+///
+/// @code
+/// morai::Fibre batch(morai::ThreadPool &pool, std::vector<Job> &jobs)
+/// {
+///   morai::Scope scope{ pool };
+///   for (Job &job : jobs)
+///   {
+///     scope.start(runJob(job));
+///   }
+///   co_await scope.whenAll();
+/// }
+/// @endcode
+///
+/// Destroying the scope - e.g., leaving the block which declares it - cancels any remaining
+/// children. Queued and sleeping children are removed from a @c Scheduler immediately. Children
+/// parked on an @c Event, a join or another scope are detached and handed back to their scheduler,
+/// which expires them on its next update. Remaining children, such as those in a @c ThreadPool, are
+/// marked via @c Id::markForCancellation() and expire when next visited. Children are not waited
+/// on and may be cleaned up by their scheduler after the scope is gone.
+///
+/// @c start(), @c cancel() and the destructor must be called from a thread which may start fibres
+/// on the target scheduler. Children may complete on any thread and awaiting fibres may belong to
+/// any scheduler.
+class Scope
+{
+public:
+  /// Create a scope which starts children on the given @p scheduler.
+  /// @param scheduler The @c Scheduler or @c ThreadPool to start children on. Must outlive the
+  /// scope.
+  template <typename Scheduler>
+    requires requires(Scheduler &scheduler, Fibre &&fibre, int32_t priority,
+                      std::string_view name) {
+      { scheduler.start(std::move(fibre), priority, name) } -> std::same_as<Id>;
+    }
+  explicit Scope(Scheduler &scheduler)
+    : Scope(&scheduler, &Scope::startOn<Scheduler>, &Scope::cancelOn<Scheduler>)
+  {}
+
+  /// Destructor - cancels any remaining children.
+  ~Scope();
+
+  Scope(const Scope &) = delete;
+  Scope(Scope &&) = delete;
+  Scope &operator=(const Scope &) = delete;
+  Scope &operator=(Scope &&) = delete;
+
+  /// Start a child fibre in the scope's scheduler.
+  /// @param fibre The fibre entry point.
+  /// @param priority Scheduling priority.
+  /// @param name Optional name.
+  /// @return The child fibre @c Id.
+  Id start(Fibre &&fibre, int32_t priority = 0, std::string_view name = {});
+  /// @overload
+  Id start(Fibre &&fibre, std::string_view name) { return start(std::move(fibre), 0, name); }
+
+  /// Returns the number of children which have yet to complete.
+  [[nodiscard]] std::size_t runningCount() const noexcept;
+
+  /// Check if all children have completed.
+  [[nodiscard]] bool empty() const noexcept { return runningCount() == 0; }
+
+  /// Cancel all remaining children. See class documentation.
+  void cancel();
+
+  /// Create an awaitable which resumes once all children have completed.
+  ///
+  /// Does not suspend when there are no running children.
+  [[nodiscard]] Fibre::ParkAwaitable whenAll();
+
+  /// Create an awaitable which resumes once any child completes.
+  ///
+  /// Each completion is consumed by a single @c co_await of @c whenAny(), so awaiting @c whenAny()
+  /// once per child resumes once per child completion. Creating the awaitable consumes nothing.
+  /// Completions which occur while there are no @c whenAny() waiters are retained for the next
+  /// @c whenAny(). Does not suspend when there are no running children.
+  [[nodiscard]] Fibre::ParkAwaitable whenAny();
+
+private:
+  /// Shared state referenced by the scope and all running children.
+  struct State;
+
+  using StartFunction = Id (*)(void *scheduler, Fibre &&fibre, int32_t priority,
+                               std::string_view name);
+
+  using CancelFunction = void (*)(void *scheduler, const Id &id);
+
+  Scope(void *scheduler, StartFunction start, CancelFunction cancel);
+
+  template <typename Scheduler>
+  static Id startOn(void *scheduler, Fibre &&fibre, int32_t priority, std::string_view name)
+  {
+    return static_cast<Scheduler *>(scheduler)->start(std::move(fibre), priority, name);
+  }
+
+  /// Cancel the fibre @p id immediately on schedulers which support it - i.e., @c Scheduler.
+  template <typename Scheduler>
+  static void cancelOn([[maybe_unused]] void *scheduler, [[maybe_unused]] const Id &id)
+  {
+    if constexpr (requires(Scheduler &target) { target.cancel(id); })
+    {
+      static_cast<Scheduler *>(scheduler)->cancel(id);
+    }
+  }
+
+  /// @c detail::Completion implementation.
+  static void complete(void *state) noexcept;
+  /// @c detail::Parker implementation for @c whenAll().
+  static bool parkAll(void *state, Fibre &fibre);
+  /// @c Fibre::ParkAwaitable::try_ready implementation for @c whenAny(). Consumes a completion.
+  static bool readyAny(void *state) noexcept;
+  /// @c detail::Parker implementation for @c whenAny().
+  static bool parkAny(void *state, Fibre &fibre);
+  /// @c detail::Unparker implementation for @c whenAll().
+  static void *unparkAll(void *state, const Id &id);
+  /// @c detail::Unparker implementation for @c whenAny().
+  static void *unparkAny(void *state, const Id &id);
+
+  void *_scheduler = nullptr;
+  StartFunction _start = nullptr;
+  CancelFunction _cancel = nullptr;
+  State *_state = nullptr;
+  /// Child fibre @c Ids for cancellation. Completed children are pruned as this grows.
+  std::vector<Id> _children;
+};
+}  // namespace morai
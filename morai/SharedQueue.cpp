@@ -1,8 +1,28 @@
 #include "SharedQueue.hpp"
+
+#include <algorithm>
+#include <array>
+
 namespace morai
 {
-SharedQueue::SharedQueue(int32_t priority, uint32_t capacity)
-  : _queue{ capacity }
+namespace
+{
+using Handle = std::coroutine_handle<Fibre::promise_type>;
+
+/// Chunk size for bulk operations. Handles are staged on the stack to avoid allocating.
+constexpr std::size_t ChunkSize = 16;
+}  // namespace
+
+SharedQueue::SharedQueue(int32_t priority, uint32_t capacity, SharedQueueParams params)
+  : _queue{ [&]() -> std::variant<PaddedQueue, CompactQueue> {
+    // Neither queue is movable. Returning prvalues constructs the selected queue in place.
+    if (params.layout == SharedQueueLayout::Compact)
+    {
+      return std::variant<PaddedQueue, CompactQueue>{ std::in_place_type<CompactQueue>, capacity,
+                                                      params.slot_size };
+    }
+    return std::variant<PaddedQueue, CompactQueue>{ std::in_place_type<PaddedQueue>, capacity };
+  }() }
   , _priority{ priority }
 {}
 
@@ -12,23 +32,86 @@ SharedQueue::~SharedQueue()
   clear();
 }
 
+std::size_t SharedQueue::size() const
+{
+  if (const auto *compact = std::get_if<CompactQueue>(&_queue))
+  {
+    return compact->size();
+  }
+  return static_cast<std::size_t>(std::max<ptrdiff_t>(std::get<PaddedQueue>(_queue).size(), 0));
+}
+
 bool SharedQueue::tryPush(Fibre &fibre)
 {
-  auto handle = fibre.__handle();
-  // Must copy the idea to avoid self move.
-  Id id = handle.promise().frame.id;
-  if (_queue.try_emplace(handle))
+  const Handle handle = fibre.__handle();
+  bool pushed = false;
+  if (auto *compact = std::get_if<CompactQueue>(&_queue))
+  {
+    pushed = compact->tryPush(handle.address());
+  }
+  else
+  {
+    pushed = std::get<PaddedQueue>(_queue).try_emplace(handle);
+  }
+
+  if (pushed)
   {
     fibre.__release();
-    return true;
   }
-  return false;
+  return pushed;
+}
+
+std::size_t SharedQueue::tryPush(std::span<Fibre> fibres)
+{
+  std::size_t pushed = 0;
+  while (pushed < fibres.size())
+  {
+    const std::size_t chunk = std::min(ChunkSize, fibres.size() - pushed);
+    std::size_t count = 0;
+    if (auto *compact = std::get_if<CompactQueue>(&_queue))
+    {
+      std::array<void *, ChunkSize> addresses;
+      for (std::size_t i = 0; i < chunk; ++i)
+      {
+        addresses[i] = fibres[pushed + i].__handle().address();
+      }
+      count = compact->tryPushN(std::span{ addresses }.first(chunk));
+    }
+    else
+    {
+      std::array<Handle, ChunkSize> handles;
+      for (std::size_t i = 0; i < chunk; ++i)
+      {
+        handles[i] = fibres[pushed + i].__handle();
+      }
+      count = std::get<PaddedQueue>(_queue).try_push_n(handles.data(), chunk);
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      fibres[pushed + i].__release();
+    }
+    pushed += count;
+    if (count < chunk)
+    {
+      break;
+    }
+  }
+  return pushed;
 }
 
 Fibre SharedQueue::pop()
 {
-  std::coroutine_handle<Fibre::promise_type> handle;
-  _queue.try_pop(handle);
+  Handle handle;
+  if (auto *compact = std::get_if<CompactQueue>(&_queue))
+  {
+    handle = Handle::from_address(compact->tryPop());
+  }
+  else
+  {
+    std::get<PaddedQueue>(_queue).try_pop(handle);
+  }
+
   if (handle)
   {
     return { handle };
@@ -36,14 +119,48 @@ Fibre SharedQueue::pop()
   return {};
 }
 
+std::size_t SharedQueue::pop(std::span<Fibre> fibres)
+{
+  std::size_t popped = 0;
+  while (popped < fibres.size())
+  {
+    const std::size_t chunk = std::min(ChunkSize, fibres.size() - popped);
+    std::size_t count = 0;
+    if (auto *compact = std::get_if<CompactQueue>(&_queue))
+    {
+      std::array<void *, ChunkSize> addresses;
+      count = compact->tryPopN(std::span{ addresses }.first(chunk));
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        fibres[popped + i] = Fibre{ Handle::from_address(addresses[i]) };
+      }
+    }
+    else
+    {
+      std::array<Handle, ChunkSize> handles;
+      count = std::get<PaddedQueue>(_queue).try_pop_n(handles.data(), chunk);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        fibres[popped + i] = Fibre{ handles[i] };
+      }
+    }
+
+    popped += count;
+    if (count == 0)
+    {
+      break;
+    }
+  }
+  return popped;
+}
+
 void SharedQueue::clear()
 {
   // We must explicitly destroy each handle since normally it's not wrapped in a Fibre which
   // normally does this.
-  std::coroutine_handle<Fibre::promise_type> handle;
-  while (_queue.try_pop(handle))
+  for (Fibre fibre = pop(); fibre.valid(); fibre = pop())
   {
-    handle.destroy();
+    fibre.__release().destroy();
   }
 }
 }  // namespace morai
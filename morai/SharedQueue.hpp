@@ -2,21 +2,46 @@
 
 #include "Fibre.hpp"
 
+#include "CompactQueue.hpp"
 #include "MPMCQueue.hpp"
 
 #include <coroutine>
+#include <span>
+#include <variant>
 
 namespace morai
 {
+/// Slot layout for a @c SharedQueue.
+enum class SharedQueueLayout
+{
+  /// Each slot occupies its own cache line to avoid false sharing between adjacent slots. Uses
+  /// @c rigtorp::MPMCQueue.
+  Padded,
+  /// Slots are packed, optionally padded, with a power of two capacity. Uses @c CompactQueue.
+  Compact,
+};
+
+/// Parameters for creating a @c SharedQueue.
+struct SharedQueueParams
+{
+  /// The slot layout. @c Padded uses a cache line per slot - 64KB for 1024 slots - where
+  /// @c Compact uses 16 bytes per slot by default.
+  SharedQueueLayout layout = SharedQueueLayout::Padded;
+  /// Bytes per slot for @c SharedQueueLayout::Compact. Zero packs slots densely. See
+  /// @c CompactQueue.
+  uint32_t slot_size = 0u;
+};
+
 /// A multi-threaded, multi-producer, multi-consumer, lock free queue.
 ///
 /// @par Implementation
 ///
-/// Uses [Erik Rigtorp mpmc queue](https://github.com/rigtorp/MPMCQueue) under MIT license.
+/// Uses [Erik Rigtorp mpmc queue](https://github.com/rigtorp/MPMCQueue) under MIT license, or a
+/// @c CompactQueue - see @c SharedQueueLayout.
 class SharedQueue
 {
 public:
-  explicit SharedQueue(int32_t priority, uint32_t capacity);
+  explicit SharedQueue(int32_t priority, uint32_t capacity, SharedQueueParams params = {});
   ~SharedQueue();
 
   SharedQueue(SharedQueue &&other) noexcept = delete;
@@ -30,9 +55,9 @@ public:
 
   /// Estimate the number of items in the queue. This may be inaccurate as other threads may modify
   /// the queue.
-  [[nodiscard]] size_t size() const { return _queue.size(); }
+  [[nodiscard]] size_t size() const;
   /// Check if the queue is empty. This may be inaccurate as other threads may modify the queue.
-  [[nodiscard]] bool empty() const { return _queue.empty(); }
+  [[nodiscard]] bool empty() const { return size() == 0; }
 
   /// Try push into the shared queue. This may fail when full.
   ///
@@ -45,15 +70,33 @@ public:
   /// failure and the caller must handle it appropriately.
   [[nodiscard]] bool tryPush(Fibre &fibre);
 
+  /// Try push the leading @p fibres into the queue, claiming slots for them together where
+  /// possible. Pushes as many as there is space for.
+  ///
+  /// Pushed fibres become invalid. The remaining fibres stay valid and the caller must handle them
+  /// appropriately.
+  ///
+  /// @param fibres The fibres to push in order. Must be valid.
+  /// @return The number of leading fibres pushed.
+  [[nodiscard]] std::size_t tryPush(std::span<Fibre> fibres);
+
   /// Pop the next item off the queue.
   [[nodiscard]] Fibre pop();
 
+  /// Pop up to @c fibres.size() items off the queue, claiming them together where possible.
+  /// @param fibres Receives the fibres in queue order.
+  /// @return The number of fibres popped.
+  [[nodiscard]] std::size_t pop(std::span<Fibre> fibres);
+
   /// Clear the queue, destroying all contained fibres.
   void clear();
 
 private:
+  using Handle = std::coroutine_handle<Fibre::promise_type>;
+  using PaddedQueue = rigtorp::MPMCQueue<Handle>;
+
   /// Stores @c Fibre internals rather than a @c Fibre so we can deal with @c try_push() failing.
-  rigtorp::MPMCQueue<std::coroutine_handle<Fibre::promise_type>> _queue;
+  std::variant<PaddedQueue, CompactQueue> _queue;
   int32_t _priority = 0;
 };
 }  // namespace morai
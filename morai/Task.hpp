@@ -0,0 +1,314 @@
+#pragma once
+
+#include "Fibre.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace morai
+{
+template <typename T>
+class Task;
+
+namespace detail
+{
+/// Common @c Task promise implementation, independent of the result type.
+///
+/// A task is always awaited, directly or indirectly, by a @c Fibre - the root. Suspension points
+/// within the task are forwarded to the root fibre's promise, so suspending a task suspends the
+/// whole fibre. The root @c Frame::leaf tracks the innermost suspended task, which is resumed in
+/// place of the fibre.
+struct TaskPromiseBase
+{
+  using RootHandle = std::coroutine_handle<Fibre::promise_type>;
+
+  /// Awaitable wrapper which applies a root fibre awaitable to the root fibre.
+  template <typename Awaitable>
+  struct RootAwaitable
+  {
+    /// The root fibre awaitable.
+    Awaitable awaitable;
+    /// The root fibre.
+    RootHandle root;
+    bool await_ready() { return awaitable.await_ready(); }
+    /// Suspend the task, applying the suspension to the root fibre.
+    void await_suspend(std::coroutine_handle<>) noexcept { awaitable.await_suspend(root); }
+    decltype(auto) await_resume() { return awaitable.await_resume(); }
+  };
+
+  /// Final suspension - transfer to the awaiting coroutine.
+  struct FinalAwaitable
+  {
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+    {
+      TaskPromiseBase &promise = handle.promise();
+      // Restore the awaiting coroutine as the leaf. This is null when the awaiting coroutine is the
+      // root fibre itself.
+      promise.root.promise().frame.leaf = promise.parent_leaf;
+      return promise.continuation;
+    }
+    void await_resume() noexcept {}
+  };
+
+  /// The awaiting coroutine - either the root fibre or another task.
+  std::coroutine_handle<> continuation{};
+  /// The root fibre @c Frame::leaf value to restore on completion.
+  std::coroutine_handle<> parent_leaf{};
+  /// The root fibre.
+  RootHandle root{};
+
+  /// Allocate the coroutine frame from the pooled @c FrameAllocator.
+  static void *operator new(std::size_t size) { return FrameAllocator::allocate(size); }
+  /// Release the coroutine frame to the @c FrameAllocator.
+  static void operator delete(void *ptr) noexcept { FrameAllocator::deallocate(ptr); }
+
+  /// Initial suspension - always. Tasks are started when awaited.
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  /// Final suspension - resumes the awaiting coroutine.
+  FinalAwaitable final_suspend() noexcept { return {}; }
+
+  /// Yield handling - yields the root fibre. See @c Fibre::promise_type::yield_value().
+  std::suspend_always yield_value(Resumption &&value) noexcept
+  {
+    root.promise().frame.setResumption(std::move(value));
+    return {};
+  }
+
+  /// @c co_await handling for child tasks. These are started directly, without involving the root.
+  template <typename Child>
+    requires requires(Child &&child) { std::forward<Child>(child).childAwaitable(); }
+  auto await_transform(Child &&child)
+  {
+    return std::forward<Child>(child).childAwaitable();
+  }
+
+  /// @c co_await handling for all @c Fibre::promise_type awaitables - @c sleep(), @c wait(),
+  /// @c Event, @c Id, @c moveTo() etc.
+  template <typename Value>
+    requires(!requires(Value &&value) { std::forward<Value>(value).childAwaitable(); } &&
+             requires(Fibre::promise_type &promise, Value &&value) {
+               promise.await_transform(std::forward<Value>(value));
+             })
+  auto await_transform(Value &&value)
+  {
+    using Awaitable = decltype(root.promise().await_transform(std::forward<Value>(value)));
+    return RootAwaitable<Awaitable>{ root.promise().await_transform(std::forward<Value>(value)),
+                                     root };
+  }
+
+  /// Resolve the root fibre of an awaiting fibre.
+  static RootHandle rootOf(RootHandle fibre) noexcept { return fibre; }
+  /// Resolve the root fibre of an awaiting task.
+  template <typename Promise>
+    requires std::is_base_of_v<TaskPromiseBase, Promise>
+  static RootHandle rootOf(std::coroutine_handle<Promise> task) noexcept
+  {
+    return task.promise().root;
+  }
+};
+
+/// @c Task promise result storage.
+template <typename T>
+struct TaskPromise : TaskPromiseBase
+{
+  /// The task result: empty, the return value or an exception.
+  std::variant<std::monostate, T, std::exception_ptr> result{};
+
+  Task<T> get_return_object() noexcept;
+
+  template <typename Value>
+    requires std::is_convertible_v<Value &&, T>
+  void return_value(Value &&value) noexcept(std::is_nothrow_constructible_v<T, Value &&>)
+  {
+    result.template emplace<1>(std::forward<Value>(value));
+  }
+  void unhandled_exception() noexcept { result.template emplace<2>(std::current_exception()); }
+
+  /// Retrieve the result, rethrowing any exception.
+  T take()
+  {
+    if (result.index() == 2)
+    {
+      std::rethrow_exception(std::get<2>(result));
+    }
+    return std::move(std::get<1>(result));
+  }
+};
+
+/// @c Task promise specialisation for @c void results.
+template <>
+struct TaskPromise<void> : TaskPromiseBase
+{
+  std::exception_ptr exception{};
+
+  Task<void> get_return_object() noexcept;
+
+  void return_void() noexcept {}
+  void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+  /// Rethrow any exception.
+  void take()
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+  }
+};
+}  // namespace detail
+
+/// A lazily started child coroutine which returns a value of type @p T to an awaiting @c Fibre or
+/// @c Task.
+///
+/// A task does not run until awaited. Awaiting a task transfers control directly into it - via
+/// symmetric transfer - so calling into a task costs a function call rather than a scheduler
+/// update. On completion, the task transfers control straight back to the awaiting coroutine with
+/// its return value, or rethrows its exception there.
+///
+/// A task supports the same @c co_await and @c co_yield statements as a @c Fibre. Suspending
+/// within a task suspends the whole fibre, and the fibre's scheduler resumes the task when the
+/// suspension condition is met. Tasks may await other tasks to any depth.
+///
+/// @code
+/// morai::Task<int> countdown(int from)
+/// {
+///   for (int i = from; i > 0; --i)
+///   {
+///     co_await morai::sleep(1.0);  // Suspends the awaiting fibre.
+///   }
+///   co_return from;
+/// }
+///
+/// morai::Fibre fibre()
+/// {
+///   const int count = co_await countdown(3);
+/// }
+/// @endcode
+///
+/// A task may only be awaited once and must be awaited as an rvalue. A task which is never awaited
+/// is destroyed without running. Tasks have no @c Id and are cancelled along with their fibre.
+template <typename T = void>
+class Task
+{
+public:
+  using promise_type = detail::TaskPromise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  /// Implements the awaitable interface for @c Task types. Takes ownership of the task.
+  struct Awaitable
+  {
+    Handle handle{};
+
+    Awaitable(Handle handle) noexcept
+      : handle(handle)
+    {}
+    Awaitable(Awaitable &&other) noexcept
+      : handle(std::exchange(other.handle, {}))
+    {}
+    Awaitable(const Awaitable &) = delete;
+    Awaitable &operator=(const Awaitable &) = delete;
+    Awaitable &operator=(Awaitable &&) = delete;
+
+    ~Awaitable()
+    {
+      if (handle)
+      {
+        handle.destroy();
+      }
+    }
+
+    /// An empty task completes immediately.
+    bool await_ready() const noexcept { return !handle; }
+
+    /// Start the task, transferring control directly to it.
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> awaiting) noexcept
+    {
+      promise_type &promise = handle.promise();
+      promise.continuation = awaiting;
+      promise.root = detail::TaskPromiseBase::rootOf(awaiting);
+      detail::Frame &frame = promise.root.promise().frame;
+      promise.parent_leaf = std::exchange(frame.leaf, handle);
+      return handle;
+    }
+
+    /// Get the task result or rethrow its exception.
+    /// @throw std::logic_error when awaiting an empty task which has a result type.
+    T await_resume()
+    {
+      if constexpr (std::is_void_v<T>)
+      {
+        if (handle)
+        {
+          handle.promise().take();
+        }
+      }
+      else
+      {
+        if (!handle) [[unlikely]]
+        {
+          throw std::logic_error("Awaiting an empty Task");
+        }
+        return handle.promise().take();
+      }
+    }
+  };
+
+  /// Create an empty task.
+  Task() = default;
+  /// Create a task around the given coroutine @p handle.
+  explicit Task(Handle handle) noexcept
+    : _handle(handle)
+  {}
+  Task(Task &&other) noexcept
+    : _handle(std::exchange(other._handle, {}))
+  {}
+  Task &operator=(Task &&other) noexcept
+  {
+    std::swap(_handle, other._handle);
+    return *this;
+  }
+
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  /// Destructor - destroys the task coroutine if it has not been awaited.
+  ~Task()
+  {
+    if (_handle)
+    {
+      _handle.destroy();
+    }
+  }
+
+  /// Checks if this is a valid task which has not yet been awaited.
+  [[nodiscard]] bool valid() const noexcept { return static_cast<bool>(_handle); }
+
+  /// Create the awaitable for `co_await task;`, transferring ownership of the task. For internal
+  /// use by @c Fibre::promise_type and @c Task::promise_type.
+  [[nodiscard]] Awaitable childAwaitable() && noexcept { return { std::exchange(_handle, {}) }; }
+
+private:
+  Handle _handle{};
+};
+
+namespace detail
+{
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+  return Task<T>{ std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+  return Task<void>{ std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+}
+}  // namespace detail
+}  // namespace morai
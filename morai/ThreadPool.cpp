@@ -6,27 +6,79 @@
 #include "SharedQueue.hpp"
 
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <random>
 #include <thread>
+#include <utility>
 
 namespace morai
 {
 namespace
 {
-void generateQueueSelectionSet(std::vector<uint32_t> &set, size_t queue_count)
+/// Identifies the pool worker running on the current thread.
+struct CurrentWorker
 {
-  // Simple weighting: given 4 queues, we generate:
-  //  { 0, 0, 0, 0, 1, 1, 1, 2, 2, 3 }
-  // - Update [0] 4 times
-  // - Update [1] 3 times
-  // - Update [2] 2 times
-  // - Update [3] 1 times
-  for (uint32_t i = 0; i < static_cast<uint32_t>(queue_count); ++i)
+  const void *pool = nullptr;
+  void *worker = nullptr;
+};
+
+thread_local CurrentWorker current_worker;
+
+/// Upper bound on a timer thread wait. Bounds timer latency for custom clocks which do not track
+/// real time.
+constexpr std::chrono::milliseconds MaxTimerWait{ 100 };
+
+uint64_t timerGranularity(const double resolution_s, const double quantisation)
+{
+  return static_cast<uint64_t>(std::max(std::llround(resolution_s / quantisation), 1ll));
+}
+
+uint64_t agingTicks(const std::chrono::microseconds interval, const double quantisation)
+{
+  if (interval.count() <= 0)
+  {
+    return 0;
+  }
+  const double ticks = std::chrono::duration<double>(interval).count() / quantisation;
+  return static_cast<uint64_t>(std::max(std::llround(ticks), 1ll));
+}
+
+/// Random victim selection for work stealing.
+uint32_t randomIndex()
+{
+  thread_local std::minstd_rand rng{ static_cast<uint32_t>(
+    std::hash<std::thread::id>{}(std::this_thread::get_id())) };
+  return static_cast<uint32_t>(rng());
+}
+
+/// Generate a level schedule selecting each level in proportion to its weight. Uses smooth weighted
+/// round robin so levels are interleaved rather than selected in runs. E.g., weights
+/// { 4, 3, 2, 1 } yield { 0, 1, 2, 0, 1, 3, 0, 2, 1, 0 }.
+void generateLevelSelection(std::vector<uint32_t> &selection, const std::vector<uint32_t> &weights)
+{
+  int64_t total_weight = 0;
+  for (const uint32_t weight : weights)
   {
-    const auto weighting = (queue_count - i);
-    for (uint32_t j = 0; j < weighting; ++j)
+    total_weight += weight;
+  }
+
+  std::vector<int64_t> current(weights.size(), 0);
+  selection.clear();
+  for (int64_t i = 0; i < total_weight; ++i)
+  {
+    std::size_t best = 0;
+    for (std::size_t level = 0; level < weights.size(); ++level)
     {
-      set.emplace_back(i);
+      current[level] += weights[level];
+      if (current[level] > current[best])
+      {
+        best = level;
+      }
     }
+    current[best] -= total_weight;
+    selection.emplace_back(static_cast<uint32_t>(best));
   }
 }
 }  // namespace
@@ -36,16 +88,33 @@ ThreadPool::ThreadPool(ThreadPoolParams params)
 {}
 
 ThreadPool::ThreadPool(Clock clock, ThreadPoolParams params)
-  : _idle_sleep_duration(params.idle_sleep_duration)
+  : _home(new detail::Home(&ThreadPool::wakeFibre, this))
+  , _timers(timerGranularity(params.timer_resolution_s, clock.quantisation()))
+  , _idle_sleep_duration(params.idle_sleep_duration)
+  , _injection_limit(params.injection_limit)
+  , _time_source(params.time_source)
+  , _tick_interval(std::max(params.tick_interval, std::chrono::microseconds{ 1 }))
+  , _aging_ticks(agingTicks(params.aging_interval, clock.quantisation()))
+  , _wait_statistics(params.wait_statistics)
   , _clock(std::move(clock))
 {
+  // Calibrate up front rather than in the first time sliced update().
+  Clock::calibrateTsc();
+  detail::CancellationRouter::add(&_timers, &ThreadPool::requestCancel, this);
   createQueues(params);
   startWorkers(params);
 }
 
 ThreadPool::~ThreadPool()
 {
+  detail::CancellationRouter::remove(&_timers);
   _quit.test_and_set();
+  _idle.notifyAll();
+  {
+    // Lock to ensure the timer thread is either waiting or will see the quit flag.
+    const std::scoped_lock lock(_timer_mutex);
+    _timer_cv.notify_all();
+  }
   cancelAll();
   for (auto &thread : _workers)
   {
@@ -54,29 +123,89 @@ ThreadPool::~ThreadPool()
       thread.join();
     }
   }
+  if (_timer_thread.joinable())
+  {
+    _timer_thread.join();
+  }
+  // Fibres parked on external waitables are destroyed when woken from here on. Workers may have
+  // pushed fibres back before stopping, so cancel again.
+  _home->close();
+  cancelAll();
+  _home->release();
 }
 
 bool ThreadPool::empty() const noexcept
 {
-  for (const auto &queue : _fibre_queues)
+  return parkedCount() == 0 && !hasQueuedFibres();
+}
+
+bool ThreadPool::hasQueuedFibres() const noexcept
+{
+  if (!_inbox.empty() || injectedCount() > 0 ||
+      _sleeping_count.load(std::memory_order_relaxed) > 0)
   {
-    if (!queue->empty())
+    return true;
+  }
+
+  for (const auto &worker : _worker_states)
+  {
+    if (worker->batch_count.load(std::memory_order_relaxed) > 0)
     {
-      return false;
+      return true;
+    }
+    for (const auto &deque : worker->deques)
+    {
+      if (!deque->empty())
+      {
+        return true;
+      }
     }
   }
 
-  return true;
+  return false;
+}
+
+bool ThreadPool::hasIdleWork() const noexcept
+{
+  if (!_inbox.empty() || _cancel_pending.load(std::memory_order_seq_cst))
+  {
+    return true;
+  }
+
+  for (std::size_t i = 0; i < _fibre_queues.size(); ++i)
+  {
+    if (!_fibre_queues[i]->empty() || !_overflow[i]->empty())
+    {
+      return true;
+    }
+  }
+
+  for (const auto &worker : _worker_states)
+  {
+    for (const auto &deque : worker->deques)
+    {
+      if (deque->size() > 1)
+      {
+        return true;
+      }
+    }
+  }
+
+  return false;
 }
 
 std::size_t ThreadPool::runningCount() const noexcept
 {
-  std::size_t count = 0;
-  for (const auto &queue : _fibre_queues)
+  std::size_t count = injectedCount() + _sleeping_count.load(std::memory_order_relaxed);
+  for (const auto &worker : _worker_states)
   {
-    count += queue->size();
+    count += worker->batch_count.load(std::memory_order_relaxed);
+    for (const auto &deque : worker->deques)
+    {
+      count += deque->size();
+    }
   }
-  return count;
+  return count + parkedCount();
 }
 
 Id ThreadPool::start(Fibre &&fibre, int32_t priority, std::string_view name)
@@ -85,23 +214,75 @@ Id ThreadPool::start(Fibre &&fibre, int32_t priority, std::string_view name)
   Id fibre_id = fibre.id();
   fibre.__setPriority(priority);
   fibre.setName(name);
-  SharedQueue &fibres = selectQueue(priority, false);
-  while (!fibres.tryPush(fibre))
+  fibre.__setHome(_home);
+  if (_wait_statistics)
   {
-    // Full. Sleep and try again.
-    std::this_thread::sleep_for(_idle_sleep_duration);
+    fibre.__setQueuedTick(currentTick());
   }
+  const std::size_t level = selectLevel(priority, false);
+  if (Worker *worker = currentWorker())
+  {
+    // Started from a worker. Keep local.
+    pushLocal(*worker, level, std::move(fibre));
+    _idle.notifyOne();
+    return fibre_id;
+  }
+
+  inject(std::move(fibre), level);
+  _idle.notifyOne();
   return fibre_id;
 }
 
+std::optional<Id> ThreadPool::tryStart(Fibre &fibre, int32_t priority, std::string_view name)
+{
+  if (_injection_limit > 0 && !currentWorker() && injectedCount() >= _injection_limit)
+  {
+    return std::nullopt;
+  }
+  return start(std::move(fibre), priority, name);
+}
+
+std::size_t ThreadPool::injectedCount() const noexcept
+{
+  std::size_t count = 0;
+  for (const auto &queue : _fibre_queues)
+  {
+    count += queue->size();
+  }
+  const int64_t overflow = _overflow_count.load(std::memory_order_relaxed);
+  return count + static_cast<std::size_t>(std::max<int64_t>(overflow, 0));
+}
+
 void ThreadPool::cancelAll()
 {
   const auto resume = finally([this]() { _paused.clear(); });
   _paused.test_and_set();
+  _cancel_epoch.fetch_add(1, std::memory_order_acq_rel);
   for (auto &queue : _fibre_queues)
   {
     queue->clear();
   }
+  for (auto &overflow : _overflow)
+  {
+    _overflow_count -= static_cast<int64_t>(overflow->clear());
+  }
+  {
+    const std::scoped_lock lock(_timer_mutex);
+    _sleeping_count -= _timers.size();
+    _timers.clear();
+  }
+  // Worker deques may only be popped by their owner, but any thread may steal.
+  for (auto &worker : _worker_states)
+  {
+    for (auto &deque : worker->deques)
+    {
+      while (!deque->empty())
+      {
+        Fibre discard = deque->steal();
+      }
+    }
+  }
+  _parked_count -= static_cast<int64_t>(_inbox.clear());
 }
 
 void ThreadPool::update(std::function<bool()> continue_condition)
@@ -118,8 +299,10 @@ void ThreadPool::update(std::function<bool()> continue_condition)
 
 void ThreadPool::update(std::chrono::milliseconds time_slice)
 {
-  update([target_end_time = std::chrono::steady_clock::now() + time_slice]() {
-    return std::chrono::steady_clock::now() < target_end_time;
+  // Checked once per fibre, so use the low cost TSC clock where available.
+  update([end_time_s = Clock::tsc_time_function() +
+                       std::chrono::duration<double>(time_slice).count()]() {
+    return Clock::tsc_time_function() < end_time_s;
   });
 }
 
@@ -138,29 +321,75 @@ bool ThreadPool::wait(std::optional<std::chrono::milliseconds> timeout)
 
 bool ThreadPool::move(Fibre &fibre, std::optional<int32_t> priority)
 {
-  // Grab the so that we only adjust the priority on success. The Fibre object will be invalid by
-  // then.
-  std::coroutine_handle<Fibre::promise_type> handle = fibre.__handle();
   // Unlike scheduler, we can directly insert into the target queue as they are all threadsafe.
-  SharedQueue &queue = selectQueue(*priority, false);
-  const bool pushed = queue.tryPush(fibre);
-  if (pushed && priority)
+  // Set the priority first as a worker may resume the fibre as soon as it is pushed.
+  if (priority)
+  {
+    fibre.__setPriority(*priority);
+  }
+  const std::size_t level = selectLevel(fibre.priority(), false);
+  fibre.__setHome(_home);
+  if (_wait_statistics)
   {
-    handle.promise().frame.priority = *priority;
+    fibre.__setQueuedTick(currentTick());
   }
-  return pushed;
+  inject(std::move(fibre), level);
+  _idle.notifyOne();
+  return true;
 }
 
-SharedQueue &ThreadPool::selectQueue(int32_t priority, bool quiet)
+std::size_t ThreadPool::move(std::span<Fibre> fibres)
+{
+  const uint64_t queued_tick = (_wait_statistics) ? currentTick() : 0u;
+  std::size_t run_begin = 0;
+  std::size_t run_level = 0;
+  for (std::size_t i = 0; i < fibres.size(); ++i)
+  {
+    Fibre &fibre = fibres[i];
+    fibre.__setHome(_home);
+    if (_wait_statistics)
+    {
+      fibre.__setQueuedTick(queued_tick);
+    }
+    const std::size_t level = selectLevel(fibre.priority(), false);
+    if (i > run_begin && level != run_level)
+    {
+      inject(fibres.subspan(run_begin, i - run_begin), run_level);
+      run_begin = i;
+    }
+    run_level = level;
+  }
+  if (fibres.size() > run_begin)
+  {
+    inject(fibres.subspan(run_begin), run_level);
+  }
+
+  if (fibres.size() == 1)
+  {
+    _idle.notifyOne();
+  }
+  else if (fibres.size() > 1)
+  {
+    _idle.notifyAll();
+  }
+  return fibres.size();
+}
+
+ThreadPool::Worker *ThreadPool::currentWorker() const noexcept
+{
+  return (current_worker.pool == this) ? static_cast<Worker *>(current_worker.worker) : nullptr;
+}
+
+std::size_t ThreadPool::selectLevel(int32_t priority, bool quiet) const
 {
   size_t best_idx = 0;
 
   for (size_t i = 0; i < _fibre_queues.size(); ++i)
   {
-    SharedQueue &queue = *_fibre_queues.at(i);
+    const SharedQueue &queue = *_fibre_queues.at(i);
     if (priority == queue.priority())
     {
-      return queue;
+      return i;
     }
     else if (priority > queue.priority())
     {
@@ -172,36 +401,279 @@ SharedQueue &ThreadPool::selectQueue(int32_t priority, bool quiet)
     }
   }
 
-  SharedQueue &queue = *_fibre_queues.at(best_idx);
   if (!quiet)
   {
     log::error(std::format("Thread Pool: Fibre priority mismatch: {} moved to {}", priority,
-                           queue.priority()));
+                           _fibre_queues.at(best_idx)->priority()));
   }
 
-  return queue;
+  return best_idx;
 }
 
-bool ThreadPool::tryPushFibre(Fibre &fibre)
+void ThreadPool::requeue(Fibre &&fibre)
 {
-  SharedQueue &queue = selectQueue(fibre.priority(), true);
-  return queue.tryPush(fibre);
+  if (_wait_statistics)
+  {
+    fibre.__setQueuedTick(currentTick());
+  }
+  if (Worker *worker = currentWorker())
+  {
+    const std::size_t level = selectLevel(fibre.priority(), true);
+    pushLocal(*worker, level, std::move(fibre));
+    const WorkStealingDeque &deque = *worker->deques[level];
+    // Share surplus work with parked workers. The waiting check is a hint to keep requeuing cheap;
+    // parked workers only miss work this worker will run anyway.
+    if (deque.size() > 1 && _idle.waiting())
+    {
+      _idle.notifyOne();
+    }
+    return;
+  }
+  inject(std::move(fibre), selectLevel(fibre.priority(), true));
+}
+
+void ThreadPool::pushLocal(Worker &worker, std::size_t level, Fibre &&fibre)
+{
+  worker.deques[level]->push(std::move(fibre));
+  // Only the owner writes the bits, so skip the write when already set.
+  const uint64_t bit = uint64_t{ 1 } << level;
+  if (!(worker.occupied.load(std::memory_order_relaxed) & bit))
+  {
+    worker.occupied.fetch_or(bit, std::memory_order_relaxed);
+  }
+}
+
+void ThreadPool::inject(Fibre &&fibre, std::size_t level)
+{
+  if (!_fibre_queues[level]->tryPush(fibre))
+  {
+    // Full. Overflow never fails.
+    _overflow[level]->push(std::move(fibre));
+    _overflow_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Set after pushing. Pairs with the clear in clearInjectedLevel().
+  _injected_levels.fetch_or(uint64_t{ 1 } << level, std::memory_order_acq_rel);
+}
+
+void ThreadPool::inject(std::span<Fibre> fibres, std::size_t level)
+{
+  const std::size_t pushed = _fibre_queues[level]->tryPush(fibres);
+  if (pushed < fibres.size())
+  {
+    for (Fibre &fibre : fibres.subspan(pushed))
+    {
+      // Full. Overflow never fails.
+      _overflow[level]->push(std::move(fibre));
+    }
+    _overflow_count.fetch_add(static_cast<int64_t>(fibres.size() - pushed),
+                              std::memory_order_relaxed);
+  }
+  // Set after pushing. Pairs with the clear in clearInjectedLevel().
+  _injected_levels.fetch_or(uint64_t{ 1 } << level, std::memory_order_acq_rel);
 }
 
-Fibre ThreadPool::nextFibre(uint32_t &selection_index)
+void ThreadPool::clearInjectedLevel(std::size_t level) noexcept
 {
-  // FIXME: this will result in low priority starvation.
-  for (size_t i = 0; i < _queue_weighted_selection.size(); ++i)
+  const uint64_t bit = uint64_t{ 1 } << level;
+  _injected_levels.fetch_and(~bit, std::memory_order_acq_rel);
+  // Recheck as an injection may have raced the clear.
+  if (!_fibre_queues[level]->empty() || !_overflow[level]->empty())
   {
-    SharedQueue &queue = *_fibre_queues.at(_queue_weighted_selection.at(selection_index));
-    selection_index = selection_index =
-      (selection_index + 1u) % static_cast<uint32_t>(_queue_weighted_selection.size());
-    Fibre fibre = queue.pop();
+    _injected_levels.fetch_or(bit, std::memory_order_acq_rel);
+  }
+}
+
+Fibre ThreadPool::popInjected(std::size_t level, Worker *worker)
+{
+  Fibre fibre = _fibre_queues[level]->pop();
+  if (fibre.valid())
+  {
+    return fibre;
+  }
+  if (_overflow[level]->empty())
+  {
+    clearInjectedLevel(level);
+    return fibre;
+  }
+
+  // Queue empty, but overflowed. Take the first overflow fibre and redistribute the rest.
+  std::size_t returned = 0;
+  const std::size_t drained =
+    _overflow[level]->drain([this, level, worker, &fibre, &returned](Fibre &&next) {
+      if (!fibre.valid())
+      {
+        fibre = std::move(next);
+      }
+      else if (worker)
+      {
+        pushLocal(*worker, level, std::move(next));
+      }
+      else if (!_fibre_queues[level]->tryPush(next))
+      {
+        _overflow[level]->push(std::move(next));
+        ++returned;
+      }
+    });
+  _overflow_count.fetch_sub(static_cast<int64_t>(drained - returned), std::memory_order_relaxed);
+  if (worker && worker->deques[level]->size() > 1)
+  {
+    _idle.notifyOne();
+  }
+  return fibre;
+}
+
+Fibre ThreadPool::stealFibre(const Worker *thief, std::size_t level)
+{
+  const auto worker_count = static_cast<uint32_t>(_worker_states.size());
+  if (worker_count == 0)
+  {
+    return {};
+  }
+
+  const uint64_t bit = uint64_t{ 1 } << level;
+  const uint32_t first = randomIndex() % worker_count;
+  for (uint32_t i = 0; i < worker_count; ++i)
+  {
+    Worker &victim = *_worker_states[(first + i) % worker_count];
+    if (&victim == thief || !(victim.occupied.load(std::memory_order_relaxed) & bit))
+    {
+      continue;
+    }
+
+    Fibre fibre = victim.deques[level]->steal();
     if (fibre.valid())
     {
       return fibre;
     }
   }
+  return {};
+}
+
+uint64_t ThreadPool::stealableLevels(const Worker *thief) const noexcept
+{
+  uint64_t levels = 0;
+  for (const auto &worker : _worker_states)
+  {
+    if (worker.get() != thief)
+    {
+      levels |= worker->occupied.load(std::memory_order_relaxed);
+    }
+  }
+  return levels;
+}
+
+std::size_t ThreadPool::selectOccupiedLevel(uint64_t occupied,
+                                            uint32_t &selection_index) const noexcept
+{
+  const uint32_t scheduled = _level_selection[selection_index];
+  selection_index = (selection_index + 1u) % static_cast<uint32_t>(_level_selection.size());
+  if (occupied & (uint64_t{ 1 } << scheduled))
+  {
+    return scheduled;
+  }
+  return static_cast<std::size_t>(std::countr_zero(occupied));
+}
+
+Fibre ThreadPool::takeFibre(std::size_t level, Worker *worker, bool injection_first)
+{
+  Fibre fibre = (injection_first) ? popInjected(level, worker) : Fibre{};
+  if (!fibre.valid() && worker)
+  {
+    // Take local work in FIFO order. Fibres requeue themselves after every resume, so LIFO
+    // order would keep resuming the same fibre.
+    WorkStealingDeque &deque = *worker->deques[level];
+    fibre = deque.steal();
+    if (!fibre.valid() && deque.empty())
+    {
+      // Thieves emptied the deque. Only the owner pushes, so it stays empty until we push again.
+      worker->occupied.fetch_and(~(uint64_t{ 1 } << level), std::memory_order_relaxed);
+    }
+  }
+  if (!fibre.valid() && !injection_first)
+  {
+    fibre = popInjected(level, worker);
+  }
+  if (!fibre.valid())
+  {
+    fibre = stealFibre(worker, level);
+  }
+  return fibre;
+}
+
+std::size_t ThreadPool::agedLevel(Worker &worker, uint64_t occupied, std::size_t selected,
+                                  uint64_t tick) const noexcept
+{
+  // Levels start waiting when first seen occupied.
+  for (uint64_t fresh = occupied & ~worker.aging_seen; fresh != 0; fresh &= fresh - 1)
+  {
+    worker.waiting_since[std::countr_zero(fresh)] = tick;
+  }
+  worker.aging_seen |= occupied;
+
+  // The effective level improves by one per aging interval waited. Scored in ticks - lower is
+  // better - so a level which has waited longer wins ties.
+  const auto score = [&worker, tick, this](std::size_t level) {
+    const uint64_t since = worker.waiting_since[level];
+    const uint64_t waited = (tick > since) ? tick - since : 0u;
+    return static_cast<int64_t>(level * _aging_ticks) - static_cast<int64_t>(waited);
+  };
+
+  std::size_t best = selected;
+  int64_t best_score = score(selected);
+  for (uint64_t remaining = occupied; remaining != 0; remaining &= remaining - 1)
+  {
+    const auto level = static_cast<std::size_t>(std::countr_zero(remaining));
+    const int64_t level_score = score(level);
+    if (level_score < best_score)
+    {
+      best = level;
+      best_score = level_score;
+    }
+  }
+  return best;
+}
+
+Fibre ThreadPool::nextFibre(uint32_t &selection_index, uint64_t tick, std::size_t &level)
+{
+  Worker *worker = currentWorker();
+  // Periodically prefer the injection queues so external fibres are not starved by local work.
+  const bool injection_first = !worker || (++worker->tick % InjectionInterval) == 0;
+
+  uint64_t occupied = _injected_levels.load(std::memory_order_acquire);
+  if (worker)
+  {
+    occupied |= worker->occupied.load(std::memory_order_relaxed);
+  }
+  // Reading other workers' levels costs a load per worker. Only do so periodically, or when there
+  // is no other work.
+  if (occupied == 0 || injection_first)
+  {
+    occupied |= stealableLevels(worker);
+  }
+
+  while (occupied != 0)
+  {
+    level = selectOccupiedLevel(occupied, selection_index);
+    const bool aging = worker && _aging_ticks > 0;
+    if (aging)
+    {
+      level = agedLevel(*worker, occupied, level, tick);
+    }
+    Fibre fibre = takeFibre(level, worker, injection_first);
+    if (fibre.valid())
+    {
+      if (aging)
+      {
+        worker->waiting_since[level] = tick;
+      }
+      return fibre;
+    }
+    occupied &= ~(uint64_t{ 1 } << level);
+    if (aging)
+    {
+      worker->aging_seen &= ~(uint64_t{ 1 } << level);
+    }
+  }
 
   return Fibre{};
 }
@@ -213,14 +685,56 @@ void ThreadPool::createQueues(ThreadPoolParams &params)
     params.priority_levels.push_back(0);
   }
 
-  generateQueueSelectionSet(_queue_weighted_selection, params.priority_levels.size());
+  if (!params.priority_weights.empty() &&
+      params.priority_weights.size() != params.priority_levels.size())
+  {
+    log::error(std::format("Thread Pool: {} priority weights given for {} priority levels. Using "
+                           "default weights.",
+                           params.priority_weights.size(), params.priority_levels.size()));
+    params.priority_weights.clear();
+  }
 
-  std::ranges::sort(params.priority_levels);
+  // Sort the levels, keeping each paired with its weight.
+  const bool default_weights = params.priority_weights.empty();
+  std::vector<std::pair<int32_t, uint32_t>> levels;
+  for (std::size_t i = 0; i < params.priority_levels.size(); ++i)
+  {
+    const uint32_t weight = (!default_weights) ? params.priority_weights[i] : 0u;
+    levels.emplace_back(params.priority_levels[i], std::max(weight, 1u));
+  }
+  std::ranges::sort(levels, {}, &std::pair<int32_t, uint32_t>::first);
+
+  if (levels.size() > MaxPriorityLevels)
+  {
+    log::error(std::format("Thread Pool: {} priority levels exceeds the maximum {}. Dropping the "
+                           "lowest priority levels.",
+                           levels.size(), MaxPriorityLevels));
+    levels.resize(MaxPriorityLevels);
+  }
+
+  params.priority_levels.clear();
+  params.priority_weights.clear();
+  for (std::size_t i = 0; i < levels.size(); ++i)
+  {
+    params.priority_levels.emplace_back(levels[i].first);
+    // Default weighting favours higher priority levels: N - i.
+    params.priority_weights.emplace_back(
+      (default_weights) ? static_cast<uint32_t>(levels.size() - i) : levels[i].second);
+  }
+  generateLevelSelection(_level_selection, params.priority_weights);
 
   _fibre_queues.clear();
+  _overflow.clear();
   for (const int32_t priority : params.priority_levels)
   {
-    _fibre_queues.emplace_back(std::make_unique<SharedQueue>(priority, params.initial_queue_size));
+    _fibre_queues.emplace_back(
+      std::make_unique<SharedQueue>(priority, params.initial_queue_size, params.injection_queue));
+    _overflow.emplace_back(std::make_unique<FrameInbox>());
+  }
+
+  if (_wait_statistics)
+  {
+    _external_waits = std::make_unique<WaitCounters[]>(_fibre_queues.size());
   }
 }
 
@@ -238,91 +752,620 @@ void ThreadPool::startWorkers(ThreadPoolParams &params)
     }
   }
 
-  _workers.reserve(worker_count);
+  // Create all worker states before starting any thread as workers steal from each other.
+  _worker_states.reserve(worker_count);
   for (int32_t thread_index = 0; thread_index < worker_count; ++thread_index)
   {
-    _workers.emplace_back(&ThreadPool::workerThread, this, thread_index,
-                          params.idle_sleep_duration);
+    auto worker = std::make_unique<Worker>();
+    for (std::size_t i = 0; i < _fibre_queues.size(); ++i)
+    {
+      worker->deques.emplace_back(std::make_unique<WorkStealingDeque>());
+    }
+    if (_aging_ticks > 0)
+    {
+      worker->waiting_since.resize(_fibre_queues.size(), 0u);
+    }
+    if (_wait_statistics)
+    {
+      worker->waits = std::make_unique<WaitCounters[]>(_fibre_queues.size());
+    }
+    _worker_states.emplace_back(std::move(worker));
+  }
+
+  // Start the timer thread first. Workers check whether it is running.
+  if (worker_count > 0)
+  {
+    _timer_thread = std::jthread(&ThreadPool::timerThread, this);
+  }
+
+  _workers.reserve(worker_count);
+  for (auto &worker : _worker_states)
+  {
+    _workers.emplace_back(&ThreadPool::workerThread, this, std::ref(*worker));
   }
 }
 
-void ThreadPool::workerThread([[maybe_unused]] int32_t thread_index,
-                              std::chrono::milliseconds idle_sleep_duration)
+void ThreadPool::workerThread(Worker &worker)
 {
+  current_worker = { .pool = this, .worker = &worker };
+  const auto clear_worker = finally([]() { current_worker = {}; });
   uint32_t selection_index = 0;
+  uint32_t idle_spins = 0;
   while (!_quit.test())
   {
-    if (_paused.test() || !updateNextFibre(selection_index))
+    const uint32_t cancel_epoch = _cancel_epoch.load(std::memory_order_acquire);
+    if (cancel_epoch != worker.cancel_epoch)
     {
-      std::this_thread::sleep_for(idle_sleep_duration);
+      // cancelAll() ran. Discard the fibres it cannot reach: the run batch and any fibres this
+      // worker returned to its deques since.
+      worker.cancel_epoch = cancel_epoch;
+      discardLocal(worker);
+    }
+
+    if (!_paused.test() && updateNextFibre(selection_index))
+    {
+      if (idle_spins > 0)
+      {
+        // Spinning found work. Spin longer next time.
+        worker.spin_limit = std::min(worker.spin_limit * 2, MaxIdleSpins);
+        idle_spins = 0;
+      }
+      continue;
     }
+    idle(worker, idle_spins);
   }
+  discardLocal(worker);
 }
 
-bool ThreadPool::updateNextFibre(uint32_t &selection_index)
+void ThreadPool::idle(Worker &worker, uint32_t &idle_spins)
 {
-  // Get the next priority fibre.
-  Fibre fibre = nextFibre(selection_index);
-  while (fibre.valid())
+  if (idle_spins < worker.spin_limit)
   {
-    const double epoch_time_s = _clock.epoch();
-    const Resume resume = fibre.resume(epoch_time_s);
-    if (resume.mode == ResumeMode::Expire || resume.mode == ResumeMode::Moved) [[unlikely]]
-    {
-      // Expire the fibre.
-      return true;
-    }
+    ++idle_spins;
+    std::this_thread::yield();
+    return;
+  }
+
+  // Recheck for work after registering as a waiter so a concurrent notification is not lost.
+  const EventCount::Key key = _idle.prepareWait();
+  if (_quit.test() || (!_paused.test() && hasIdleWork()))
+  {
+    _idle.cancelWait();
+    resumeTicker();
+    return;
+  }
+
+  _idle.wait(key);
+  resumeTicker();
+  // Parking means spinning failed. Spin less next time.
+  worker.spin_limit = std::max(worker.spin_limit / 2, MinIdleSpins);
+  idle_spins = 0;
+}
+
+void ThreadPool::timerThread()
+{
+  const bool ticker = _time_source == PoolTimeSource::Ticker;
+  const auto worker_count = static_cast<uint32_t>(_worker_states.size());
+  std::unique_lock lock(_timer_mutex);
+  while (!_quit.test())
+  {
+    const double now_s = _clock.update();
+    wakeSleepers(lock);
 
-    if (resume.mode == ResumeMode::Exception) [[unlikely]]
+    // Tick while any worker is active. Stop once all workers park - the first worker to leave the
+    // idle state restarts the ticker. The store/load pairs with the waiter deregistration and load
+    // in resumeTicker().
+    bool ticking = false;
+    if (ticker)
     {
-      // Propagate exception and expire.
-      std::exception_ptr ex = fibre.exception();
-      try
+      _ticker_idle.store(true, std::memory_order_seq_cst);
+      ticking = _idle.waiters() < worker_count;
+      if (ticking)
       {
-        if (ex)
-        {
-          std::rethrow_exception(ex);
-        }
+        _ticker_idle.store(false, std::memory_order_relaxed);
       }
-      catch (const std::exception &e)
+    }
+
+    const std::optional<uint64_t> next_tick = _timers.nextExpiry();
+    _timer_wake_tick = next_tick.value_or(~uint64_t{ 0 });
+    const uint64_t wake_tick = _timer_wake_tick;
+    // Wake early on quit, when a fibre with an earlier deadline is parked or to restart ticking.
+    const auto interrupt = [this, wake_tick, restartable = ticker && !ticking]() {
+      return _quit.test() || _timer_wake_tick < wake_tick ||
+             (restartable && !_ticker_idle.load(std::memory_order_relaxed));
+    };
+    if (!next_tick && !ticking)
+    {
+      _timer_cv.wait(lock, interrupt);
+      continue;
+    }
+
+    std::chrono::microseconds wait_duration = MaxTimerWait;
+    if (next_tick)
+    {
+      const double wait_s = static_cast<double>(*next_tick) * _clock.quantisation() - now_s;
+      wait_duration = std::min(wait_duration, std::chrono::duration_cast<std::chrono::microseconds>(
+                                                std::chrono::duration<double>(wait_s)));
+    }
+    if (ticking)
+    {
+      wait_duration = std::min(wait_duration, _tick_interval);
+    }
+    if (wait_duration.count() > 0)
+    {
+      _timer_cv.wait_for(lock, wait_duration, interrupt);
+    }
+  }
+}
+
+uint64_t ThreadPool::currentTick()
+{
+  if (!currentWorker())
+  {
+    _clock.update();
+    return _clock.tick();
+  }
+  if (_time_source == PoolTimeSource::Direct)
+  {
+    return static_cast<uint64_t>(_clock.now() / _clock.quantisation());
+  }
+  return _clock.tick();
+}
+
+void ThreadPool::resumeTicker()
+{
+  if (_time_source != PoolTimeSource::Ticker || !_ticker_idle.load(std::memory_order_seq_cst))
+  {
+    return;
+  }
+
+  // The clock is stale. Refresh it for this worker rather than waiting for the ticker.
+  _clock.update();
+  {
+    const std::scoped_lock lock(_timer_mutex);
+    _ticker_idle.store(false, std::memory_order_relaxed);
+  }
+  _timer_cv.notify_one();
+}
+
+std::size_t ThreadPool::wakeSleepers([[maybe_unused]] std::unique_lock<std::mutex> &lock)
+{
+  if (_timers.empty())
+  {
+    return 0;
+  }
+
+  _clock.update();
+  const uint64_t tick = _clock.tick();
+  _timers.advance(tick, _woken);
+  const std::size_t woken = _woken.size();
+  // Inject runs of fibres sharing a level together. Fibres due together tend to share a priority.
+  std::size_t run_begin = 0;
+  std::size_t run_level = 0;
+  for (std::size_t i = 0; i < woken; ++i)
+  {
+    Fibre &fibre = _woken[i];
+    if (_wait_statistics)
+    {
+      fibre.__setQueuedTick(tick);
+    }
+    const std::size_t level = selectLevel(fibre.priority(), true);
+    if (i > run_begin && level != run_level)
+    {
+      inject(std::span{ _woken }.subspan(run_begin, i - run_begin), run_level);
+      run_begin = i;
+    }
+    run_level = level;
+  }
+  if (woken > run_begin)
+  {
+    inject(std::span{ _woken }.subspan(run_begin), run_level);
+  }
+  _woken.clear();
+  _sleeping_count.fetch_sub(woken, std::memory_order_relaxed);
+
+  if (woken == 1)
+  {
+    _idle.notifyOne();
+  }
+  else if (woken > 1)
+  {
+    _idle.notifyAll();
+  }
+  return woken;
+}
+
+bool ThreadPool::tryPark(Fibre &fibre, const uint64_t tick)
+{
+  // Only pure sleeps are parked. Wait conditions must be polled.
+  const uint64_t deadline_tick = fibre.__deadline();
+  if (fibre.__waiting() || deadline_tick <= tick)
+  {
+    return false;
+  }
+
+  const Id id = fibre.id();
+  Fibre cancelled;
+  {
+    const std::scoped_lock lock(_timer_mutex);
+    _timers.insert(std::move(fibre), deadline_tick);
+    // Pairs with the fence in Id::markForCancellation(): either the marking thread sees the wheel
+    // as the owner and routes to requestCancel(), or we see the mark here.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (id.cancelled())
+    {
+      // Destroyed outside the lock.
+      cancelled = _timers.remove(id);
+    }
+    else
+    {
+      _sleeping_count.fetch_add(1, std::memory_order_relaxed);
+      if (deadline_tick < _timer_wake_tick)
       {
-        log::error(std::format("Thread pool fibre {}:{} exception: {}", fibre.id().id(),
-                               fibre.name(), e.what()));
+        _timer_wake_tick = deadline_tick;
+        _timer_cv.notify_one();
       }
-      catch (...)
+    }
+  }
+  return true;
+}
+
+void ThreadPool::cancelSleepers()
+{
+  std::vector<Id> requests;
+  {
+    const std::scoped_lock lock(_cancel_mutex);
+    requests.swap(_cancel_requests);
+    _cancel_pending.store(false, std::memory_order_relaxed);
+  }
+
+  // Fibres which have since woken are not found and expire when next resumed.
+  std::vector<Fibre> cancelled;
+  {
+    const std::scoped_lock lock(_timer_mutex);
+    for (const Id &id : requests)
+    {
+      if (Fibre fibre = _timers.remove(id); fibre.valid())
       {
-        log::error(
-          std::format("Thread pool fibre {}:{} unknown exception.", fibre.id().id(), fibre.name()));
+        cancelled.emplace_back(std::move(fibre));
       }
-      return true;  // Unreachable.
     }
+    _sleeping_count.fetch_sub(cancelled.size(), std::memory_order_relaxed);
+  }
+  // Destruction may mark other fibres, routing back to requestCancel().
+  cancelled.clear();
+}
+
+void ThreadPool::requestCancel(void *pool, const Id &id)
+{
+  auto *thread_pool = static_cast<ThreadPool *>(pool);
+  {
+    const std::scoped_lock lock(thread_pool->_cancel_mutex);
+    thread_pool->_cancel_requests.emplace_back(id);
+    thread_pool->_cancel_pending.store(true, std::memory_order_seq_cst);
+  }
+  thread_pool->_idle.notifyOne();
+}
+
+bool ThreadPool::updateNextFibre(uint32_t &selection_index)
+{
+  if (_cancel_pending.load(std::memory_order_acquire))
+  {
+    cancelSleepers();
+  }
+
+  if (!_timer_thread.joinable() && _sleeping_count.load(std::memory_order_relaxed) > 0)
+  {
+    // No timer thread. Wake sleepers here, skipping if another thread is already doing so.
+    std::unique_lock lock(_timer_mutex, std::try_to_lock);
+    if (lock)
+    {
+      wakeSleepers(lock);
+    }
+  }
+
+  pumpInbox();
+
+  if (Worker *worker = currentWorker())
+  {
+    return updateBatch(*worker, selection_index);
+  }
+
+  // Get the next priority fibre. Aging and wait statistics need the time before selecting.
+  const bool early_tick = _aging_ticks > 0 || _wait_statistics;
+  uint64_t tick = (early_tick) ? currentTick() : 0u;
+  std::size_t level = 0;
+  Fibre fibre = nextFibre(selection_index, tick, level);
+  if (fibre.valid())
+  {
+    if (!early_tick)
+    {
+      tick = currentTick();
+    }
+    if (_wait_statistics)
+    {
+      recordWait(fibre, level, tick);
+    }
+    if (resumeFibre(fibre, tick))
+    {
+      requeue(std::move(fibre));
+    }
+    return true;
+  }
+  return false;
+}
+
+bool ThreadPool::updateBatch(Worker &worker, uint32_t &selection_index)
+{
+  if (worker.batch.empty() && !fillBatch(worker, selection_index))
+  {
+    return false;
+  }
 
-    if (resume.reschedule) [[unlikely]]
+  // Resume each fibre once, keeping those which continue at the same priority.
+  std::size_t kept = 0;
+  for (Fibre &fibre : worker.batch)
+  {
+    const int32_t priority = fibre.priority();
+    const uint64_t tick = currentTick();
+    if (_wait_statistics)
+    {
+      recordWait(fibre, worker.batch_level, tick);
+    }
+    if (!resumeFibre(fibre, tick))
+    {
+      continue;
+    }
+    if (fibre.priority() != priority) [[unlikely]]
+    {
+      requeue(std::move(fibre));
+      continue;
+    }
+    if (_wait_statistics)
     {
-      const Priority reschedule = *resume.reschedule;
-      const int32_t initial_priority = fibre.priority();
-      if (initial_priority != reschedule.priority)
+      fibre.__setQueuedTick(currentTick());
+    }
+    if (&worker.batch[kept] != &fibre)
+    {
+      worker.batch[kept] = std::move(fibre);
+    }
+    ++kept;
+  }
+  worker.batch.resize(kept);
+  ++worker.batch_passes;
+
+  // Hand over fibres moving out together, one batch per target. Declined fibres retry later.
+  if (!worker.moves.empty())
+  {
+    worker.moves.flush([this](Fibre &&fibre) { requeue(std::move(fibre)); });
+  }
+
+  if (worker.batch_passes >= BatchPasses || batchPreempted(worker))
+  {
+    flushBatch(worker);
+  }
+  worker.batch_count.store(static_cast<uint32_t>(worker.batch.size()), std::memory_order_relaxed);
+  return true;
+}
+
+bool ThreadPool::fillBatch(Worker &worker, uint32_t &selection_index)
+{
+  // Aging needs the time before selecting.
+  const uint64_t tick = (_aging_ticks > 0) ? currentTick() : 0u;
+  std::size_t level = 0;
+  Fibre fibre = nextFibre(selection_index, tick, level);
+  if (!fibre.valid())
+  {
+    return false;
+  }
+
+  worker.batch_level = level;
+  worker.batch_passes = 0;
+  worker.batch.resize(BatchSize);
+  worker.batch[0] = std::move(fibre);
+  std::size_t count = 1;
+
+  // Top up from the local deque, then the injection queue. Leave half of each for other workers.
+  const std::size_t share = (_worker_states.size() > 1) ? 2u : 1u;
+  WorkStealingDeque &deque = *worker.deques[level];
+  const std::size_t local = std::min(BatchSize - count, deque.size() / share);
+  count += deque.takeOldest(std::span{ worker.batch }.subspan(count, local));
+  SharedQueue &queue = *_fibre_queues[level];
+  const std::size_t injected = std::min(BatchSize - count, queue.size() / share);
+  count += queue.pop(std::span{ worker.batch }.subspan(count, injected));
+
+  worker.batch.resize(count);
+  worker.batch_count.store(static_cast<uint32_t>(count), std::memory_order_relaxed);
+  return true;
+}
+
+bool ThreadPool::batchPreempted(const Worker &worker) const noexcept
+{
+  // Higher priority work is waiting.
+  const uint64_t higher_levels = (uint64_t{ 1 } << worker.batch_level) - 1u;
+  const uint64_t occupied = _injected_levels.load(std::memory_order_relaxed) |
+                            worker.occupied.load(std::memory_order_relaxed);
+  if (occupied & higher_levels)
+  {
+    return true;
+  }
+  // Share the batch with parked workers.
+  return worker.batch.size() > 1 && _idle.waiting();
+}
+
+void ThreadPool::flushBatch(Worker &worker)
+{
+  for (Fibre &fibre : worker.batch)
+  {
+    pushLocal(worker, worker.batch_level, std::move(fibre));
+  }
+  worker.batch.clear();
+  worker.batch_count.store(0, std::memory_order_relaxed);
+  if (worker.deques[worker.batch_level]->size() > 1 && _idle.waiting())
+  {
+    _idle.notifyOne();
+  }
+}
+
+void ThreadPool::discardLocal(Worker &worker)
+{
+  worker.moves.clear();
+  worker.batch.clear();
+  worker.batch_count.store(0, std::memory_order_relaxed);
+  for (auto &deque : worker.deques)
+  {
+    deque->clear();
+  }
+}
+
+bool ThreadPool::resumeFibre(Fibre &fibre, const uint64_t tick)
+{
+  const Resume resume = fibre.resume(tick, _clock.quantisation());
+  if (resume.mode == ResumeMode::Expire) [[unlikely]]
+  {
+    // Expire the fibre.
+    return false;
+  }
+
+  if (resume.mode == ResumeMode::Move) [[unlikely]]
+  {
+    // Workers move fibres out in batches. Other threads move immediately, requeuing on failure.
+    if (Worker *worker = currentWorker())
+    {
+      worker->moves.push(std::move(fibre));
+      return false;
+    }
+    return !MoveBatch::moveNow(fibre);
+  }
+
+  if (resume.mode == ResumeMode::Parked)
+  {
+    // Now owned by a waitable object. Returns via the inbox.
+    _parked_count.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  if (resume.mode == ResumeMode::Exception) [[unlikely]]
+  {
+    // Propagate exception and expire.
+    std::exception_ptr ex = fibre.exception();
+    try
+    {
+      if (ex)
       {
-        SharedQueue &new_queue = selectQueue(reschedule.priority, true);
-        // Update fibre priority and reschedule.
-        fibre.__setPriority(reschedule.priority);
-        // Try push onto the new queue. This may fail, in which case we'll try move it back to the
-        // source queue.
-        if (new_queue.tryPush(fibre))
-        {
-          return true;
-        }
+        std::rethrow_exception(ex);
       }
     }
+    catch (const std::exception &e)
+    {
+      log::error(std::format("Thread pool fibre {}:{} exception: {}", fibre.id().id(),
+                             fibre.name(), e.what()));
+    }
+    catch (...)
+    {
+      log::error(
+        std::format("Thread pool fibre {}:{} unknown exception.", fibre.id().id(), fibre.name()));
+    }
+    return false;
+  }
 
-    // Try requeue the fibre. This may fail if the queue is full. In this case we'll update the
-    // fibre again, hoping the queues will free up. While this avoids a total deadlock, it can still
-    // result in fibre starvation.
-    if (tryPushFibre(fibre))
+  if (resume.reschedule) [[unlikely]]
+  {
+    const Priority reschedule = *resume.reschedule;
+    const int32_t initial_priority = fibre.priority();
+    if (initial_priority != reschedule.priority)
     {
-      return true;
+      // Update fibre priority. Requeuing selects the new priority level.
+      fibre.__setPriority(reschedule.priority);
     }
   }
-  return false;
+
+  // Park sleeping fibres until they are due.
+  return !tryPark(fibre, tick);
+}
+
+void ThreadPool::recordWait(const Fibre &fibre, std::size_t level, uint64_t tick)
+{
+  // The ticker clock may lag a queued tick stamped by a thread which updated the clock directly.
+  const uint64_t queued_tick = fibre.__queuedTick();
+  const uint64_t wait = (tick > queued_tick) ? tick - queued_tick : 0u;
+  if (Worker *worker = currentWorker())
+  {
+    // Single writer. Plain stores keep this cheap while allowing concurrent reads.
+    WaitCounters &counters = worker->waits[level];
+    counters.count.store(counters.count.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+    counters.total_ticks.store(counters.total_ticks.load(std::memory_order_relaxed) + wait,
+                               std::memory_order_relaxed);
+    if (wait > counters.max_ticks.load(std::memory_order_relaxed))
+    {
+      counters.max_ticks.store(wait, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  // Any number of external threads may call update().
+  WaitCounters &counters = _external_waits[level];
+  counters.count.fetch_add(1, std::memory_order_relaxed);
+  counters.total_ticks.fetch_add(wait, std::memory_order_relaxed);
+  uint64_t max_ticks = counters.max_ticks.load(std::memory_order_relaxed);
+  while (wait > max_ticks &&
+         !counters.max_ticks.compare_exchange_weak(max_ticks, wait, std::memory_order_relaxed))
+  {
+  }
+}
+
+std::vector<LevelWaitStatistics> ThreadPool::waitStatistics() const
+{
+  std::vector<LevelWaitStatistics> statistics;
+  if (!_wait_statistics)
+  {
+    return statistics;
+  }
+
+  const double quantisation = _clock.quantisation();
+  for (std::size_t level = 0; level < _fibre_queues.size(); ++level)
+  {
+    uint64_t count = 0;
+    uint64_t total_ticks = 0;
+    uint64_t max_ticks = 0;
+    const auto accumulate = [&count, &total_ticks, &max_ticks](const WaitCounters &counters) {
+      count += counters.count.load(std::memory_order_relaxed);
+      total_ticks += counters.total_ticks.load(std::memory_order_relaxed);
+      max_ticks = std::max(max_ticks, counters.max_ticks.load(std::memory_order_relaxed));
+    };
+
+    accumulate(_external_waits[level]);
+    for (const auto &worker : _worker_states)
+    {
+      accumulate(worker->waits[level]);
+    }
+
+    statistics.emplace_back(LevelWaitStatistics{
+      .priority = _fibre_queues[level]->priority(),
+      .count = count,
+      .total_wait_s = static_cast<double>(total_ticks) * quantisation,
+      .max_wait_s = static_cast<double>(max_ticks) * quantisation,
+    });
+  }
+  return statistics;
+}
+
+void ThreadPool::pumpInbox()
+{
+  if (_inbox.empty())
+  {
+    return;
+  }
+
+  const std::size_t drained = _inbox.drain([this](Fibre &&fibre) { requeue(std::move(fibre)); });
+  _parked_count.fetch_sub(static_cast<int64_t>(drained), std::memory_order_relaxed);
+}
+
+void ThreadPool::wakeFibre(void *pool, Fibre &&fibre)
+{
+  auto *thread_pool = static_cast<ThreadPool *>(pool);
+  thread_pool->_inbox.push(std::move(fibre));
+  thread_pool->_idle.notifyOne();
 }
 }  // namespace morai
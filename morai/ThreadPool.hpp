@@ -2,17 +2,41 @@
 
 #include "Clock.hpp"
 #include "Common.hpp"
+#include "EventCount.hpp"
 #include "Fibre.hpp"
+#include "FrameInbox.hpp"
+#include "MoveBatch.hpp"
 #include "SharedQueue.hpp"
+#include "TimerWheel.hpp"
+#include "WorkStealingDeque.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <thread>
 #include <string_view>
+#include <vector>
 
 namespace morai
 {
+/// Selects how @c ThreadPool workers read the time when resuming fibres.
+enum class PoolTimeSource : uint8_t
+{
+  /// The pool timer thread refreshes the @c Clock every @c ThreadPoolParams::tick_interval while
+  /// workers are active. Workers read the last stored @c Clock::epoch() - a shared, read mostly
+  /// value - so the time resolution is the tick interval.
+  Ticker,
+  /// Workers invoke the clock time function on every resume via @c Clock::now(). Exact, but costs a
+  /// clock read per resume. Does not write shared state.
+  Direct
+};
+
 struct ThreadPoolParams : public SchedulerParams
 {
   /// Number of threads to use in the thread pool. Special semantics are given
@@ -24,25 +48,102 @@ struct ThreadPoolParams : public SchedulerParams
   /// - -1: Use available threads minus one.
   /// - -N: Use available threads minus N (at least 1).
   std::optional<int32_t> worker_count = 0u;
+  /// Sleep duration used while polling in @c ThreadPool::wait(). Idle workers park instead of
+  /// sleeping.
   std::chrono::milliseconds idle_sleep_duration{ 1 };
+  /// Soft limit on the number of fibres waiting in the injection queues. @c ThreadPool::tryStart()
+  /// fails once this is reached. Zero for no limit. Other operations ignore this limit.
+  uint32_t injection_limit = 0u;
+  /// How workers read the time. Threads calling @c ThreadPool::update() which are not pool workers
+  /// always update the clock directly.
+  PoolTimeSource time_source = PoolTimeSource::Ticker;
+  /// Clock refresh interval for @c PoolTimeSource::Ticker.
+  std::chrono::microseconds tick_interval{ 500 };
+  /// Selection weight for each of the @c priority_levels, matched by index. Workers select each
+  /// level in proportion to its weight while the level has fibres. Empty for the default weights -
+  /// N - i for the i-th highest of N levels. Zero weights are treated as one.
+  std::vector<uint32_t> priority_weights{};
+  /// Aging interval for priority levels. Zero to disable aging.
+  ///
+  /// When set, each worker tracks how long each occupied priority level has waited since it last
+  /// served that level. The effective priority of a level improves by one level per interval waited
+  /// and workers take the level with the best effective priority. This bounds how long a worker
+  /// leaves a level unserved under sustained higher priority load.
+  std::chrono::microseconds aging_interval{ 0 };
+  /// Track how long fibres wait in the queues before resuming - see
+  /// @c ThreadPool::waitStatistics(). This costs a clock read per requeue with
+  /// @c PoolTimeSource::Direct.
+  bool wait_statistics = false;
+  /// Slot layout for the injection queues, each of @c initial_queue_size slots. Padded slots
+  /// avoid false sharing between adjacent slots while compact slots save memory. See
+  /// @c SharedQueueParams.
+  SharedQueueParams injection_queue{};
+};
+
+/// Queue wait time statistics for a @c ThreadPool priority level. See
+/// @c ThreadPoolParams::wait_statistics.
+struct LevelWaitStatistics
+{
+  /// The priority level.
+  int32_t priority = 0;
+  /// Number of fibres resumed from this level.
+  uint64_t count = 0;
+  /// Total time the resumed fibres spent waiting in the queues (seconds).
+  double total_wait_s = 0;
+  /// Longest wait in the queues (seconds).
+  double max_wait_s = 0;
+
+  /// Get the mean wait time in seconds.
+  [[nodiscard]] double meanWait() const noexcept
+  {
+    return (count > 0) ? total_wait_s / static_cast<double>(count) : 0.0;
+  }
 };
 
 /// A multi-threaded task scheduler using fibres (coroutines) as tasks.
 ///
 /// The thread pool is created with a number of worker threads - see
-/// @c ThreadPoolParams::worker_count - which continually pop tasks then return them to the worker
-/// queues.
+/// @c ThreadPoolParams::worker_count - which continually take fibres, resume them, then requeue
+/// them.
+///
+/// Each worker owns a @c WorkStealingDeque per priority level. A worker requeues the fibres it
+/// resumes onto its own deques and takes fibres from them in FIFO order, so in the steady state
+/// workers do not contend with each other. Idle workers steal from other workers, choosing victims
+/// at random. The shared priority queues only serve as injection queues for fibres started or
+/// moved into the pool from outside its workers. Workers poll the injection queues periodically
+/// even when they have local work. Fibres started by a worker go to that worker's deque.
+///
+/// Sleeping fibres - `co_await <duration>;` or @c sleep() - are parked in a shared @c TimerWheel
+/// rather than cycling through the queues. When there are workers, a timer thread sleeps until the
+/// earliest deadline, then reinjects due fibres. Without workers, due fibres are reinjected by
+/// @c update(). A sleeping fibre flagged via @c Id::markForCancellation() is removed by the next
+/// worker to look for work, or the next @c update(). Wait conditions, with or without a timeout,
+/// are polled as before.
+///
+/// The pool owns its timekeeping - see @c PoolTimeSource. With @c PoolTimeSource::Ticker, the
+/// timer thread also refreshes the clock while any worker is active and stops ticking once all
+/// workers park.
 ///
-/// The @c ThreadPool also supports priority scheduling. Workers prefer draining higher priority
-/// (lower value) queues.
+/// Workers take a batch of up to @c BatchSize fibres from a single level and resume them round
+/// robin for up to @c BatchPasses passes before returning the survivors to the deque. This
+/// amortises deque and queue synchronisation across many resumes. A batch is returned early when
+/// higher priority work arrives or other workers are parked.
+///
+/// Idle workers spin briefly, then park on an @c EventCount. Starting, moving or waking a fibre
+/// wakes one parked worker, as does a worker accumulating more than one local fibre.
+///
+/// Each injection queue is a fixed size @c SharedQueue backed by an unbounded, lock free overflow
+/// list. Pushing into the pool never fails, blocks or sleeps. Use @c tryStart() to apply
+/// backpressure - see @c ThreadPoolParams::injection_limit.
+///
+/// The @c ThreadPool also supports priority scheduling, with up to @c MaxPriorityLevels levels.
+/// Workers select levels by weighted round robin - see @c ThreadPoolParams::priority_weights. The
+/// pool tracks which levels hold fibres in occupancy bitmaps, so empty levels are skipped without
+/// probing their queues. When the scheduled level is empty, the worker takes the highest priority
+/// (lowest value) level with fibres.
 ///
 /// @c ThreadPool::worker_count may be zero in which case the user must call @c update() must be
 /// called to process tasks. This can be used to control the thread pool manually.
-/// Unlike the @c Scheduler, the @c ThreadPool has fixed size queues. Calling @c start() blocks
-/// until there is space in the queue to add the new fibre to the target priority queue. As such
-/// it is possible to deadlock the thread pool as all workers try to push back their fibre to a full
-/// queue. There is current no solution to this issue. This process also sleeps the pushing thread
-/// for @c ThreadPoolParams::idle_sleep_duration so pushing to a full queue is expensive.
 class ThreadPool
 {
 public:
@@ -55,6 +156,9 @@ public:
   ThreadPool &operator=(const ThreadPool &) = delete;
   ThreadPool &operator=(ThreadPool &&) = delete;
 
+  /// Maximum number of priority levels. Additional, lower priority levels are dropped.
+  static constexpr std::size_t MaxPriorityLevels = 64u;
+
   /// Returns true if there are no running fibres.
   [[nodiscard]] bool empty() const noexcept;
 
@@ -91,6 +195,28 @@ public:
     return start(std::move(fibre), 0, std::move(name));
   }
 
+  /// Try start a fibre, respecting @c ThreadPoolParams::injection_limit.
+  ///
+  /// Fails when called from outside the pool workers and the injection queues hold at least
+  /// @c ThreadPoolParams::injection_limit fibres. The @p fibre remains valid on failure so the
+  /// caller may retry later. Otherwise behaves as @c start().
+  ///
+  /// @param fibre The fibre entry point. Invalidated on success.
+  /// @param priority Scheduling priority.
+  /// @param name Optional name.
+  /// @return The fibre @c Id on success, or @c std::nullopt when over the injection limit.
+  std::optional<Id> tryStart(Fibre &fibre, int32_t priority = 0, std::string_view name = {});
+
+  /// Return the (approximate) number of fibres waiting in the injection queues, including overflow.
+  [[nodiscard]] std::size_t injectedCount() const noexcept;
+
+  /// Get queue wait time statistics for each priority level, in priority order (threadsafe).
+  ///
+  /// Wait time is measured from when a fibre is started, moved, woken or requeued, until it next
+  /// resumes. Empty unless @c ThreadPoolParams::wait_statistics is set. Statistics accumulate for
+  /// the lifetime of the pool, so diff successive snapshots to measure an interval.
+  [[nodiscard]] std::vector<LevelWaitStatistics> waitStatistics() const;
+
   /// Cancel all running fibres.
   void cancelAll();
 
@@ -124,29 +250,234 @@ public:
   /// Success is indicated by the return value.
   ///
   /// Fibres are immediately inserted into the priority queue most closely matching the fibre
-  /// priority (lower bound).
+  /// priority (lower bound). This always succeeds as the injection queues overflow as required.
   ///
   /// @param fibre A reference to the fibre to move.
   /// @return True on success, in which case the @p fibre argument becomes invalid.
   bool move(Fibre &fibre, std::optional<int32_t> priority = std::nullopt);
 
+  /// Move @p fibres into the task pool (threadsafe). The fibres keep their current priorities.
+  /// Runs of fibres sharing a priority level are injected with bulk queue operations. See
+  /// @c BatchSchedulerType.
+  ///
+  /// @param fibres The fibres to move. All become invalid.
+  /// @return The number of fibres moved - always @c fibres.size().
+  std::size_t move(std::span<Fibre> fibres);
+
 private:
-  SharedQueue &selectQueue(int32_t priority, bool quiet);
-  [[nodiscard]] bool tryPushFibre(Fibre &fibre);
+  /// Queue wait counters for a priority level, in clock ticks.
+  struct WaitCounters
+  {
+    std::atomic_uint64_t count{ 0 };
+    std::atomic_uint64_t total_ticks{ 0 };
+    std::atomic_uint64_t max_ticks{ 0 };
+  };
+
+  /// Per worker state. See @c WorkStealingDeque.
+  struct Worker
+  {
+    /// Bit per priority level set while the local deque may hold fibres. Written by the owner only
+    /// and read by thieves, so a bit may remain set after thieves empty the deque.
+    std::atomic_uint64_t occupied{ 0 };
+    /// Local deques, one per priority level.
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+    /// Counts fibre selections to periodically poll the injection queues first. Aligned away from
+    /// @c occupied as thieves read that.
+    alignas(64) uint32_t tick = 0;
+    /// Adaptive number of idle iterations to spin before parking.
+    uint32_t spin_limit = MaxIdleSpins;
+    /// Levels seen occupied since last found empty. Used for aging.
+    uint64_t aging_seen = 0;
+    /// The tick at which each level was last served, or first seen occupied. Used for aging.
+    std::vector<uint64_t> waiting_since;
+    /// Wait statistics per level. Written by the owner only.
+    std::unique_ptr<WaitCounters[]> waits;
+    /// Run batch. Fibres taken from a single level and resumed round robin. Owner only.
+    std::vector<Fibre> batch;
+    /// The level the @c batch was taken from.
+    std::size_t batch_level = 0;
+    /// Number of passes made over the @c batch.
+    uint32_t batch_passes = 0;
+    /// The last @c _cancel_epoch seen by the worker.
+    uint32_t cancel_epoch = 0;
+    /// Size of the @c batch, readable by other threads.
+    std::atomic_uint32_t batch_count{ 0 };
+    /// Fibres moving out to other schedulers. Flushed after each pass over the @c batch.
+    MoveBatch moves;
+  };
+
+  /// Number of selections between a worker preferring the injection queues over its local deque.
+  static constexpr uint32_t InjectionInterval = 31u;
+  /// Bounds for @c Worker::spin_limit. The limit grows when spinning finds work and shrinks when
+  /// the worker parks.
+  static constexpr uint32_t MinIdleSpins = 4u;
+  static constexpr uint32_t MaxIdleSpins = 256u;
+  /// Maximum number of fibres in a worker run batch.
+  static constexpr std::size_t BatchSize = 16u;
+  /// Number of passes over a run batch before returning the fibres to the deque.
+  static constexpr uint32_t BatchPasses = 4u;
+
+  /// Get the @c Worker for the calling thread, or null if it is not a worker of this pool.
+  [[nodiscard]] Worker *currentWorker() const noexcept;
+  /// Select the priority level index best matching @p priority.
+  [[nodiscard]] std::size_t selectLevel(int32_t priority, bool quiet) const;
+  /// Requeue a @p fibre on the calling worker's deque, or the injection queues for non-workers.
+  void requeue(Fibre &&fibre);
+  /// Push a @p fibre onto the @p worker deque at @p level, marking the level occupied. Owner only.
+  static void pushLocal(Worker &worker, std::size_t level, Fibre &&fibre);
+  /// Push a @p fibre into the injection queue at @p level, overflowing as required (threadsafe).
+  void inject(Fibre &&fibre, std::size_t level);
+  /// Push all @p fibres into the injection queue at @p level with bulk claims, overflowing as
+  /// required (threadsafe). The @p fibres are invalidated.
+  void inject(std::span<Fibre> fibres, std::size_t level);
+  /// Pop a fibre from the injection queue at @p level. Fibres in the overflow list are also taken;
+  /// a calling @p worker moves them to its deque, otherwise they are pushed into the queue.
+  [[nodiscard]] Fibre popInjected(std::size_t level, Worker *worker);
+  /// Steal a fibre at the given priority @p level from a randomly chosen worker other than
+  /// @p thief.
+  [[nodiscard]] Fibre stealFibre(const Worker *thief, std::size_t level);
+  /// Get the levels which other workers' deques may hold fibres at, excluding @p thief.
+  [[nodiscard]] uint64_t stealableLevels(const Worker *thief) const noexcept;
+  /// Clear the @c _injected_levels bit for @p level unless fibres remain in its injection queue.
+  void clearInjectedLevel(std::size_t level) noexcept;
+  /// Select a level from the @p occupied bitmap. Takes the level scheduled at @p selection_index
+  /// if occupied, otherwise the highest priority occupied level. Advances @p selection_index.
+  [[nodiscard]] std::size_t selectOccupiedLevel(uint64_t occupied,
+                                                uint32_t &selection_index) const noexcept;
+  /// Try take a fibre at the given @p level from the injection queue, the @p worker deque or by
+  /// stealing.
+  [[nodiscard]] Fibre takeFibre(std::size_t level, Worker *worker, bool injection_first);
+  /// Check for fibres in any queue, deque, the inbox or the timers. Excludes fibres parked on
+  /// waitable objects.
+  [[nodiscard]] bool hasQueuedFibres() const noexcept;
+  /// Check for work an idle worker should wake for: fibres in the inbox or injection queues, a
+  /// worker deque holding more than one fibre or pending sleeper cancellations. A single fibre is
+  /// left to its owner.
+  [[nodiscard]] bool hasIdleWork() const noexcept;
   [[nodiscard]] Fibre nextPriorityFibre();
-  [[nodiscard]] Fibre nextFibre(uint32_t &selection_index);
+  /// Apply aging to the @p selected level. Returns the level from @p occupied with the best
+  /// effective priority at @p tick, updating the @p worker aging state.
+  [[nodiscard]] std::size_t agedLevel(Worker &worker, uint64_t occupied, std::size_t selected,
+                                      uint64_t tick) const noexcept;
+  /// Take the next fibre to resume, setting the @p level it was taken from. The @p tick is only
+  /// required for aging.
+  [[nodiscard]] Fibre nextFibre(uint32_t &selection_index, uint64_t tick, std::size_t &level);
+  /// Record the queue wait time for a @p fibre taken from @p level at @p tick.
+  void recordWait(const Fibre &fibre, std::size_t level, uint64_t tick);
 
   void createQueues(ThreadPoolParams &params);
   void startWorkers(ThreadPoolParams &params);
-  void workerThread(int32_t thread_index, std::chrono::milliseconds idle_sleep_duration);
+  void workerThread(Worker &worker);
+  /// Timer thread entry point. Sleeps until the next timer deadline then calls @c wakeSleepers().
+  /// Also refreshes the clock for @c PoolTimeSource::Ticker.
+  void timerThread();
+  /// Get the current @c Clock::tick() for resuming fibres on the calling thread according to
+  /// @c _time_source.
+  [[nodiscard]] uint64_t currentTick();
+  /// Restart a ticker which stopped as all workers parked. Called by workers leaving the idle
+  /// state.
+  void resumeTicker();
+  /// Advance the @c _timers and reinject due fibres. Requires @c _timer_mutex to be locked.
+  /// @return The number of fibres woken.
+  std::size_t wakeSleepers(std::unique_lock<std::mutex> &lock);
+  /// Park a sleeping @p fibre in the @c _timers until it is due. Only pure sleeps are parked.
+  /// @return True if the fibre was parked.
+  bool tryPark(Fibre &fibre, uint64_t tick);
+  /// Cancel sleeping fibres in the @c _cancel_requests. Fibres are destroyed outside the
+  /// @c _timer_mutex.
+  void cancelSleepers();
+  /// @c detail::CancellationRouter handler. Queues @p id in the @c _cancel_requests and wakes a
+  /// worker (threadsafe).
+  static void requestCancel(void *pool, const Id &id);
+  /// Spin then park an idle @p worker until notified of new work.
+  void idle(Worker &worker, uint32_t &idle_spins);
+  /// Resume the next fibre, or the run batch for workers.
+  /// @return False when there is no fibre to resume.
   bool updateNextFibre(uint32_t &selection_index);
+  /// Make one pass over the @p worker run batch, filling it first when empty.
+  /// @return False when there is no fibre to resume.
+  bool updateBatch(Worker &worker, uint32_t &selection_index);
+  /// Fill the empty @p worker run batch with fibres from a single level.
+  /// @return False when there is no fibre to resume.
+  bool fillBatch(Worker &worker, uint32_t &selection_index);
+  /// Check if the @p worker should return its batch early, for higher priority work or to share
+  /// with parked workers.
+  [[nodiscard]] bool batchPreempted(const Worker &worker) const noexcept;
+  /// Return the @p worker run batch to its deque.
+  void flushBatch(Worker &worker);
+  /// Destroy the fibres in the @p worker run batch and deques. Owner only.
+  static void discardLocal(Worker &worker);
+  /// Resume a @p fibre and handle the result.
+  /// @return True if the fibre remains valid and should be requeued.
+  [[nodiscard]] bool resumeFibre(Fibre &fibre, uint64_t tick);
+  /// Move woken fibres from the @c _inbox into the priority queues.
+  void pumpInbox();
+  /// @c detail::Home wake function. Pushes the @p fibre into the @c _inbox (threadsafe).
+  static void wakeFibre(void *pool, Fibre &&fibre);
+  /// Get the number of parked fibres, clamping transient negative counts.
+  [[nodiscard]] std::size_t parkedCount() const noexcept
+  {
+    const int64_t count = _parked_count.load(std::memory_order_relaxed);
+    return static_cast<std::size_t>(std::max<int64_t>(count, 0));
+  }
 
   std::vector<std::unique_ptr<SharedQueue>> _fibre_queues;
-  std::vector<uint32_t> _queue_weighted_selection;
+  /// Unbounded overflow for each of the @c _fibre_queues.
+  std::vector<std::unique_ptr<FrameInbox>> _overflow;
+  /// Number of fibres across the @c _overflow lists. Signed as a drain may be counted before the
+  /// corresponding push.
+  std::atomic_int64_t _overflow_count{ 0 };
+  /// Weighted round robin level schedule generated from @c ThreadPoolParams::priority_weights.
+  std::vector<uint32_t> _level_selection;
+  /// Bit per priority level set while the injection queue or its overflow may hold fibres.
+  alignas(64) std::atomic_uint64_t _injected_levels{ 0 };
+  /// Receives fibres woken from a waitable object, such as an @c Event.
+  FrameInbox _inbox;
+  /// Home assigned to our fibres. We hold one reference, parked fibres hold the others.
+  detail::Home *_home = nullptr;
+  /// Number of fibres parked on waitable objects. Signed as a fibre may be woken and drained by
+  /// another worker before the parking worker counts it.
+  std::atomic_int64_t _parked_count{ 0 };
+  /// Parks idle workers.
+  EventCount _idle;
+  /// Sleeping fibres. Guarded by @c _timer_mutex.
+  TimerWheel _timers;
+  std::mutex _timer_mutex;
+  /// Wakes the timer thread for quit or an earlier deadline.
+  std::condition_variable _timer_cv;
+  /// The tick the timer thread will next wake at. Guarded by @c _timer_mutex.
+  uint64_t _timer_wake_tick = ~uint64_t{ 0 };
+  /// Number of fibres in the @c _timers, readable without the lock.
+  std::atomic_size_t _sleeping_count{ 0 };
+  /// Scratch buffer for fibres expiring from @c _timers. Guarded by @c _timer_mutex.
+  std::vector<Fibre> _woken;
+  /// Ids of sleeping fibres marked for cancellation. Guarded by @c _cancel_mutex, which is never
+  /// held while destroying fibres.
+  std::vector<Id> _cancel_requests;
+  /// Set while @c _cancel_requests is not empty.
+  std::atomic_bool _cancel_pending{ false };
+  std::mutex _cancel_mutex;
+  /// Set while the ticker has stopped because all workers are parked.
+  std::atomic_bool _ticker_idle{ false };
+  /// Worker states, indexed by worker. Created before the worker threads start.
+  std::vector<std::unique_ptr<Worker>> _worker_states;
   std::vector<std::jthread> _workers;
+  /// Reinjects sleeping fibres. Only started when there are workers.
+  std::jthread _timer_thread;
   std::atomic_flag _paused = ATOMIC_FLAG_INIT;
+  /// Incremented by @c cancelAll(). Workers discard their local fibres on seeing a new epoch.
+  std::atomic_uint32_t _cancel_epoch{ 0 };
   std::atomic_flag _quit = ATOMIC_FLAG_INIT;
   std::chrono::milliseconds _idle_sleep_duration{ 1 };
-  Clock _clock;
+  uint32_t _injection_limit = 0;
+  PoolTimeSource _time_source = PoolTimeSource::Ticker;
+  std::chrono::microseconds _tick_interval{ 500 };
+  /// @c ThreadPoolParams::aging_interval in clock ticks. Zero when aging is disabled.
+  uint64_t _aging_ticks = 0;
+  bool _wait_statistics = false;
+  /// Wait statistics for fibres resumed by threads which are not pool workers.
+  std::unique_ptr<WaitCounters[]> _external_waits;
+  /// Read by all workers, written by the ticker. Aligned last to keep it on its own cache line.
+  alignas(64) Clock _clock;
 };
 }  // namespace morai
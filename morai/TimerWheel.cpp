@@ -0,0 +1,226 @@
+#include "TimerWheel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+
+namespace morai
+{
+namespace
+{
+constexpr uint64_t slotMask = TimerWheel::SlotCount - 1u;
+
+/// Calculate the first granule of @p slot at @p level in the wheel rotation containing @p granule.
+constexpr uint64_t slotStart(const uint64_t granule, const unsigned level, const unsigned slot)
+{
+  const unsigned shift = level * TimerWheel::SlotBits;
+  const unsigned upper_shift = shift + TimerWheel::SlotBits;
+  const uint64_t rotation = (upper_shift < 64u) ? ((granule >> upper_shift) << upper_shift) : 0u;
+  return rotation | (static_cast<uint64_t>(slot) << shift);
+}
+}  // namespace
+
+TimerWheel::TimerWheel(uint64_t granularity)
+  : _granularity(std::max<uint64_t>(granularity, 1u))
+{}
+
+TimerWheel::~TimerWheel()
+{
+  clear();
+}
+
+void TimerWheel::insert(Fibre &&fibre, const uint64_t deadline_tick)
+{
+  // Round up so we never expire early.
+  const uint64_t deadline =
+    deadline_tick / _granularity + static_cast<uint64_t>(deadline_tick % _granularity != 0);
+  const Id id = fibre.id();
+  place({ .fibre = std::move(fibre), .id = id, .deadline = std::max(deadline, _elapsed) });
+  ++_size;
+}
+
+void TimerWheel::advance(const uint64_t now_tick, std::vector<Fibre> &expired)
+{
+  const uint64_t now = now_tick / _granularity;
+  while (_size > 0 && _elapsed <= now)
+  {
+    unsigned next_level = 0;
+    unsigned next_slot = 0;
+    const uint64_t next = findNext(next_level, next_slot);
+    if (next > now)
+    {
+      break;
+    }
+
+    // Process the slot: expire due entries and cascade the remainder into lower levels.
+    _elapsed = next;
+    _occupied[next_level] &= ~(uint64_t{ 1 } << next_slot);
+    std::swap(_cascade, _buckets[next_level * SlotCount + next_slot]);
+    for (Entry &entry : _cascade)
+    {
+      if (entry.deadline <= _elapsed)
+      {
+        expired.emplace_back(std::move(entry.fibre));
+        --_size;
+      }
+      else
+      {
+        place(std::move(entry));
+      }
+    }
+    _cascade.clear();
+
+    if (next_level == 0)
+    {
+      // The granule is fully processed.
+      ++_elapsed;
+    }
+  }
+
+  _elapsed = std::max(_elapsed, now + 1u);
+}
+
+std::optional<uint64_t> TimerWheel::nextExpiry() const
+{
+  if (_size == 0)
+  {
+    return std::nullopt;
+  }
+
+  unsigned level = 0;
+  unsigned slot = 0;
+  const uint64_t next = findNext(level, slot);
+  if (next > std::numeric_limits<uint64_t>::max() / _granularity)
+  {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return next * _granularity;
+}
+
+bool TimerWheel::contains(const Id &id) const
+{
+  std::size_t index = 0;
+  return locate(id, index) != InvalidBucket;
+}
+
+bool TimerWheel::cancel(const Id &id)
+{
+  // The removed fibre is destroyed on return, once the wheel is consistent.
+  const Fibre removed = remove(id);
+  return removed.valid();
+}
+
+Fibre TimerWheel::remove(const Id &id)
+{
+  std::size_t index = 0;
+  const uint32_t bucket_index = locate(id, index);
+  if (bucket_index == InvalidBucket)
+  {
+    return {};
+  }
+
+  // Swap remove, tracking the entry moved into the vacated position.
+  std::vector<Entry> &bucket = _buckets[bucket_index];
+  Entry removed = std::move(bucket[index]);
+  if (index + 1 < bucket.size())
+  {
+    bucket[index] = std::move(bucket.back());
+    track(bucket[index], bucket_index, index);
+  }
+  bucket.pop_back();
+  if (bucket.empty())
+  {
+    _occupied[bucket_index / SlotCount] &= ~(uint64_t{ 1 } << (bucket_index % SlotCount));
+  }
+  --_size;
+  return std::move(removed.fibre);
+}
+
+void TimerWheel::clear()
+{
+  // Empty the wheel before destroying the fibres, as a fibre destructor may cancel another fibre in
+  // this wheel.
+  std::vector<Fibre> discard;
+  discard.reserve(_size);
+  for (auto &bucket : _buckets)
+  {
+    for (Entry &entry : bucket)
+    {
+      discard.emplace_back(std::move(entry.fibre));
+    }
+    bucket.clear();
+  }
+  _occupied.fill(0);
+  _size = 0;
+}
+
+uint64_t TimerWheel::findNext(unsigned &next_level, unsigned &next_slot) const
+{
+  uint64_t next = std::numeric_limits<uint64_t>::max();
+  for (unsigned level = LevelCount; level-- > 0;)
+  {
+    const unsigned current = (_elapsed >> (level * SlotBits)) & slotMask;
+    const uint64_t pending = _occupied[level] & (~uint64_t{ 0 } << current);
+    if (!pending)
+    {
+      continue;
+    }
+    const unsigned slot = static_cast<unsigned>(std::countr_zero(pending));
+    const uint64_t start = std::max(slotStart(_elapsed, level, slot), _elapsed);
+    if (start < next)
+    {
+      next = start;
+      next_level = level;
+      next_slot = slot;
+    }
+  }
+  return next;
+}
+
+void TimerWheel::place(Entry &&entry)
+{
+  // The level is given by the most significant slot group in which the deadline differs from the
+  // elapsed granule. This keeps each entry within the current rotation of its level.
+  const uint64_t differ = entry.deadline ^ _elapsed;
+  const unsigned level =
+    (differ) ? static_cast<unsigned>(std::bit_width(differ) - 1) / SlotBits : 0u;
+  const unsigned slot = (entry.deadline >> (level * SlotBits)) & slotMask;
+  const uint32_t bucket_index = level * SlotCount + slot;
+
+  std::vector<Entry> &bucket = _buckets[bucket_index];
+  track(entry, bucket_index, bucket.size());
+  bucket.emplace_back(std::move(entry));
+  _occupied[level] |= uint64_t{ 1 } << slot;
+}
+
+uint32_t TimerWheel::locate(const Id &id, std::size_t &index) const
+{
+  const detail::IdSlot *slot = detail::IdTable::find(id);
+  if (!slot || slot->owner.load(std::memory_order_relaxed) != this)
+  {
+    return InvalidBucket;
+  }
+
+  // Validate as the location may be stale.
+  const uint64_t position = slot->position.load(std::memory_order_relaxed);
+  const auto bucket_index = static_cast<uint32_t>(position >> 32u);
+  index = static_cast<std::size_t>(position & 0xffffffffu);
+  if (bucket_index >= _buckets.size() || index >= _buckets[bucket_index].size() ||
+      _buckets[bucket_index][index].id != id)
+  {
+    return InvalidBucket;
+  }
+  return bucket_index;
+}
+
+void TimerWheel::track(const Entry &entry, const uint32_t bucket, const std::size_t index) const
+{
+  if (detail::IdSlot *slot = detail::IdTable::find(entry.id))
+  {
+    slot->owner.store(this, std::memory_order_relaxed);
+    slot->position.store((static_cast<uint64_t>(bucket) << 32u) | index,
+                         std::memory_order_relaxed);
+  }
+}
+}  // namespace morai
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Fibre.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace morai
+{
+/// A single threaded, hierarchical timing wheel used to park sleeping fibres until their deadline.
+///
+/// Time is measured in @c Clock::tick() values and bucketed into granules of @c granularity()
+/// ticks. Each level has @c SlotCount slots and each slot in a level spans @c SlotCount times the
+/// granules of the level below. There are enough levels to cover the full 64-bit granule range, so
+/// no deadline ever overflows the wheel.
+///
+/// Fibres are @c insert() ed with an absolute deadline tick and returned via @c advance() once the
+/// deadline granule has passed. A fibre is never returned before its deadline granule, but may be
+/// returned up to one granule late. Fibres in higher levels are cascaded into lower levels as time
+/// progresses. @c advance() skips directly to the next occupied slot using per level occupancy
+/// bitmaps, so the cost of an update scales with the number of expiring fibres rather than the
+/// number of sleeping fibres or the elapsed time.
+///
+/// Parked fibres may be removed by @c Id via @c cancel(). This is a constant time lookup via the
+/// fibre's @c detail::IdTable slot.
+///
+/// Not threadsafe.
+class TimerWheel
+{
+public:
+  /// Log2 of the number of slots per level.
+  static constexpr unsigned SlotBits = 6u;
+  /// Number of slots per level.
+  static constexpr unsigned SlotCount = 1u << SlotBits;
+  /// Number of levels required to span 64-bit granule values.
+  static constexpr unsigned LevelCount = (64u + SlotBits - 1u) / SlotBits;
+
+  /// Create a timing wheel.
+  /// @param granularity The number of @c Clock::tick() values per granule. Must be non zero.
+  explicit TimerWheel(uint64_t granularity = 1000u);
+  ~TimerWheel();
+
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel(TimerWheel &&) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+  TimerWheel &operator=(TimerWheel &&) = delete;
+
+  /// Get the number of @c Clock::tick() values per granule.
+  [[nodiscard]] uint64_t granularity() const noexcept { return _granularity; }
+
+  /// Returns the number of parked fibres.
+  [[nodiscard]] std::size_t size() const noexcept { return _size; }
+  /// Returns true if there are no parked fibres.
+  [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+  /// Park the @p fibre until the given @p deadline_tick. A deadline which has already passed
+  /// expires on the next @c advance().
+  /// @param fibre The fibre to park.
+  /// @param deadline_tick The absolute @c Clock::tick() at which to expire the fibre.
+  void insert(Fibre &&fibre, uint64_t deadline_tick);
+
+  /// Advance the wheel to @p now_tick, appending all expired fibres to @p expired in deadline
+  /// order.
+  /// @param now_tick The current @c Clock::tick(). Must be monotonic.
+  /// @param expired Container to append expired fibres to.
+  void advance(uint64_t now_tick, std::vector<Fibre> &expired);
+
+  /// Get a lower bound on the tick at which the next fibre expires. This is exact for fibres due
+  /// within the current rotation of the lowest level, otherwise the start of the slot holding the
+  /// fibre. Waking at this tick and calling @c advance() either expires fibres or cascades them.
+  /// @return The next expiry tick, or @c std::nullopt when empty.
+  [[nodiscard]] std::optional<uint64_t> nextExpiry() const;
+
+  /// Returns true if the wheel contains a fibre with the given @p id.
+  [[nodiscard]] bool contains(const Id &id) const;
+
+  /// Cancel a parked fibre with the given @p id. The fibre immediately terminates.
+  /// @param id The @c Id of the fibre to cancel.
+  /// @return True if the fibre was found and cancelled.
+  bool cancel(const Id &id);
+
+  /// Remove a parked fibre with the given @p id without destroying it. Use this to destroy the
+  /// fibre outside a lock guarding the wheel.
+  /// @param id The @c Id of the fibre to remove.
+  /// @return The removed fibre, or an invalid fibre if not found.
+  [[nodiscard]] Fibre remove(const Id &id);
+
+  /// Clear all parked fibres.
+  void clear();
+
+private:
+  /// A parked fibre. The @c Id is cached to avoid touching the coroutine frame.
+  struct Entry
+  {
+    Fibre fibre;
+    Id id;
+    uint64_t deadline = 0;  ///< Deadline granule.
+  };
+
+  static constexpr uint32_t InvalidBucket = ~0u;
+
+  /// Find the next occupied slot at or after @c _elapsed. Ties prefer the higher level, which
+  /// cascades into the lower levels first.
+  /// @return The first granule of the slot, or @c UINT64_MAX when empty.
+  [[nodiscard]] uint64_t findNext(unsigned &next_level, unsigned &next_slot) const;
+
+  /// Place an @p entry in the bucket appropriate to its deadline relative to @c _elapsed.
+  void place(Entry &&entry);
+  /// Find the bucket containing @p id, setting @p index to the entry index.
+  [[nodiscard]] uint32_t locate(const Id &id, std::size_t &index) const;
+  /// Record the location of an entry in its @c detail::IdTable slot.
+  void track(const Entry &entry, uint32_t bucket, std::size_t index) const;
+
+  /// Slot storage: @c LevelCount levels of @c SlotCount buckets.
+  std::array<std::vector<Entry>, LevelCount * SlotCount> _buckets{};
+  /// Per level slot occupancy bitmaps.
+  std::array<uint64_t, LevelCount> _occupied{};
+  /// Scratch storage used to cascade a bucket.
+  std::vector<Entry> _cascade;
+  /// The next granule to be processed. All earlier granules have expired.
+  uint64_t _elapsed = 0;
+  uint64_t _granularity = 1;
+  std::size_t _size = 0;
+};
+}  // namespace morai
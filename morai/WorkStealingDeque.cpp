@@ -0,0 +1,137 @@
+#include "WorkStealingDeque.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace morai
+{
+namespace
+{
+using Handle = std::coroutine_handle<Fibre::promise_type>;
+}  // namespace
+
+WorkStealingDeque::WorkStealingDeque(uint32_t capacity)
+{
+  capacity = std::bit_ceil(std::max<uint32_t>(capacity, 16u));
+  _buffers.emplace_back(std::make_unique<Buffer>(capacity));
+  _buffer.store(_buffers.back().get(), std::memory_order_relaxed);
+}
+
+WorkStealingDeque::~WorkStealingDeque()
+{
+  clear();
+}
+
+void WorkStealingDeque::push(Fibre &&fibre)
+{
+  const int64_t bottom = _bottom.load(std::memory_order_relaxed);
+  const int64_t top = _top.load(std::memory_order_acquire);
+  Buffer *buffer = _buffer.load(std::memory_order_relaxed);
+  if (bottom - top > buffer->capacity() - 1)
+  {
+    buffer = grow(buffer, top, bottom);
+  }
+  buffer->put(bottom, fibre.__release().address());
+  // Release publishes the item and the fibre frame to thieves.
+  _bottom.store(bottom + 1, std::memory_order_release);
+}
+
+Fibre WorkStealingDeque::pop()
+{
+  const int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+  Buffer *buffer = _buffer.load(std::memory_order_relaxed);
+  // The bottom store must be ordered before the top load, so thieves see the claim.
+  _bottom.store(bottom, std::memory_order_seq_cst);
+  int64_t top = _top.load(std::memory_order_seq_cst);
+
+  if (top > bottom)
+  {
+    // Empty.
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    return {};
+  }
+
+  void *item = buffer->get(bottom);
+  if (top == bottom)
+  {
+    // Last item. Race thieves for it.
+    if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
+    {
+      item = nullptr;
+    }
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  return (item) ? Fibre{ Handle::from_address(item) } : Fibre{};
+}
+
+Fibre WorkStealingDeque::steal()
+{
+  int64_t top = _top.load(std::memory_order_seq_cst);
+  const int64_t bottom = _bottom.load(std::memory_order_seq_cst);
+  if (top >= bottom)
+  {
+    return {};
+  }
+
+  const Buffer *buffer = _buffer.load(std::memory_order_acquire);
+  void *item = buffer->get(top);
+  if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed))
+  {
+    // Lost the race to another thief or the owner.
+    return {};
+  }
+  return Fibre{ Handle::from_address(item) };
+}
+
+std::size_t WorkStealingDeque::takeOldest(std::span<Fibre> fibres)
+{
+  // Only the owner moves the bottom or the buffer, so both are stable here.
+  const int64_t bottom = _bottom.load(std::memory_order_relaxed);
+  const Buffer *buffer = _buffer.load(std::memory_order_relaxed);
+  int64_t top = _top.load(std::memory_order_seq_cst);
+  for (;;)
+  {
+    const int64_t count = std::min<int64_t>(bottom - top, static_cast<int64_t>(fibres.size()));
+    if (count <= 0)
+    {
+      return 0;
+    }
+
+    // Claim [top, top + count). On failure a thief took the top item and top is reloaded.
+    if (_top.compare_exchange_strong(top, top + count, std::memory_order_seq_cst,
+                                     std::memory_order_seq_cst))
+    {
+      for (int64_t i = 0; i < count; ++i)
+      {
+        fibres[static_cast<std::size_t>(i)] = Fibre{ Handle::from_address(buffer->get(top + i)) };
+      }
+      return static_cast<std::size_t>(count);
+    }
+  }
+}
+
+void WorkStealingDeque::clear()
+{
+  while (!empty())
+  {
+    Fibre discard = pop();
+  }
+}
+
+WorkStealingDeque::Buffer *WorkStealingDeque::grow(Buffer *buffer, int64_t top, int64_t bottom)
+{
+  auto grown = std::make_unique<Buffer>(buffer->capacity() * 2);
+  for (int64_t i = top; i < bottom; ++i)
+  {
+    grown->put(i, buffer->get(i));
+  }
+  buffer = grown.get();
+  _buffers.emplace_back(std::move(grown));
+  // Release publishes the copied items to thieves.
+  _buffer.store(buffer, std::memory_order_release);
+  return buffer;
+}
+}  // namespace morai
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Fibre.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace morai
+{
+/// A Chase-Lev work stealing deque of fibres.
+///
+/// The deque has a single owner thread which may @c push() and @c pop() at the bottom without
+/// contention - only taking the last item requires a CAS. Any thread may @c steal() from the top,
+/// taking the oldest item. This gives the owner LIFO access while thieves take work in FIFO order.
+///
+/// The deque grows as required. Retired buffers are retained until the deque is destroyed as
+/// thieves may still be reading from them.
+///
+/// @par Implementation
+///
+/// Follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al., 2013), using
+/// sequentially consistent operations in place of standalone fences.
+class WorkStealingDeque
+{
+public:
+  /// Create a deque with the given initial @p capacity, rounded up to a power of two.
+  explicit WorkStealingDeque(uint32_t capacity = 256u);
+  /// Destructor - destroys any remaining fibres. Must not be called while other threads may steal.
+  ~WorkStealingDeque();
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque(WorkStealingDeque &&) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(WorkStealingDeque &&) = delete;
+
+  /// Estimate the number of items in the deque (threadsafe).
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    const int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    const int64_t top = _top.load(std::memory_order_relaxed);
+    return static_cast<std::size_t>(std::max<int64_t>(bottom - top, 0));
+  }
+
+  /// Check if the deque is empty. This may be inaccurate as other threads may steal.
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  /// Push a fibre onto the bottom of the deque. Owner thread only.
+  /// @param fibre The fibre to push. Must be valid.
+  void push(Fibre &&fibre);
+
+  /// Pop the most recently pushed fibre from the bottom of the deque. Owner thread only.
+  /// @return The fibre, or an invalid fibre when empty.
+  [[nodiscard]] Fibre pop();
+
+  /// Steal the oldest fibre from the top of the deque (threadsafe).
+  ///
+  /// May spuriously fail when racing with another thread for the same item.
+  /// @return The fibre, or an invalid fibre when empty or on losing a race.
+  [[nodiscard]] Fibre steal();
+
+  /// Take up to @c fibres.size() of the oldest fibres from the top of the deque with a single
+  /// claim. Owner thread only - races thieves, but must not race @c pop().
+  /// @param fibres Receives the fibres, oldest first.
+  /// @return The number of fibres taken.
+  [[nodiscard]] std::size_t takeOldest(std::span<Fibre> fibres);
+
+  /// Destroy all fibres in the deque. Owner thread only.
+  void clear();
+
+private:
+  /// Circular slot buffer.
+  struct Buffer
+  {
+    explicit Buffer(int64_t capacity)
+      : mask(capacity - 1)
+      , slots(std::make_unique<std::atomic<void *>[]>(static_cast<std::size_t>(capacity)))
+    {}
+
+    [[nodiscard]] int64_t capacity() const noexcept { return mask + 1; }
+    [[nodiscard]] void *get(int64_t index) const noexcept
+    {
+      return slots[index & mask].load(std::memory_order_relaxed);
+    }
+    void put(int64_t index, void *value) noexcept
+    {
+      slots[index & mask].store(value, std::memory_order_relaxed);
+    }
+
+    int64_t mask = 0;
+    std::unique_ptr<std::atomic<void *>[]> slots;
+  };
+
+  /// Grow the buffer, copying the items in [@p top, @p bottom). Owner thread only.
+  Buffer *grow(Buffer *buffer, int64_t top, int64_t bottom);
+
+  /// Steal index. Written by thieves and by the owner when taking the last item.
+  alignas(64) std::atomic<int64_t> _top{ 0 };
+  /// Owner push/pop index.
+  alignas(64) std::atomic<int64_t> _bottom{ 0 };
+  std::atomic<Buffer *> _buffer{ nullptr };
+  /// All buffers allocated, including retired buffers. Owner thread only.
+  std::vector<std::unique_ptr<Buffer>> _buffers;
+};
+}  // namespace morai
@@ -0,0 +1,72 @@
+#include <morai/Clock.hpp>
+#include <morai/Scheduler.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+namespace morai
+{
+namespace
+{
+void testTimeFunction(const Clock::TimeFunction &time_function, const double tolerance_s)
+{
+  // Must be monotonic and track steady_clock.
+  const double start_s = time_function();
+  const auto start_time = std::chrono::steady_clock::now();
+  double last_s = start_s;
+  for (int i = 0; i < 1000; ++i)
+  {
+    const double now_s = time_function();
+    EXPECT_GE(now_s, last_s);
+    last_s = now_s;
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const double elapsed_s = time_function() - start_s;
+  const double expected_s =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  EXPECT_NEAR(elapsed_s, expected_s, tolerance_s);
+}
+}  // namespace
+
+TEST(Clock, tsc)
+{
+  EXPECT_EQ(Clock::calibrateTsc(), Clock::tsc_available());
+  // Calibrated once. Later calls return immediately.
+  const auto start_time = std::chrono::steady_clock::now();
+  Clock::calibrateTsc();
+  EXPECT_LT(std::chrono::steady_clock::now() - start_time, std::chrono::milliseconds(5));
+  testTimeFunction(Clock::tsc_time_function, 2e-3);
+}
+
+TEST(Clock, coarse)
+{
+  // Resolution is the kernel tick.
+  testTimeFunction(Clock::coarse_time_function, 10e-3);
+}
+
+TEST(Clock, schedulerSleep)
+{
+  // Alternative clock sources drive scheduler sleeps.
+  for (const auto &time_function : { Clock::tsc_time_function, Clock::coarse_time_function })
+  {
+    Scheduler scheduler{ Clock{ time_function } };
+    bool done = false;
+    const auto sleeper = [](bool &done) -> Fibre {
+      co_await 0.02;
+      done = true;
+    };
+    scheduler.start(sleeper(done));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done && std::chrono::steady_clock::now() < deadline)
+    {
+      scheduler.update();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(done);
+  }
+}
+}  // namespace morai
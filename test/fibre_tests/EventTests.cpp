@@ -0,0 +1,198 @@
+#include "TestClock.hpp"
+
+#include <morai/Event.hpp>
+#include <morai/Scheduler.hpp>
+#include <morai/ThreadPool.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace morai
+{
+TEST(Event, manualReset)
+{
+  Scheduler scheduler{ test::makeClock() };
+  Event event;
+  int woken = 0;
+
+  const auto waiter = [](Event &event, int &woken) -> Fibre {
+    co_await event;
+    ++woken;
+  };
+
+  const int waiter_count = 10;
+  for (int i = 0; i < waiter_count; ++i)
+  {
+    scheduler.start(waiter(event, woken));
+  }
+
+  // Waiters park on the first update and are no longer visited.
+  scheduler.update();
+  EXPECT_EQ(event.waiterCount(), waiter_count);
+  EXPECT_EQ(scheduler.runningCount(), waiter_count);
+  for (int i = 0; i < 5; ++i)
+  {
+    scheduler.update();
+  }
+  EXPECT_EQ(woken, 0);
+
+  // Set wakes all waiters on the next update.
+  event.set();
+  EXPECT_EQ(event.waiterCount(), 0u);
+  scheduler.update();
+  EXPECT_EQ(woken, waiter_count);
+  EXPECT_TRUE(scheduler.empty());
+
+  // Remains set - no suspension.
+  EXPECT_TRUE(event.isSet());
+  scheduler.start(waiter(event, woken));
+  scheduler.update();
+  EXPECT_EQ(woken, waiter_count + 1);
+  EXPECT_EQ(event.waiterCount(), 0u);
+
+  event.reset();
+  EXPECT_FALSE(event.isSet());
+}
+
+TEST(Event, autoReset)
+{
+  Scheduler scheduler{ test::makeClock() };
+  Event event{ EventReset::Auto };
+  std::vector<int> woken;
+
+  const auto waiter = [](Event &event, std::vector<int> &woken, int id) -> Fibre {
+    co_await event;
+    woken.emplace_back(id);
+  };
+
+  const int waiter_count = 3;
+  for (int i = 0; i < waiter_count; ++i)
+  {
+    scheduler.start(waiter(event, woken, i));
+  }
+  scheduler.update();
+  EXPECT_EQ(event.waiterCount(), waiter_count);
+
+  // Each set wakes a single waiter, in FIFO order.
+  for (int i = 0; i < waiter_count; ++i)
+  {
+    event.set();
+    EXPECT_FALSE(event.isSet());
+    scheduler.update();
+    ASSERT_EQ(woken.size(), i + 1);
+    EXPECT_EQ(woken.back(), i);
+  }
+  EXPECT_TRUE(scheduler.empty());
+
+  // Set with no waiters is consumed by the next waiter.
+  event.set();
+  EXPECT_TRUE(event.isSet());
+  scheduler.start(waiter(event, woken, waiter_count));
+  scheduler.update();
+  EXPECT_EQ(woken.size(), waiter_count + 1);
+  EXPECT_FALSE(event.isSet());
+}
+
+TEST(Event, autoResetConsumesOnAwait)
+{
+  // Creating an awaitable without awaiting it does not consume an auto reset signal.
+  Scheduler scheduler{ test::makeClock() };
+  Event event{ EventReset::Auto, true };
+
+  [[maybe_unused]] const Fibre::ParkAwaitable unawaited = event.parkAwaitable();
+  EXPECT_TRUE(event.isSet());
+
+  bool woken = false;
+  scheduler.start([](Event &event, bool &woken) -> Fibre {
+    [[maybe_unused]] const Fibre::ParkAwaitable skipped = event.parkAwaitable();
+    co_await event;
+    woken = true;
+  }(event, woken));
+  scheduler.update();
+  EXPECT_TRUE(woken);
+  EXPECT_FALSE(event.isSet());
+  EXPECT_FALSE(event.parkAwaitable().await_ready());
+}
+
+TEST(Event, destroyCancels)
+{
+  Scheduler scheduler{ test::makeClock() };
+  auto event = std::make_unique<Event>();
+  bool resumed = false;
+
+  const Id waiter_id = scheduler.start([](Event &event, bool &resumed) -> Fibre {
+    co_await event;
+    resumed = true;
+  }(*event, resumed));
+
+  scheduler.update();
+  EXPECT_TRUE(waiter_id.running());
+  event.reset();
+  event = nullptr;
+
+  scheduler.update();
+  EXPECT_FALSE(waiter_id.running());
+  EXPECT_FALSE(resumed);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Event, schedulerDestroyed)
+{
+  // The waiter's scheduler is destroyed before the event is set. The waiter is destroyed on waking
+  // instead of being handed back to the dead scheduler.
+  Event event;
+  bool resumed = false;
+  Id waiter_id{};
+  {
+    Scheduler scheduler{ test::makeClock() };
+    waiter_id = scheduler.start([](Event &event, bool &resumed) -> Fibre {
+      co_await event;
+      resumed = true;
+    }(event, resumed));
+    scheduler.update();
+    EXPECT_EQ(event.waiterCount(), 1u);
+  }
+
+  EXPECT_TRUE(waiter_id.running());
+  event.set();
+  EXPECT_FALSE(waiter_id.running());
+  EXPECT_FALSE(resumed);
+  EXPECT_EQ(event.waiterCount(), 0u);
+}
+
+TEST(Event, threadPool)
+{
+  // Set the event from another thread while waiters are parked across pool workers.
+  ThreadPool pool{ test::makeClock(), { .worker_count = 4 } };
+  Event event;
+  std::atomic_int woken = 0;
+
+  const auto waiter = [](Event &event, std::atomic_int &woken) -> Fibre {
+    co_await event;
+    ++woken;
+  };
+
+  const int waiter_count = 100;
+  for (int i = 0; i < waiter_count; ++i)
+  {
+    pool.start(waiter(event, woken));
+  }
+
+  while (event.waiterCount() < waiter_count)
+  {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(pool.runningCount(), waiter_count);
+  EXPECT_EQ(woken, 0);
+
+  std::thread setter([&event]() { event.set(); });
+  setter.join();
+
+  EXPECT_TRUE(pool.wait(std::chrono::seconds(10)));
+  EXPECT_EQ(woken, waiter_count);
+}
+}  // namespace morai
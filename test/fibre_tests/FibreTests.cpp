@@ -1,5 +1,6 @@
 #include "TestClock.hpp"
 
+#include <morai/FibreQueue.hpp>
 #include <morai/Finally.hpp>
 #include <morai/Log.hpp>
 #include <morai/Scheduler.hpp>
@@ -10,6 +11,8 @@
 #include <array>
 #include <ranges>
 #include <random>
+#include <type_traits>
+#include <vector>
 #include "morai/Common.hpp"
 
 namespace morai
@@ -178,6 +181,117 @@ TEST(Fibre, spawn)
 }
 
 
+TEST(Fibre, joinAcrossSchedulers)
+{
+  // Join a fibre running in another scheduler. The joiner is parked until the target completes.
+  Scheduler joiner_scheduler{ test::makeClock() };
+  Scheduler target_scheduler{ test::makeClock() };
+  int joiner_resumes = 0;
+
+  const Id target_id = target_scheduler.start([]() -> Fibre {
+    for (int i = 0; i < 10; ++i)
+    {
+      co_yield {};
+    }
+  }());
+
+  const Id joiner_id = joiner_scheduler.start([](Id target_id, int &resumes) -> Fibre {
+    ++resumes;
+    co_await target_id;
+    ++resumes;
+    EXPECT_FALSE(target_id.running());
+  }(target_id, joiner_resumes));
+
+  joiner_scheduler.update();
+  EXPECT_EQ(joiner_resumes, 1);
+  EXPECT_EQ(joiner_scheduler.runningCount(), 1u);
+
+  while (target_id.running())
+  {
+    joiner_scheduler.update();
+    EXPECT_TRUE(joiner_id.running());
+    EXPECT_EQ(joiner_resumes, 1);
+    target_scheduler.update();
+  }
+
+  // Woken into the joiner scheduler. Resumes on its next update.
+  joiner_scheduler.update();
+  EXPECT_EQ(joiner_resumes, 2);
+  EXPECT_FALSE(joiner_id.running());
+  EXPECT_TRUE(joiner_scheduler.empty());
+}
+
+TEST(Fibre, joinerSchedulerDestroyed)
+{
+  // The joiner's scheduler is destroyed before the target completes. The joiner is destroyed when
+  // the target completes rather than being handed back to the dead scheduler.
+  Scheduler target_scheduler{ test::makeClock() };
+  const Id target_id = target_scheduler.start([]() -> Fibre {
+    for (int i = 0; i < 3; ++i)
+    {
+      co_yield {};
+    }
+  }());
+
+  bool joined = false;
+  bool destroyed = false;
+  Id joiner_id{};
+  {
+    Scheduler joiner_scheduler{ test::makeClock() };
+    joiner_id = joiner_scheduler.start([](Id target_id, bool &joined, bool &destroyed) -> Fibre {
+      [[maybe_unused]] const auto at_exit = morai::finally([&destroyed]() { destroyed = true; });
+      co_await target_id;
+      joined = true;
+    }(target_id, joined, destroyed));
+    joiner_scheduler.update();
+  }
+
+  EXPECT_TRUE(joiner_id.running());
+  EXPECT_FALSE(destroyed);
+  while (target_id.running())
+  {
+    target_scheduler.update();
+  }
+  EXPECT_FALSE(joiner_id.running());
+  EXPECT_TRUE(destroyed);
+  EXPECT_FALSE(joined);
+}
+
+TEST(Fibre, joinCancelled)
+{
+  // Cancelling the target wakes joiners, including multiple joiners of the same target.
+  Scheduler scheduler{ test::makeClock() };
+  const Id target_id = scheduler.start([]() -> Fibre {
+    for (;;)
+    {
+      co_yield {};
+    }
+  }());
+
+  int joined = 0;
+  const auto joiner = [](Id target_id, int &joined) -> Fibre {
+    co_await target_id;
+    ++joined;
+  };
+  for (int i = 0; i < 3; ++i)
+  {
+    scheduler.start(joiner(target_id, joined));
+  }
+
+  for (int i = 0; i < 3; ++i)
+  {
+    scheduler.update();
+  }
+  EXPECT_EQ(joined, 0);
+  EXPECT_EQ(scheduler.runningCount(), 4u);
+
+  EXPECT_TRUE(scheduler.cancel(target_id));
+  scheduler.update();
+  EXPECT_EQ(joined, 3);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+
 TEST(Fibre, spawnAndCancel)
 {
   Scheduler scheduler{ test::makeClock() };
@@ -226,6 +340,76 @@ TEST(Fibre, spawnAndCancel)
   EXPECT_TRUE(scheduler.empty());
 }
 
+TEST(Fibre, coldFrame)
+{
+  // Rarely used fibre data is only allocated on demand.
+  const auto fibre_func = []() -> Fibre {
+    co_yield {};
+    co_await reschedule(1);
+    throw std::runtime_error("cold");
+  };
+
+  Fibre fibre = fibre_func();
+  const auto &frame = fibre.__handle().promise().frame;
+  fibre.setName({});
+  EXPECT_EQ(frame.cold_state, nullptr);
+  EXPECT_TRUE(fibre.name().empty());
+  EXPECT_EQ(fibre.exception(), nullptr);
+
+  Resume resume = fibre.resume(0, Clock::DefaultQuantisation);
+  EXPECT_EQ(resume.mode, ResumeMode::Continue);
+  EXPECT_FALSE(resume.reschedule.has_value());
+  EXPECT_EQ(frame.cold_state, nullptr);
+
+  resume = fibre.resume(0, Clock::DefaultQuantisation);
+  EXPECT_EQ(resume.mode, ResumeMode::Continue);
+  ASSERT_TRUE(resume.reschedule.has_value());
+  EXPECT_EQ(resume.reschedule->priority, 1);
+  EXPECT_NE(frame.cold_state, nullptr);
+
+  resume = fibre.resume(0, Clock::DefaultQuantisation);
+  EXPECT_EQ(resume.mode, ResumeMode::Exception);
+  EXPECT_NE(fibre.exception(), nullptr);
+
+  fibre.setName("cold");
+  EXPECT_EQ(fibre.name(), "cold");
+}
+
+TEST(Fibre, deadlineTicks)
+{
+  // Deadlines are absolute integer ticks, so a short sleep remains exact after a long uptime where
+  // double precision seconds would lose resolution.
+  const auto fibre_func = [](const bool *ready) -> Fibre {
+    co_await sleep(std::chrono::microseconds(3));
+    co_await wait([ready]() { return *ready; }, 2e-6);
+    co_await wait([ready]() { return *ready; });
+  };
+
+  const double tick_period_s = Clock::DefaultQuantisation;
+  const uint64_t start_tick = (uint64_t{ 1 } << 60) + 1;  // Over 36,000 years at 1us per tick.
+  bool ready = false;
+  Fibre fibre = fibre_func(&ready);
+  const auto &frame = fibre.__handle().promise().frame;
+
+  // First resume runs to the sleep.
+  ASSERT_EQ(fibre.resume(start_tick, tick_period_s).mode, ResumeMode::Continue);
+  EXPECT_EQ(frame.deadline, start_tick + 3);
+  EXPECT_EQ(fibre.resume(start_tick + 2, tick_period_s).mode, ResumeMode::Sleep);
+
+  // Sleep expires. Wait with a timeout.
+  ASSERT_EQ(fibre.resume(start_tick + 3, tick_period_s).mode, ResumeMode::Continue);
+  EXPECT_EQ(frame.deadline, start_tick + 5);
+  EXPECT_EQ(fibre.resume(start_tick + 4, tick_period_s).mode, ResumeMode::Sleep);
+
+  // Timeout expires. Wait without a timeout.
+  ASSERT_EQ(fibre.resume(start_tick + 5, tick_period_s).mode, ResumeMode::Continue);
+  EXPECT_EQ(frame.deadline, 0u);
+  EXPECT_EQ(fibre.resume(~uint64_t{ 0 }, tick_period_s).mode, ResumeMode::Sleep);
+
+  ready = true;
+  EXPECT_EQ(fibre.resume(start_tick + 6, tick_period_s).mode, ResumeMode::Expire);
+}
+
 TEST(Fibre, exceptionPropagation)
 {
   Scheduler scheduler{ test::makeClock(), ExceptionHandling::Rethrow };
@@ -408,6 +592,41 @@ TEST(Fibre, queueResize)
   EXPECT_EQ(state.completed, fibre_count);
 }
 
+TEST(Fibre, queueTracking)
+{
+  // FibreQueue locates fibres via Ids tracked alongside the handles, including across growth.
+  const auto fibre_entry = []() -> Fibre {
+    for (;;)
+    {
+      co_yield {};
+    }
+  };
+
+  FibreQueue queue{ 0, 4u };
+  std::vector<Id> ids;
+  for (int i = 0; i < 40; ++i)
+  {
+    Fibre fibre = fibre_entry();
+    ids.emplace_back(fibre.id());
+    queue.push(std::move(fibre), (i % 2) ? PriorityPosition::Front : PriorityPosition::Back);
+  }
+
+  for (const Id &id : ids)
+  {
+    EXPECT_TRUE(queue.contains(id));
+  }
+
+  // Popped fibres are no longer located, even though their slots still reference the queue.
+  Fibre popped = queue.pop();
+  EXPECT_FALSE(queue.contains(popped.id()));
+  EXPECT_FALSE(queue.cancel(popped.id()));
+
+  EXPECT_TRUE(queue.cancel(ids[10]));
+  EXPECT_FALSE(queue.contains(ids[10]));
+  EXPECT_FALSE(ids[10].running());
+  EXPECT_EQ(queue.size(), ids.size() - 1);
+}
+
 TEST(Fibre, incorrectPriority)
 {
   // Track log errors to look for priority mismatches.
@@ -515,4 +734,238 @@ TEST(Fibre, conditionReady)
   EXPECT_FALSE(id_yield.running());
   EXPECT_TRUE(scheduler.empty());
 }
+
+TEST(Fibre, conditionOwnership)
+{
+  // Wait conditions are moved through the suspension path, never copied. Captured state must be
+  // released once the wait completes.
+  Scheduler scheduler{ test::makeClock() };
+  auto state = std::make_shared<int>(0);
+
+  // Note: the condition is named rather than a temporary in the co_await expression. GCC 12 double
+  // destroys non-trivial temporaries in a co_await operand when the frame is later destroyed.
+  const auto waiter = [](std::shared_ptr<int> state) -> Fibre {
+    const auto ready = [state]() { return *state > 2; };
+    co_await ready;
+    co_yield {};
+  };
+
+  scheduler.start(waiter(state), "waiter");
+  // Frame argument, the named condition and the copy held by the pending wait condition.
+  scheduler.update();
+  EXPECT_EQ(state.use_count(), 4);
+
+  for (int i = 0; i < 3; ++i)
+  {
+    ++*state;
+    scheduler.update();
+  }
+
+  // Condition met and the wait condition copy released.
+  EXPECT_EQ(state.use_count(), 3);
+  scheduler.update();
+  EXPECT_TRUE(scheduler.empty());
+  EXPECT_EQ(state.use_count(), 1);
+
+  // Wait conditions are inline, move only callables.
+  WaitCondition condition = [state]() { return *state > 0; };
+  WaitCondition moved = std::move(condition);
+  EXPECT_FALSE(condition);
+  EXPECT_TRUE(moved());
+  EXPECT_EQ(state.use_count(), 2);
+  moved = nullptr;
+  EXPECT_EQ(state.use_count(), 1);
+}
+
+TEST(Fibre, idReuse)
+{
+  static_assert(std::is_trivially_copyable_v<Id>);
+  static_assert(sizeof(Id) == sizeof(IdValueType));
+
+  Scheduler scheduler{ test::makeClock() };
+  const auto short_fibre = []() -> Fibre { co_yield {}; };
+
+  const Id first_id = scheduler.start(short_fibre(), "first");
+  EXPECT_TRUE(first_id.running());
+  while (!scheduler.empty())
+  {
+    scheduler.update();
+  }
+  EXPECT_FALSE(first_id.running());
+
+  // The slot is recycled with a new generation. The stale Id must not alias the new fibre.
+  const Id second_id = scheduler.start(short_fibre(), "second");
+  EXPECT_EQ(second_id.index(), first_id.index());
+  EXPECT_NE(second_id, first_id);
+  EXPECT_TRUE(second_id.running());
+  EXPECT_FALSE(first_id.running());
+
+  first_id.markForCancellation();
+  EXPECT_FALSE(second_id.cancelled());
+  EXPECT_FALSE(scheduler.cancel(first_id));
+  EXPECT_TRUE(second_id.running());
+
+  EXPECT_TRUE(scheduler.cancel(second_id));
+  EXPECT_FALSE(second_id.running());
+  // Cancelled entries are cleared on the next update.
+  scheduler.update();
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Fibre, cancelAfterGrowth)
+{
+  // Cancel by Id must find fibres after queue growth and front insertion reposition them.
+  SchedulerParams params;
+  params.initial_queue_size = 16;
+  Scheduler scheduler{ test::makeClock(), params };
+  const auto forever = []() -> Fibre {
+    for (;;)
+    {
+      co_yield {};
+    }
+  };
+
+  std::vector<Id> ids;
+  for (int i = 0; i < 100; ++i)
+  {
+    ids.emplace_back(scheduler.start(forever()));
+  }
+  scheduler.update();
+
+  for (std::size_t i = 0; i < ids.size(); i += 2)
+  {
+    EXPECT_TRUE(scheduler.cancel(ids[i]));
+    EXPECT_FALSE(ids[i].running());
+    EXPECT_FALSE(scheduler.cancel(ids[i]));
+  }
+
+  EXPECT_EQ(scheduler.cancel(ids), ids.size() / 2);
+  for (const Id &id : ids)
+  {
+    EXPECT_FALSE(id.running());
+  }
+}
+
+TEST(Fibre, cancelOwner)
+{
+  // Cancel by Id dispatches on the container holding the fibre: any priority queue or the timing
+  // wheel of this scheduler, but never another scheduler's containers.
+  SchedulerParams params;
+  params.priority_levels = { 0, 1, 2 };
+  Scheduler scheduler{ test::makeClock(), params };
+  Scheduler other{ test::makeClock(), params };
+  const auto forever = []() -> Fibre {
+    for (;;)
+    {
+      co_yield {};
+    }
+  };
+  const auto sleeper = []() -> Fibre { co_await 3600.0; };
+
+  const Id low = scheduler.start(forever(), 2);
+  const Id high = scheduler.start(forever(), 0);
+  const Id sleeping = scheduler.start(sleeper(), 1);
+  const Id elsewhere = other.start(forever(), 1);
+  const Id other_sleeping = other.start(sleeper(), 1);
+  scheduler.update();
+  other.update();
+
+  EXPECT_FALSE(scheduler.cancel(elsewhere));
+  EXPECT_FALSE(scheduler.cancel(other_sleeping));
+  EXPECT_TRUE(elsewhere.running());
+  EXPECT_TRUE(other_sleeping.running());
+
+  EXPECT_TRUE(scheduler.cancel(low));
+  EXPECT_TRUE(scheduler.cancel(sleeping));
+  EXPECT_TRUE(scheduler.cancel(high));
+  EXPECT_FALSE(low.running());
+  EXPECT_FALSE(sleeping.running());
+  EXPECT_FALSE(high.running());
+  scheduler.update();
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Fibre, updateBudget)
+{
+  // Limited updates continue each queue's round where the last update stopped, always serving the
+  // higher priority queue first.
+  Scheduler scheduler{ test::makeClock(), { .priority_levels = { 0, 1 } } };
+  std::vector<int> order;
+  const auto forever = [](std::vector<int> &order, const int id) -> Fibre {
+    for (;;)
+    {
+      order.emplace_back(id);
+      co_yield {};
+    }
+  };
+
+  // High priority fibres are 0-3, low priority fibres 10-13.
+  for (int i = 0; i < 4; ++i)
+  {
+    scheduler.start(forever(order, i), 0);
+    scheduler.start(forever(order, 10 + i), 1);
+  }
+
+  const auto expect_update = [&order](const UpdateResult &result, const std::vector<int> &expected,
+                                      const std::size_t deferred) {
+    EXPECT_EQ(order, expected);
+    EXPECT_EQ(result.resumed, expected.size());
+    EXPECT_EQ(result.deferred, deferred);
+    order.clear();
+  };
+
+  expect_update(scheduler.update(6), { 0, 1, 2, 3, 10, 11 }, 2);
+  expect_update(scheduler.update(6), { 0, 1, 2, 3, 12, 13 }, 0);
+  expect_update(scheduler.update(3), { 0, 1, 2 }, 5);
+  expect_update(scheduler.update(0), {}, 5);
+  expect_update(scheduler.update(), { 3, 10, 11, 12, 13 }, 0);
+
+  // Fibres started during a round wait for the next round.
+  scheduler.update(1);
+  order.clear();
+  scheduler.start(forever(order, 4), 0);
+  expect_update(scheduler.update(4), { 1, 2, 3, 10 }, 3);
+  expect_update(scheduler.update(), { 0, 4, 1, 2, 3, 11, 12, 13 }, 0);
+
+  scheduler.cancelAll();
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Fibre, updateTimeLimit)
+{
+  // Each fibre advances the clock one second. Time limited updates resume at least one fibre.
+  double now_s = 0;
+  Scheduler scheduler{ Clock{ [&now_s]() { return now_s; } } };
+  const auto busy = [](double &now_s) -> Fibre {
+    for (;;)
+    {
+      now_s += 1.0;
+      co_yield {};
+    }
+  };
+
+  for (int i = 0; i < 5; ++i)
+  {
+    scheduler.start(busy(now_s));
+  }
+
+  UpdateResult result = scheduler.update(std::chrono::milliseconds(2500));
+  EXPECT_EQ(result.resumed, 3u);
+  EXPECT_EQ(result.deferred, 2u);
+
+  result = scheduler.update(std::chrono::seconds(0));
+  EXPECT_EQ(result.resumed, 1u);
+  EXPECT_EQ(result.deferred, 1u);
+
+  // Complete the round, then a new round within the limits.
+  const UpdateBudget budget{ .max_resumes = 4, .time_limit_s = 10.0 };
+  result = scheduler.update(budget);
+  EXPECT_EQ(result.resumed, 1u);
+  EXPECT_EQ(result.deferred, 0u);
+  result = scheduler.update(budget);
+  EXPECT_EQ(result.resumed, 4u);
+  EXPECT_EQ(result.deferred, 1u);
+
+  scheduler.cancelAll();
+}
 }  // namespace morai
@@ -0,0 +1,157 @@
+#include "TestClock.hpp"
+
+#include <morai/Finally.hpp>
+#include <morai/FrameAllocator.hpp>
+#include <morai/Scheduler.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace morai
+{
+TEST(FrameAllocator, reuse)
+{
+  // Released frames are reused by the next allocation of the same size class.
+  void *first = FrameAllocator::allocate(200);
+  ASSERT_NE(first, nullptr);
+  std::memset(first, 0xcd, 200);
+  FrameAllocator::deallocate(first);
+  void *second = FrameAllocator::allocate(190);
+  EXPECT_EQ(first, second);
+  FrameAllocator::deallocate(second);
+
+  // Large frames bypass the pools.
+  void *large = FrameAllocator::allocate(FrameAllocator::MaxPooledSize + 1);
+  ASSERT_NE(large, nullptr);
+  std::memset(large, 0xcd, FrameAllocator::MaxPooledSize + 1);
+  FrameAllocator::deallocate(large);
+}
+
+TEST(FrameAllocator, alignment)
+{
+  std::vector<void *> frames;
+  for (std::size_t size = 1; size < FrameAllocator::MaxPooledSize; size += 37)
+  {
+    void *frame = FrameAllocator::allocate(size);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(frame) % alignof(std::max_align_t), 0u);
+    frames.emplace_back(frame);
+  }
+
+  for (void *frame : frames)
+  {
+    FrameAllocator::deallocate(frame);
+  }
+}
+
+TEST(FrameAllocator, crossThreadRelease)
+{
+  // Allocate on one thread, release on another, then ensure the allocating thread reclaims the
+  // frames.
+  const std::size_t frame_size = 300;
+  const std::size_t frame_count = 1000;
+  std::vector<void *> frames;
+  for (std::size_t i = 0; i < frame_count; ++i)
+  {
+    frames.emplace_back(FrameAllocator::allocate(frame_size));
+  }
+
+  std::thread releaser([&frames]() {
+    for (void *frame : frames)
+    {
+      FrameAllocator::deallocate(frame);
+    }
+  });
+  releaser.join();
+
+  // All frames should now be reclaimed without carving new blocks.
+  const auto reserved_before = FrameAllocator::sizeClassStats();
+  std::vector<void *> reused;
+  for (std::size_t i = 0; i < frame_count; ++i)
+  {
+    reused.emplace_back(FrameAllocator::allocate(frame_size));
+  }
+  const auto reserved_after = FrameAllocator::sizeClassStats();
+
+  std::ranges::sort(frames);
+  std::ranges::sort(reused);
+  EXPECT_EQ(frames, reused);
+  for (std::size_t i = 0; i < reserved_before.size(); ++i)
+  {
+    EXPECT_EQ(reserved_before[i].reserved, reserved_after[i].reserved);
+  }
+
+  for (void *frame : reused)
+  {
+    FrameAllocator::deallocate(frame);
+  }
+}
+
+TEST(FrameAllocator, reserve)
+{
+  const std::size_t frame_size = 1000;
+  const std::size_t frame_count = 500;
+  FrameAllocator::reserve(frame_size, frame_count);
+
+  const auto reserved = FrameAllocator::sizeClassStats();
+  std::vector<void *> frames;
+  for (std::size_t i = 0; i < frame_count; ++i)
+  {
+    frames.emplace_back(FrameAllocator::allocate(frame_size));
+  }
+  const auto allocated = FrameAllocator::sizeClassStats();
+
+  for (std::size_t i = 0; i < reserved.size(); ++i)
+  {
+    EXPECT_EQ(reserved[i].reserved, allocated[i].reserved);
+  }
+
+  for (void *frame : frames)
+  {
+    FrameAllocator::deallocate(frame);
+  }
+}
+
+TEST(FrameAllocator, fibreStats)
+{
+  FrameAllocator::setStatsEnabled(true);
+  const auto disable_stats = finally([]() { FrameAllocator::setStatsEnabled(false); });
+
+  Scheduler scheduler{ test::makeClock() };
+  const auto fibre_entry = [](int iterations) -> Fibre {
+    for (int i = 0; i < iterations; ++i)
+    {
+      co_yield {};
+    }
+  };
+
+  const uint32_t fibre_count = 100;
+  for (uint32_t i = 0; i < fibre_count; ++i)
+  {
+    scheduler.start(fibre_entry(2));
+  }
+
+  const auto running_stats = FrameAllocator::frameSizeStats();
+  const auto frame_stats = std::ranges::find_if(
+    running_stats, [](const FrameSizeStats &stats) { return stats.live >= fibre_count; });
+  ASSERT_NE(frame_stats, running_stats.end());
+  const std::size_t frame_size = frame_stats->frame_size;
+
+  while (!scheduler.empty())
+  {
+    scheduler.update();
+  }
+
+  const auto done_stats = FrameAllocator::frameSizeStats();
+  const auto done_frame_stats =
+    std::ranges::find_if(done_stats, [frame_size](const FrameSizeStats &stats) {
+      return stats.frame_size == frame_size;
+    });
+  ASSERT_NE(done_frame_stats, done_stats.end());
+  EXPECT_GE(done_frame_stats->allocations, fibre_count);
+  EXPECT_EQ(done_frame_stats->live + fibre_count, frame_stats->live);
+}
+}  // namespace morai
@@ -3,10 +3,16 @@
 #include <morai/Finally.hpp>
 #include <morai/Move.hpp>
 #include <morai/Scheduler.hpp>
+#include <morai/ThreadPool.hpp>
 
 #include <gtest/gtest.h>
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <vector>
 
 namespace morai
 {
@@ -55,4 +61,124 @@ TEST(Move, scheduler)
     state.schedulers[1 - initially_on].update();
   }
 }
+
+TEST(Move, fromThreads)
+{
+  // Test moving many fibres into a scheduler from worker threads. Moves never fail, so all fibres
+  // must arrive regardless of how many are moved between updates.
+  constexpr int FibreCount = 4096;
+  Scheduler scheduler{ test::makeClock() };
+  std::atomic_int moved{ 0 };
+  int arrived = 0;
+
+  const auto mover = [](Scheduler &scheduler, std::atomic_int &moved, int &arrived) -> Fibre {
+    moved.fetch_add(1);
+    co_await moveTo(scheduler);
+    // Only the scheduler thread runs the fibre from here.
+    ++arrived;
+  };
+
+  ThreadPool pool{ ThreadPoolParams{ .worker_count = 4 } };
+  for (int i = 0; i < FibreCount; ++i)
+  {
+    pool.start(mover(scheduler, moved, arrived));
+  }
+
+  // Let the moves pile up before the first update.
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (moved.load() < FibreCount && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::yield();
+  }
+
+  while (arrived < FibreCount && std::chrono::steady_clock::now() < deadline)
+  {
+    scheduler.update();
+  }
+
+  EXPECT_EQ(arrived, FibreCount);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Move, batch)
+{
+  // Fibres moving to the same scheduler during one update are handed over together, in order and
+  // at the requested priority.
+  Scheduler source{ test::makeClock() };
+  Scheduler target{ test::makeClock(), SchedulerParams{ .priority_levels = { 0, 5 } } };
+  std::vector<int> order;
+
+  const auto mover = [](Scheduler &target, std::vector<int> &order, int index) -> Fibre {
+    co_await moveTo(target, 5);
+    order.emplace_back(index);
+  };
+
+  constexpr int FibreCount = 100;
+  for (int i = 0; i < FibreCount; ++i)
+  {
+    source.start(mover(target, order, i));
+  }
+
+  source.update();
+  EXPECT_TRUE(source.empty());
+  EXPECT_FALSE(target.empty());
+  EXPECT_TRUE(order.empty());
+
+  target.update();
+  ASSERT_EQ(order.size(), static_cast<std::size_t>(FibreCount));
+  for (int i = 0; i < FibreCount; ++i)
+  {
+    EXPECT_EQ(order[i], i);
+  }
+  EXPECT_TRUE(target.empty());
+}
+
+TEST(Move, declined)
+{
+  // A scheduler may decline a move. The fibre stays with its current scheduler without resuming
+  // and the move is retried on the next update.
+  struct Gate
+  {
+    Scheduler *scheduler = nullptr;
+    bool open = false;
+    int declined = 0;
+
+    bool move(Fibre &fibre, std::optional<int32_t> priority)
+    {
+      if (!open)
+      {
+        ++declined;
+        return false;
+      }
+      return scheduler->move(fibre, priority);
+    }
+  };
+
+  Scheduler source{ test::makeClock() };
+  Scheduler target{ test::makeClock() };
+  Gate gate{ .scheduler = &target };
+  int resumes = 0;
+
+  const auto mover = [](Gate &gate, int &resumes) -> Fibre {
+    ++resumes;
+    co_await moveTo(gate);
+    ++resumes;
+  };
+
+  source.start(mover(gate, resumes));
+  for (int i = 0; i < 3; ++i)
+  {
+    source.update();
+    EXPECT_EQ(source.runningCount(), 1u);
+    EXPECT_EQ(resumes, 1);
+  }
+  EXPECT_EQ(gate.declined, 3);
+
+  gate.open = true;
+  source.update();
+  EXPECT_TRUE(source.empty());
+  target.update();
+  EXPECT_EQ(resumes, 2);
+  EXPECT_TRUE(target.empty());
+}
 }  // namespace morai
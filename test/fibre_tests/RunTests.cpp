@@ -0,0 +1,222 @@
+#include "TestClock.hpp"
+
+#include <morai/Event.hpp>
+#include <morai/Move.hpp>
+#include <morai/Scheduler.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <thread>
+
+namespace morai
+{
+namespace
+{
+/// Wait up to a few seconds for @p flag to be set.
+bool waitFor(const std::atomic_bool &flag)
+{
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!flag.load() && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return flag.load();
+}
+}  // namespace
+
+TEST(Run, nextDeadline)
+{
+  Scheduler scheduler{ test::makeClock() };
+  EXPECT_FALSE(scheduler.nextDeadline());
+
+  const auto sleeper = []() -> Fibre { co_await 1.0; };
+  const auto yielder = []() -> Fibre { co_yield {}; };
+
+  // Ready fibres are due immediately.
+  scheduler.start(yielder());
+  scheduler.start(sleeper());
+  EXPECT_EQ(scheduler.nextDeadline(), scheduler.time().epoch_time_s);
+
+  // The yielding fibre is due next update.
+  scheduler.update();
+  EXPECT_EQ(scheduler.nextDeadline(), scheduler.time().epoch_time_s);
+
+  // Only the sleeper remains, parked in the timing wheel.
+  scheduler.update();
+  const std::optional<double> deadline = scheduler.nextDeadline();
+  ASSERT_TRUE(deadline);
+  EXPECT_GT(*deadline, scheduler.time().epoch_time_s);
+  EXPECT_LE(*deadline, scheduler.time().epoch_time_s + 1.0);
+
+  // Parked on an event - nothing due.
+  scheduler.cancelAll();
+  Event event;
+  scheduler.start([](Event &event) -> Fibre { co_await event; }(event));
+  scheduler.update();
+  EXPECT_FALSE(scheduler.nextDeadline());
+  event.set();
+  EXPECT_EQ(scheduler.nextDeadline(), scheduler.time().epoch_time_s);
+}
+
+TEST(Run, untilTime)
+{
+  // Count clock samples. A busy loop would sample the clock continuously.
+  uint32_t samples = 0;
+  Scheduler scheduler{ Clock{ [&samples]() {
+    ++samples;
+    return Clock::steady_clock_time_function();
+  } } };
+
+  int wakes = 0;
+  const auto sleeper = [](int &wakes) -> Fibre {
+    for (int i = 0; i < 3; ++i)
+    {
+      co_await std::chrono::milliseconds(20);
+      ++wakes;
+    }
+  };
+  scheduler.start(sleeper(wakes));
+
+  const double until_s = scheduler.clock().now() + 0.1;
+  EXPECT_TRUE(scheduler.runUntil(until_s));
+  EXPECT_GE(scheduler.clock().now(), until_s);
+  EXPECT_EQ(wakes, 3);
+  EXPECT_TRUE(scheduler.empty());
+  EXPECT_LT(samples, 100u);
+}
+
+TEST(Run, pollInterval)
+{
+  // A runner with only a fibre polling a wait condition blocks between polls rather than spinning.
+  Scheduler scheduler{ SchedulerParams{ .poll_interval_s = 0.01 } };
+  int polls = 0;
+  bool ready = false;
+  scheduler.start([](int &polls, const bool &ready) -> Fibre {
+    co_await [&polls, &ready]() {
+      ++polls;
+      return ready;
+    };
+  }(polls, ready));
+
+  const double until_s = scheduler.clock().now() + 0.1;
+  EXPECT_TRUE(scheduler.runUntil(until_s));
+  // Polled about once per interval. A spinning runner polls many thousands of times.
+  EXPECT_GE(polls, 2);
+  EXPECT_LE(polls, 20);
+  EXPECT_EQ(scheduler.nextDeadline(), scheduler.time().epoch_time_s + 0.01);
+
+  ready = true;
+  EXPECT_TRUE(scheduler.runUntil(scheduler.clock().now() + 0.05));
+  EXPECT_TRUE(scheduler.empty());
+
+  // A wait timeout sooner than the poll interval sets the deadline.
+  scheduler.start([]() -> Fibre { co_await wait([]() { return false; }, 0.002); }());
+  scheduler.update();
+  scheduler.update();
+  const std::optional<double> deadline = scheduler.nextDeadline();
+  ASSERT_TRUE(deadline);
+  EXPECT_LE(*deadline, scheduler.time().epoch_time_s + 0.003);
+}
+
+TEST(Run, stop)
+{
+  // A stop before running is consumed by the next run.
+  Scheduler scheduler{ test::makeClock() };
+  scheduler.stop();
+  scheduler.run();
+  scheduler.stop();
+  EXPECT_FALSE(scheduler.runUntil(std::numeric_limits<double>::infinity()));
+
+  // Stop from a fibre.
+  int updates = 0;
+  scheduler.start([](Scheduler &scheduler, int &updates) -> Fibre {
+    for (; updates < 3; ++updates)
+    {
+      co_yield {};
+    }
+    scheduler.stop();
+  }(scheduler, updates));
+  scheduler.run();
+  EXPECT_EQ(updates, 3);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Run, wakeOnMove)
+{
+  // An idle runner blocks indefinitely until a fibre moves in.
+  Scheduler target;
+  std::atomic_bool arrived = false;
+  std::jthread runner{ [&target]() { target.run(); } };
+
+  Scheduler source{ test::makeClock() };
+  source.start([](Scheduler &target, std::atomic_bool &arrived) -> Fibre {
+    co_await moveTo(target);
+    arrived = true;
+    target.stop();
+  }(target, arrived));
+  // Give the runner time to block.
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  source.update();
+
+  EXPECT_TRUE(waitFor(arrived));
+  if (!arrived)
+  {
+    target.stop();
+  }
+  runner.join();
+  EXPECT_TRUE(target.empty());
+}
+
+TEST(Run, wakeOnEvent)
+{
+  // A fibre parked on an event is the only fibre. Setting the event from another thread wakes the
+  // runner.
+  Scheduler scheduler;
+  Event event;
+  std::atomic_bool woken = false;
+  scheduler.start([](Scheduler &scheduler, Event &event, std::atomic_bool &woken) -> Fibre {
+    co_await event;
+    woken = true;
+    scheduler.stop();
+  }(scheduler, event, woken));
+  std::jthread runner{ [&scheduler]() { scheduler.run(); } };
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(woken);
+  event.set();
+
+  EXPECT_TRUE(waitFor(woken));
+  if (!woken)
+  {
+    scheduler.stop();
+  }
+  runner.join();
+}
+
+TEST(Run, wakeOnCancel)
+{
+  // The only fibre is in a long sleep. Marking it for cancellation from another thread wakes the
+  // runner, which cancels it.
+  Scheduler scheduler;
+  const Id sleeper_id = scheduler.start([]() -> Fibre { co_await 3600.0; }());
+  std::jthread runner{ [&scheduler]() { scheduler.run(); } };
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_TRUE(sleeper_id.running());
+  sleeper_id.markForCancellation();
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (sleeper_id.running() && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_FALSE(sleeper_id.running());
+  scheduler.stop();
+  runner.join();
+  EXPECT_TRUE(scheduler.empty());
+}
+}  // namespace morai
@@ -0,0 +1,258 @@
+#include "TestClock.hpp"
+
+#include <morai/Event.hpp>
+#include <morai/Scheduler.hpp>
+#include <morai/Scope.hpp>
+#include <morai/ThreadPool.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace morai
+{
+namespace
+{
+Fibre countdown(int steps, int &completed)
+{
+  for (int i = 0; i < steps; ++i)
+  {
+    co_yield {};
+  }
+  ++completed;
+}
+}  // namespace
+
+TEST(Scope, whenAll)
+{
+  Scheduler scheduler{ test::makeClock() };
+  int completed = 0;
+  bool joined = false;
+
+  const auto parent = [](Scheduler &scheduler, int &completed, bool &joined) -> Fibre {
+    Scope scope{ scheduler };
+    for (int i = 1; i <= 5; ++i)
+    {
+      scope.start(countdown(i * 2, completed));
+    }
+    EXPECT_EQ(scope.runningCount(), 5u);
+    co_await scope.whenAll();
+    EXPECT_TRUE(scope.empty());
+    EXPECT_EQ(completed, 5);
+    joined = true;
+
+    // No children - does not suspend.
+    co_await scope.whenAll();
+  };
+
+  scheduler.start(parent(scheduler, completed, joined));
+  while (!joined)
+  {
+    ASSERT_FALSE(scheduler.empty());
+    scheduler.update();
+  }
+  EXPECT_EQ(completed, 5);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Scope, whenAny)
+{
+  Scheduler scheduler{ test::makeClock() };
+  int completed = 0;
+  std::vector<int> observed;
+
+  const auto parent = [](Scheduler &scheduler, int &completed,
+                         std::vector<int> &observed) -> Fibre {
+    Scope scope{ scheduler };
+    // Two children complete on the same update. Each completion is consumed once.
+    scope.start(countdown(2, completed));
+    scope.start(countdown(2, completed));
+    scope.start(countdown(6, completed));
+    for (int i = 0; i < 3; ++i)
+    {
+      co_await scope.whenAny();
+      observed.emplace_back(completed);
+    }
+    EXPECT_TRUE(scope.empty());
+  };
+
+  scheduler.start(parent(scheduler, completed, observed));
+  while (!scheduler.empty())
+  {
+    scheduler.update();
+  }
+  EXPECT_EQ(observed, (std::vector<int>{ 2, 2, 3 }));
+}
+
+TEST(Scope, whenAnyConsumesOnAwait)
+{
+  // Creating a whenAny() awaitable without awaiting it does not consume a completion.
+  Scheduler scheduler{ test::makeClock() };
+  int completed = 0;
+  Scope scope{ scheduler };
+  scope.start(countdown(0, completed));
+  scope.start(countdown(100, completed));
+  scheduler.update();
+  EXPECT_EQ(completed, 1);
+
+  [[maybe_unused]] const Fibre::ParkAwaitable unawaited = scope.whenAny();
+  EXPECT_TRUE(scope.whenAny().await_ready());
+  EXPECT_FALSE(scope.whenAny().await_ready());
+}
+
+TEST(Scope, cancelOnExit)
+{
+  // Leaving the scope cancels remaining children.
+  Scheduler scheduler{ test::makeClock() };
+  auto token = std::make_shared<int>(0);
+
+  const auto child = [](std::shared_ptr<int> token) -> Fibre {
+    for (;;)
+    {
+      ++*token;
+      co_yield {};
+    }
+  };
+  const auto parent = [&child](Scheduler &scheduler, std::shared_ptr<int> token) -> Fibre {
+    Scope scope{ scheduler };
+    scope.start(child(token));
+    scope.start(child(token));
+    co_yield {};
+    co_yield {};
+  };
+
+  scheduler.start(parent(scheduler, token));
+  for (int i = 0; i < 2; ++i)
+  {
+    scheduler.update();
+    EXPECT_EQ(scheduler.runningCount(), 3u);
+  }
+  EXPECT_EQ(token.use_count(), 4);
+  EXPECT_EQ(*token, 4);
+
+  // The parent completes, cancelling the children.
+  scheduler.update();
+  EXPECT_TRUE(scheduler.empty());
+  EXPECT_EQ(token.use_count(), 1);
+  EXPECT_EQ(*token, 4);
+}
+
+TEST(Scope, cancelParked)
+{
+  // Cancelling removes sleeping children immediately and detaches children parked on an event or a
+  // join, rather than leaving them until they would next wake.
+  Scheduler scheduler{ test::makeClock() };
+  Event event;
+  const Id forever_id = scheduler.start([]() -> Fibre {
+    for (;;)
+    {
+      co_yield {};
+    }
+  }());
+
+  Id sleeper_id{};
+  Id waiter_id{};
+  Id joiner_id{};
+  auto token = std::make_shared<int>(0);
+  {
+    Scope scope{ scheduler };
+    sleeper_id = scope.start([](std::shared_ptr<int>) -> Fibre { co_await 3600.0; }(token));
+    waiter_id = scope.start([](Event &event, std::shared_ptr<int>) -> Fibre {
+      co_await event;
+    }(event, token));
+    joiner_id = scope.start([](Id forever_id, std::shared_ptr<int>) -> Fibre {
+      co_await forever_id;
+    }(forever_id, token));
+    scheduler.update();
+    EXPECT_EQ(event.waiterCount(), 1u);
+    EXPECT_EQ(scope.runningCount(), 3u);
+    EXPECT_EQ(token.use_count(), 4);
+  }
+
+  // The sleeper is gone. The parked children are back with the scheduler, flagged for cancellation.
+  EXPECT_FALSE(sleeper_id.running());
+  EXPECT_EQ(event.waiterCount(), 0u);
+  EXPECT_TRUE(waiter_id.running());
+  EXPECT_TRUE(joiner_id.running());
+
+  scheduler.update();
+  EXPECT_FALSE(waiter_id.running());
+  EXPECT_FALSE(joiner_id.running());
+  EXPECT_EQ(token.use_count(), 1);
+  EXPECT_EQ(scheduler.runningCount(), 1u);
+  EXPECT_TRUE(forever_id.running());
+}
+
+TEST(Scope, threadPool)
+{
+  ThreadPool pool{ test::makeClock(), { .worker_count = 4 } };
+  std::atomic_int completed = 0;
+  std::atomic_bool joined = false;
+
+  const auto child = [](std::atomic_int &completed) -> Fibre {
+    co_yield {};
+    ++completed;
+  };
+  const auto parent = [&child](ThreadPool &pool, std::atomic_int &completed,
+                               std::atomic_bool &joined) -> Fibre {
+    Scope scope{ pool };
+    for (int i = 0; i < 1000; ++i)
+    {
+      scope.start(child(completed));
+    }
+    co_await scope.whenAll();
+    EXPECT_EQ(completed, 1000);
+    joined = true;
+  };
+
+  pool.start(parent(pool, completed, joined));
+  // ThreadPool::wait() does not account for fibres in flight on workers. Wait for the parent.
+  const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!joined && std::chrono::steady_clock::now() < timeout)
+  {
+    std::this_thread::yield();
+  }
+  EXPECT_TRUE(joined);
+  EXPECT_EQ(completed, 1000);
+}
+
+TEST(Scope, threadPoolWhenAny)
+{
+  // Completions race with the parent parking in whenAny(). Every completion resumes the parent
+  // once.
+  ThreadPool pool{ test::makeClock(), { .worker_count = 4 } };
+  std::atomic_int resumes = 0;
+  std::atomic_bool joined = false;
+
+  const auto child = []() -> Fibre { co_yield {}; };
+  const auto parent = [&child](ThreadPool &pool, std::atomic_int &resumes,
+                               std::atomic_bool &joined) -> Fibre {
+    Scope scope{ pool };
+    const int child_count = 1000;
+    for (int i = 0; i < child_count; ++i)
+    {
+      scope.start(child());
+    }
+    for (int i = 0; i < child_count; ++i)
+    {
+      co_await scope.whenAny();
+      ++resumes;
+    }
+    EXPECT_TRUE(scope.empty());
+    joined = true;
+  };
+
+  pool.start(parent(pool, resumes, joined));
+  const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!joined && std::chrono::steady_clock::now() < timeout)
+  {
+    std::this_thread::yield();
+  }
+  EXPECT_TRUE(joined);
+  EXPECT_EQ(resumes, 1000);
+}
+}  // namespace morai
@@ -0,0 +1,172 @@
+#include <morai/CompactQueue.hpp>
+#include <morai/SharedQueue.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace morai
+{
+namespace
+{
+Fibre idleFibre()
+{
+  for (;;)
+  {
+    co_yield {};
+  }
+}
+
+void *toItem(uint64_t value)
+{
+  return reinterpret_cast<void *>(static_cast<uintptr_t>(value));
+}
+}  // namespace
+
+TEST(SharedQueue, layouts)
+{
+  // Both layouts keep FIFO order and report fibres which do not fit a bulk push.
+  for (const SharedQueueLayout layout : { SharedQueueLayout::Padded, SharedQueueLayout::Compact })
+  {
+    SharedQueue queue{ 0, 16, SharedQueueParams{ .layout = layout } };
+    std::vector<Fibre> fibres;
+    std::vector<Id> ids;
+    for (int i = 0; i < 20; ++i)
+    {
+      fibres.emplace_back(idleFibre());
+      ids.emplace_back(fibres.back().id());
+    }
+
+    Fibre single = idleFibre();
+    const Id single_id = single.id();
+    ASSERT_TRUE(queue.tryPush(single));
+    EXPECT_FALSE(single.valid());
+
+    const std::size_t pushed = queue.tryPush(std::span{ fibres });
+    EXPECT_EQ(pushed, 15u);
+    EXPECT_EQ(queue.size(), 16u);
+    for (std::size_t i = 0; i < fibres.size(); ++i)
+    {
+      EXPECT_EQ(fibres[i].valid(), i >= pushed);
+    }
+
+    Fibre popped = queue.pop();
+    EXPECT_EQ(popped.id(), single_id);
+
+    std::vector<Fibre> bulk(10);
+    ASSERT_EQ(queue.pop(std::span{ bulk }), bulk.size());
+    for (std::size_t i = 0; i < bulk.size(); ++i)
+    {
+      EXPECT_EQ(bulk[i].id(), ids[i]);
+    }
+
+    for (std::size_t i = bulk.size(); i < pushed; ++i)
+    {
+      EXPECT_EQ(queue.pop().id(), ids[i]);
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop().valid());
+  }
+}
+
+TEST(CompactQueue, layout)
+{
+  // Capacity rounds up to a power of two. Slots are packed unless padding is requested.
+  const CompactQueue packed{ 1000 };
+  EXPECT_EQ(packed.capacity(), 1024u);
+  EXPECT_EQ(packed.slotSize(), 16u);
+
+  const CompactQueue padded{ 16, 48 };
+  EXPECT_EQ(padded.capacity(), 16u);
+  EXPECT_EQ(padded.slotSize(), 64u);
+}
+
+TEST(CompactQueue, concurrent)
+{
+  // Producers push singly and in bulk while consumers pop in bulk. Every item must be popped
+  // exactly once.
+  CompactQueue queue{ 64 };
+  const uint64_t per_producer = 20000;
+  const uint64_t producer_count = 4;
+  const int consumer_count = 4;
+  std::atomic<uint64_t> remaining{ per_producer * producer_count };
+  std::vector<std::vector<uint64_t>> popped(consumer_count);
+
+  std::vector<std::thread> threads;
+  for (uint64_t p = 0; p < producer_count; ++p)
+  {
+    threads.emplace_back([&queue, p, per_producer]() {
+      // Items are non-zero.
+      uint64_t next = p * per_producer + 1;
+      const uint64_t end = next + per_producer;
+      std::array<void *, 8> items;
+      while (next < end)
+      {
+        std::size_t pushed = 0;
+        if (next % 2)
+        {
+          pushed = queue.tryPush(toItem(next));
+        }
+        else
+        {
+          const std::size_t count = std::min<std::size_t>(items.size(), end - next);
+          for (std::size_t i = 0; i < count; ++i)
+          {
+            items[i] = toItem(next + i);
+          }
+          pushed = queue.tryPushN(std::span{ items }.first(count));
+        }
+        next += pushed;
+        if (pushed == 0)
+        {
+          // Full. Let consumers run when threads outnumber cores.
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (int c = 0; c < consumer_count; ++c)
+  {
+    threads.emplace_back([&queue, &remaining, &taken = popped[c]]() {
+      std::array<void *, 8> items;
+      while (remaining.load(std::memory_order_relaxed) > 0)
+      {
+        const std::size_t count = queue.tryPopN(items);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+          taken.emplace_back(reinterpret_cast<uintptr_t>(items[i]));
+        }
+        remaining.fetch_sub(count, std::memory_order_relaxed);
+        if (count == 0)
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  std::vector<uint64_t> taken;
+  for (const auto &items : popped)
+  {
+    taken.insert(taken.end(), items.begin(), items.end());
+  }
+  std::ranges::sort(taken);
+  ASSERT_EQ(taken.size(), per_producer * producer_count);
+  for (std::size_t i = 0; i < taken.size(); ++i)
+  {
+    EXPECT_EQ(taken[i], i + 1);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+}  // namespace morai
@@ -0,0 +1,198 @@
+#include "TestClock.hpp"
+
+#include <morai/Event.hpp>
+#include <morai/Scheduler.hpp>
+#include <morai/Task.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace morai
+{
+namespace
+{
+Task<int> add(int a, int b)
+{
+  co_return a + b;
+}
+
+Task<int> recurse(int depth)
+{
+  if (depth == 0)
+  {
+    co_return 0;
+  }
+  const int value = co_await recurse(depth - 1);
+  co_return value + 1;
+}
+
+Task<std::string> throws()
+{
+  throw std::runtime_error("task failure");
+  co_return std::string{};
+}
+}  // namespace
+
+TEST(Task, inline)
+{
+  // Tasks which do not suspend complete within a single fibre update.
+  Scheduler scheduler{ test::makeClock() };
+  int result = 0;
+
+  scheduler.start([](int &result) -> Fibre {
+    result = co_await add(1, 2);
+    result += co_await recurse(1000);
+  }(result));
+
+  scheduler.update();
+  EXPECT_EQ(result, 1003);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Task, suspend)
+{
+  // Suspending within a task suspends the whole fibre.
+  Scheduler scheduler{ test::makeClock() };
+  int steps = 0;
+
+  const auto child = [](int &steps) -> Task<int> {
+    for (int i = 0; i < 3; ++i)
+    {
+      ++steps;
+      co_yield {};
+    }
+    co_return steps;
+  };
+  const auto middle = [](const auto &child, int &steps) -> Task<> {
+    const int value = co_await child(steps);
+    EXPECT_EQ(value, 3);
+    ++steps;
+    co_await 0.25;
+  };
+
+  const auto fibre = [&middle, &child](int &steps) -> Fibre {
+    co_await middle(child, steps);
+    ++steps;
+  };
+  scheduler.start(fibre(steps));
+
+  for (int i = 1; i <= 3; ++i)
+  {
+    scheduler.update();
+    EXPECT_EQ(steps, i);
+  }
+  scheduler.update();
+  EXPECT_EQ(steps, 4);
+  // Sleeping.
+  scheduler.update();
+  scheduler.update();
+  EXPECT_EQ(steps, 4);
+  scheduler.update();
+  EXPECT_EQ(steps, 5);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Task, park)
+{
+  // A task may park the fibre on a waitable object.
+  Scheduler scheduler{ test::makeClock() };
+  Event event;
+  bool done = false;
+
+  const auto child = [](Event &event) -> Task<bool> {
+    co_await event;
+    co_return true;
+  };
+
+  const auto fibre = [&child](Event &event, bool &done) -> Fibre {
+    done = co_await child(event);
+  };
+  scheduler.start(fibre(event, done));
+
+  scheduler.update();
+  EXPECT_EQ(event.waiterCount(), 1u);
+  scheduler.update();
+  EXPECT_FALSE(done);
+
+  event.set();
+  scheduler.update();
+  EXPECT_TRUE(done);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Task, exception)
+{
+  // Exceptions propagate to the awaiting coroutine.
+  Scheduler scheduler{ test::makeClock() };
+  std::string caught;
+
+  scheduler.start([](std::string &caught) -> Fibre {
+    try
+    {
+      co_await throws();
+    }
+    catch (const std::runtime_error &e)
+    {
+      caught = e.what();
+    }
+  }(caught));
+
+  scheduler.update();
+  EXPECT_EQ(caught, "task failure");
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Task, empty)
+{
+  // Awaiting an empty task with a result throws rather than dereferencing a null handle.
+  Scheduler scheduler{ test::makeClock() };
+  bool caught = false;
+
+  scheduler.start([](bool &caught) -> Fibre {
+    co_await Task<>{};
+    try
+    {
+      co_await Task<int>{};
+    }
+    catch (const std::logic_error &)
+    {
+      caught = true;
+    }
+  }(caught));
+
+  scheduler.update();
+  EXPECT_TRUE(caught);
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST(Task, cancel)
+{
+  // Cancelling the fibre destroys suspended tasks.
+  Scheduler scheduler{ test::makeClock() };
+  auto token = std::make_shared<int>(0);
+
+  const auto child = [](std::shared_ptr<int> token) -> Task<> {
+    for (;;)
+    {
+      ++*token;
+      co_yield {};
+    }
+  };
+
+  const auto fibre = [&child](std::shared_ptr<int> token) -> Fibre {
+    co_await child(std::move(token));
+  };
+  const Id id = scheduler.start(fibre(token));
+
+  scheduler.update();
+  scheduler.update();
+  EXPECT_EQ(*token, 2);
+  EXPECT_EQ(token.use_count(), 2);
+
+  EXPECT_TRUE(scheduler.cancel(id));
+  EXPECT_EQ(token.use_count(), 1);
+}
+}  // namespace morai
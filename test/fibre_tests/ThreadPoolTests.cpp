@@ -1,3 +1,4 @@
+#include <morai/Event.hpp>
 #include <morai/Finally.hpp>
 #include <morai/ThreadPool.hpp>
 #include <chrono>
@@ -5,7 +6,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <format>
+#include <thread>
+#include <vector>
 
 namespace morai
 {
@@ -91,7 +95,7 @@ TEST(ThreadPool, cancelAll)
   EXPECT_TRUE(pool.empty());
 }
 
-// FIXME: This test deadlocks as the job queues cannot grow. This is a known limitation.
+// Injection queues overflow when full, so this must not deadlock.
 TEST(ThreadPool, smallQueue)
 {
   ThreadPoolParams params{ .worker_count = 2 };
@@ -134,4 +138,431 @@ TEST(ThreadPool, smallQueue)
 
   unblocker_thread.join();
 }
+
+TEST(ThreadPool, join)
+{
+  // Many fibres join a few targets. Joiners park and are woken on whichever worker completes the
+  // target.
+  ThreadPool pool{ ThreadPoolParams{ .worker_count = 4 } };
+  std::atomic_flag block;
+  block.test_and_set();
+  std::atomic<int> joined = 0;
+
+  const auto target = [](std::atomic_flag &block) -> Fibre {
+    while (block.test())
+    {
+      co_yield {};
+    }
+  };
+  const auto joiner = [](Id target_id, std::atomic<int> &joined) -> Fibre {
+    co_await target_id;
+    EXPECT_FALSE(target_id.running());
+    joined.fetch_add(1, std::memory_order_relaxed);
+  };
+
+  const int target_count = 4;
+  const int joiner_count = 100;
+  std::vector<Id> target_ids;
+  for (int i = 0; i < target_count; ++i)
+  {
+    target_ids.emplace_back(pool.start(target(block)));
+  }
+  for (int i = 0; i < joiner_count; ++i)
+  {
+    pool.start(joiner(target_ids[i % target_count], joined));
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(joined.load(std::memory_order_relaxed), 0);
+  block.clear();
+
+  EXPECT_TRUE(pool.wait(std::chrono::seconds(5)));
+  EXPECT_EQ(joined.load(std::memory_order_relaxed), joiner_count);
+  EXPECT_TRUE(pool.empty());
+}
+
+TEST(ThreadPool, workerStart)
+{
+  // Fibres started from a worker go to the worker's local deque. Idle workers must steal them.
+  ThreadPool pool{ ThreadPoolParams{ .worker_count = 4 } };
+  std::atomic<int> counter = 0;
+  const int child_count = 1000;
+
+  const auto child = [](std::atomic<int> &counter) -> Fibre {
+    co_yield {};
+    counter.fetch_add(1, std::memory_order_relaxed);
+  };
+  const auto parent = [](ThreadPool &pool, std::atomic<int> &counter, int child_count,
+                         const auto &child) -> Fibre {
+    for (int i = 0; i < child_count; ++i)
+    {
+      pool.start(child(counter));
+    }
+    co_return;
+  };
+
+  pool.start(parent(pool, counter, child_count, child));
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (counter.load(std::memory_order_relaxed) < child_count &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(counter.load(std::memory_order_relaxed), child_count);
+  EXPECT_TRUE(pool.wait(std::chrono::seconds(5)));
+}
+
+TEST(ThreadPool, parkedWorkers)
+{
+  // Workers park once idle. Starting a fibre from outside the pool and waking a fibre parked on an
+  // event must both wake a worker.
+  ThreadPool pool{ ThreadPoolParams{ .worker_count = 4 } };
+  Event event;
+  std::atomic<int> stage = 0;
+
+  const auto waiter = [](Event &event, std::atomic<int> &stage) -> Fibre {
+    stage.store(1, std::memory_order_release);
+    co_await event;
+    stage.store(2, std::memory_order_release);
+  };
+
+  const auto wait_for_stage = [&stage](int target) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (stage.load(std::memory_order_acquire) < target &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return stage.load(std::memory_order_acquire) >= target;
+  };
+
+  // Let the workers park.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  pool.start(waiter(event, stage));
+  EXPECT_TRUE(wait_for_stage(1));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(stage.load(std::memory_order_acquire), 1);
+  event.set();
+  EXPECT_TRUE(wait_for_stage(2));
+  EXPECT_TRUE(pool.wait(std::chrono::seconds(5)));
+}
+
+TEST(ThreadPool, injectionLimit)
+{
+  // Small injection queues overflow rather than block. tryStart() applies backpressure.
+  ThreadPoolParams params{ .worker_count = 0 };
+  params.initial_queue_size = 2;
+  params.injection_limit = 10;
+  ThreadPool pool{ params };
+
+  std::atomic<int> counter = 0;
+  const auto task = [](std::atomic<int> &counter) -> Fibre {
+    co_yield {};
+    counter.fetch_add(1, std::memory_order_relaxed);
+  };
+
+  for (unsigned i = 0; i < params.injection_limit; ++i)
+  {
+    Fibre fibre = task(counter);
+    EXPECT_TRUE(pool.tryStart(fibre).has_value());
+    EXPECT_FALSE(fibre.valid());
+  }
+  EXPECT_EQ(pool.injectedCount(), params.injection_limit);
+
+  Fibre rejected = task(counter);
+  EXPECT_FALSE(pool.tryStart(rejected).has_value());
+  EXPECT_TRUE(rejected.valid());
+
+  // start() ignores the limit.
+  pool.start(std::move(rejected));
+  EXPECT_EQ(pool.injectedCount(), params.injection_limit + 1);
+
+  pool.update(std::chrono::seconds(5));
+  EXPECT_EQ(counter.load(std::memory_order_relaxed), params.injection_limit + 1);
+  EXPECT_TRUE(pool.empty());
+}
+
+TEST(ThreadPool, priorityWeights)
+{
+  // Levels are selected by weight while occupied. Weights pair with the unsorted levels.
+  ThreadPoolParams params{ .worker_count = 0 };
+  params.priority_levels = { 10, 0 };
+  params.priority_weights = { 1, 3 };
+  ThreadPool pool{ params };
+
+  std::vector<int32_t> order;
+  const auto task = [](std::vector<int32_t> &order, int32_t priority) -> Fibre {
+    order.emplace_back(priority);
+    co_return;
+  };
+
+  const int fibre_count = 8;
+  for (int i = 0; i < fibre_count; ++i)
+  {
+    pool.start(task(order, 10), 10);
+  }
+  for (int i = 0; i < fibre_count; ++i)
+  {
+    pool.start(task(order, 0), 0);
+  }
+
+  pool.update([]() { return true; });
+  EXPECT_TRUE(pool.empty());
+
+  ASSERT_EQ(order.size(), 2u * fibre_count);
+  const std::vector<int32_t> expected_start = { 0, 0, 10, 0, 0, 0, 10, 0 };
+  EXPECT_TRUE(std::equal(expected_start.begin(), expected_start.end(), order.begin()));
+  // The remainder are selected from the only occupied level.
+  EXPECT_EQ(std::count(order.begin(), order.end(), 0), fibre_count);
+  EXPECT_EQ(std::count(order.end() - fibre_count / 2, order.end(), 10), fibre_count / 2);
+}
+
+TEST(ThreadPool, aging)
+{
+  // Aging bounds how long a worker leaves a low weight level unserved under sustained load. Each
+  // busy resume spins for at least 20us, so a 2ms aging interval allows about 100 busy resumes
+  // between background resumes. Preemption only lowers the count. Without aging the weights allow
+  // about 1000.
+  ThreadPoolParams params{};
+  params.worker_count = 1;
+  params.priority_levels = { 0, 1 };
+  params.priority_weights = { 1000, 1 };
+  params.time_source = PoolTimeSource::Direct;
+  params.aging_interval = std::chrono::milliseconds(2);
+  ThreadPool pool{ params };
+
+  std::atomic_bool stop = false;
+  std::atomic<int> busy_resumes = 0;
+  std::atomic<int> background_count = 0;
+  std::atomic<int> max_gap = 0;
+  std::atomic<int> done = 0;
+
+  const auto busy = [](std::atomic_bool &stop, std::atomic<int> &resumes,
+                       std::atomic<int> &done) -> Fibre {
+    while (!stop.load(std::memory_order_relaxed))
+    {
+      resumes.fetch_add(1, std::memory_order_relaxed);
+      const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(20);
+      while (std::chrono::steady_clock::now() < until)
+      {
+      }
+      co_yield {};
+    }
+    done.fetch_add(1, std::memory_order_relaxed);
+  };
+  const auto background = [](std::atomic_bool &stop, const std::atomic<int> &busy_resumes,
+                             std::atomic<int> &count, std::atomic<int> &max_gap,
+                             std::atomic<int> &done) -> Fibre {
+    int last = busy_resumes.load(std::memory_order_relaxed);
+    while (!stop.load(std::memory_order_relaxed))
+    {
+      const int now = busy_resumes.load(std::memory_order_relaxed);
+      max_gap.store(std::max(max_gap.load(std::memory_order_relaxed), now - last),
+                    std::memory_order_relaxed);
+      last = now;
+      count.fetch_add(1, std::memory_order_relaxed);
+      co_yield {};
+    }
+    done.fetch_add(1, std::memory_order_relaxed);
+  };
+
+  const int busy_count = 10;
+  for (int i = 0; i < busy_count; ++i)
+  {
+    pool.start(busy(stop, busy_resumes, done), 0);
+  }
+  pool.start(background(stop, busy_resumes, background_count, max_gap, done), 1);
+
+  // Sample a number of background resumes, however long that takes.
+  const int samples = 20;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (background_count.load(std::memory_order_relaxed) < samples &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  stop.store(true, std::memory_order_relaxed);
+  EXPECT_GE(background_count.load(std::memory_order_relaxed), samples);
+  EXPECT_LE(max_gap.load(std::memory_order_relaxed), 300);
+
+  const auto done_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (done.load(std::memory_order_relaxed) < busy_count + 1 &&
+         std::chrono::steady_clock::now() < done_deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(done.load(std::memory_order_relaxed), busy_count + 1);
+}
+
+TEST(ThreadPool, waitStatistics)
+{
+  EXPECT_TRUE(ThreadPool{}.waitStatistics().empty());
+
+  ThreadPoolParams params{ .worker_count = 2 };
+  params.priority_levels = { 0, 1 };
+  params.wait_statistics = true;
+  ThreadPool pool{ params };
+
+  std::atomic<int> done = 0;
+  const auto task = [](std::atomic<int> &done) -> Fibre {
+    for (int i = 0; i < 10; ++i)
+    {
+      co_yield {};
+    }
+    done.fetch_add(1, std::memory_order_relaxed);
+  };
+
+  const int fibre_count = 20;
+  for (int i = 0; i < fibre_count; ++i)
+  {
+    pool.start(task(done), i % 2);
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (done.load(std::memory_order_relaxed) < fibre_count &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(done.load(std::memory_order_relaxed), fibre_count);
+
+  const std::vector<LevelWaitStatistics> statistics = pool.waitStatistics();
+  ASSERT_EQ(statistics.size(), 2u);
+  for (std::size_t i = 0; i < statistics.size(); ++i)
+  {
+    const LevelWaitStatistics &level = statistics[i];
+    EXPECT_EQ(level.priority, static_cast<int32_t>(i));
+    // Each fibre resumes 11 times.
+    EXPECT_EQ(level.count, 11u * fibre_count / 2);
+    EXPECT_GE(level.max_wait_s, level.meanWait());
+    EXPECT_GE(level.meanWait(), 0.0);
+  }
+}
+
+namespace
+{
+void testSleep(const ThreadPoolParams &params)
+{
+  ThreadPool pool{ params };
+  const int sleeper_count = 100;
+  std::vector<double> slept_s(sleeper_count, 0.0);
+  std::atomic<int> done = 0;
+
+  // Measure from before starting the fibres. The deadline is set from a time sampled before the
+  // resume which starts the sleep, so timing from within the resume would miss the resume latency.
+  const auto start_time = std::chrono::steady_clock::now();
+  const auto sleeper = [](std::chrono::steady_clock::time_point start_time, double duration_s,
+                          double &slept_s, std::atomic<int> &done) -> Fibre {
+    co_await duration_s;
+    slept_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    done.fetch_add(1, std::memory_order_release);
+  };
+
+  for (int i = 0; i < sleeper_count; ++i)
+  {
+    pool.start(sleeper(start_time, 0.01 * (i % 10), slept_s[i], done));
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (done.load(std::memory_order_acquire) < sleeper_count &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(done.load(std::memory_order_acquire), sleeper_count);
+  // The ticker time source may lag real time by up to a tick when the sleep starts.
+  const double tolerance_s =
+    (params.time_source == PoolTimeSource::Ticker) ?
+      2.0 * std::chrono::duration<double>(params.tick_interval).count() :
+      0.0;
+  for (int i = 0; i < sleeper_count; ++i)
+  {
+    EXPECT_GE(slept_s[i] + tolerance_s, 0.01 * (i % 10));
+  }
+}
+}  // namespace
+
+TEST(ThreadPool, sleep)
+{
+  // Sleeping fibres are parked in the pool timers and resume no earlier than requested.
+  for (const PoolTimeSource time_source : { PoolTimeSource::Ticker, PoolTimeSource::Direct })
+  {
+    ThreadPoolParams params{ .worker_count = 4 };
+    params.time_source = time_source;
+    testSleep(params);
+  }
+}
+
+TEST(ThreadPool, sleepZeroWorkers)
+{
+  // Without workers, update() drives the clock and wakes sleepers.
+  ThreadPool pool{ ThreadPoolParams{ .worker_count = 0 } };
+  std::atomic<int> done = 0;
+  const auto sleeper = [](std::atomic<int> &done) -> Fibre {
+    co_await 0.02;
+    done.fetch_add(1, std::memory_order_relaxed);
+  };
+  pool.start(sleeper(done));
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (done.load(std::memory_order_relaxed) == 0 && std::chrono::steady_clock::now() < deadline)
+  {
+    pool.update(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(done.load(std::memory_order_relaxed), 1);
+  EXPECT_TRUE(pool.empty());
+}
+
+TEST(ThreadPool, sleepCancel)
+{
+  // Marking a long sleeper for cancellation removes it from the pool timers promptly, with and
+  // without workers.
+  for (const uint32_t worker_count : { 4u, 0u })
+  {
+    ThreadPool pool{ ThreadPoolParams{ .worker_count = worker_count } };
+    std::atomic<int> started = 0;
+    const auto sleeper = [](std::atomic<int> &started) -> Fibre {
+      started.fetch_add(1, std::memory_order_relaxed);
+      co_await 3600.0;
+    };
+    const Id sleeper_id = pool.start(sleeper(started));
+    const Id survivor_id = pool.start(sleeper(started));
+
+    const auto update = [&pool, worker_count]() {
+      if (worker_count == 0)
+      {
+        pool.update(std::chrono::milliseconds(1));
+      }
+      else
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    };
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (started.load(std::memory_order_relaxed) < 2 &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+      update();
+    }
+    // Let the fibres settle into the timers.
+    for (int i = 0; i < 10; ++i)
+    {
+      update();
+    }
+    ASSERT_EQ(pool.runningCount(), 2u);
+
+    sleeper_id.markForCancellation();
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (sleeper_id.running() && std::chrono::steady_clock::now() < deadline)
+    {
+      update();
+    }
+    EXPECT_FALSE(sleeper_id.running());
+    EXPECT_TRUE(survivor_id.running());
+    EXPECT_EQ(pool.runningCount(), 1u);
+  }
+}
 }  // namespace morai
@@ -0,0 +1,196 @@
+#include "TestClock.hpp"
+
+#include <morai/Scheduler.hpp>
+#include <morai/TimerWheel.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace morai
+{
+namespace
+{
+Fibre idleFibre()
+{
+  for (;;)
+  {
+    co_yield {};
+  }
+}
+}  // namespace
+
+TEST(TimerWheel, expiry)
+{
+  // Park fibres with deadlines spanning multiple wheel levels and ensure they expire in order, no
+  // earlier than their deadline and no later than one granule after.
+  const uint64_t granularity = 10;
+  TimerWheel wheel{ granularity };
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uint64_t> deadline_dist(0, 50'000'000);
+  std::unordered_map<uint64_t, uint64_t> deadlines;
+  for (int i = 0; i < 2000; ++i)
+  {
+    Fibre fibre = idleFibre();
+    const uint64_t deadline = deadline_dist(rng);
+    deadlines.emplace(fibre.id().id(), deadline);
+    wheel.insert(std::move(fibre), deadline);
+  }
+  EXPECT_EQ(wheel.size(), deadlines.size());
+
+  std::vector<Fibre> expired;
+  std::size_t expired_count = 0;
+  uint64_t last_deadline = 0;
+  for (uint64_t now = 0; !wheel.empty(); now += 997)
+  {
+    wheel.advance(now, expired);
+    for (const Fibre &fibre : expired)
+    {
+      const uint64_t deadline = deadlines.at(fibre.id().id());
+      EXPECT_LE(last_deadline / granularity, deadline / granularity);
+      EXPECT_LE(deadline, now);
+      EXPECT_LT(now - deadline, 997 + granularity);
+      last_deadline = deadline;
+      ++expired_count;
+    }
+    expired.clear();
+  }
+  EXPECT_EQ(expired_count, deadlines.size());
+}
+
+TEST(TimerWheel, cancel)
+{
+  TimerWheel wheel;
+  std::vector<Id> ids;
+  for (int i = 0; i < 100; ++i)
+  {
+    Fibre fibre = idleFibre();
+    ids.emplace_back(fibre.id());
+    // Share slots so cancellation must fix up swapped entries.
+    wheel.insert(std::move(fibre), 1'000'000u * (1 + i % 3));
+  }
+
+  for (std::size_t i = 0; i < ids.size(); i += 2)
+  {
+    EXPECT_TRUE(wheel.contains(ids[i]));
+    EXPECT_TRUE(wheel.cancel(ids[i]));
+    EXPECT_FALSE(ids[i].running());
+    EXPECT_FALSE(wheel.cancel(ids[i]));
+  }
+  EXPECT_EQ(wheel.size(), ids.size() / 2);
+
+  std::vector<Fibre> expired;
+  wheel.advance(10'000'000u, expired);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(expired.size(), ids.size() / 2);
+  for (const Fibre &fibre : expired)
+  {
+    EXPECT_TRUE(std::ranges::find(ids, fibre.id()) != ids.end());
+  }
+}
+
+TEST(TimerWheel, nextExpiry)
+{
+  // nextExpiry() must never pass the earliest deadline, and advancing to it must make progress.
+  const uint64_t granularity = 10;
+  TimerWheel wheel{ granularity };
+  EXPECT_FALSE(wheel.nextExpiry().has_value());
+
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<uint64_t> deadline_dist(1, 50'000'000);
+  std::vector<uint64_t> deadlines;
+  for (int i = 0; i < 500; ++i)
+  {
+    deadlines.emplace_back(deadline_dist(rng));
+    wheel.insert(idleFibre(), deadlines.back());
+  }
+  std::ranges::sort(deadlines);
+
+  std::vector<Fibre> expired;
+  std::size_t expired_count = 0;
+  uint64_t last_expiry = 0;
+  while (!wheel.empty())
+  {
+    const std::optional<uint64_t> next = wheel.nextExpiry();
+    ASSERT_TRUE(next.has_value());
+    // Deadlines round up to the granularity.
+    const uint64_t earliest = deadlines[expired_count];
+    EXPECT_LE(*next, (earliest + granularity - 1) / granularity * granularity);
+    EXPECT_GE(*next, last_expiry);
+    last_expiry = *next;
+    wheel.advance(*next, expired);
+    expired_count += expired.size();
+    expired.clear();
+  }
+  EXPECT_EQ(expired_count, deadlines.size());
+}
+
+TEST(TimerWheel, schedulerSleep)
+{
+  // Sleeping fibres are parked and not resumed until due.
+  const double dt = 0.01;
+  Scheduler scheduler{ test::makeClock(dt) };
+  struct Sleeper
+  {
+    double duration = 0;
+    double woke_at = 0;
+    int resumes = 0;
+  };
+
+  std::vector<Sleeper> sleepers(200);
+  const auto sleeper_fibre = [](Sleeper &sleeper, const Scheduler &scheduler) -> Fibre {
+    ++sleeper.resumes;
+    co_await sleeper.duration;
+    ++sleeper.resumes;
+    sleeper.woke_at = scheduler.time().epoch_time_s;
+  };
+
+  for (std::size_t i = 0; i < sleepers.size(); ++i)
+  {
+    sleepers[i].duration = 0.05 * static_cast<double>(i % 20);
+    scheduler.start(sleeper_fibre(sleepers[i], scheduler));
+  }
+
+  // The first update starts every fibre, parking those with a sleep.
+  scheduler.update();
+  EXPECT_EQ(scheduler.runningCount(), sleepers.size());
+
+  while (!scheduler.empty())
+  {
+    scheduler.update();
+  }
+
+  for (const Sleeper &sleeper : sleepers)
+  {
+    EXPECT_EQ(sleeper.resumes, 2);
+    EXPECT_GE(sleeper.woke_at + 1e-9, sleeper.duration);
+    EXPECT_LE(sleeper.woke_at, sleeper.duration + dt + 1e-9);
+  }
+}
+
+TEST(TimerWheel, schedulerCancel)
+{
+  Scheduler scheduler{ test::makeClock() };
+  const Id sleeper_id = scheduler.start([]() -> Fibre { co_await 100.0; }());
+  const Id marked_id = scheduler.start([]() -> Fibre { co_await 3600.0; }());
+  scheduler.update();
+  EXPECT_EQ(scheduler.runningCount(), 2u);
+
+  // Immediate cancellation of a parked fibre.
+  EXPECT_TRUE(scheduler.cancel(sleeper_id));
+  EXPECT_FALSE(sleeper_id.running());
+  EXPECT_EQ(scheduler.runningCount(), 1u);
+
+  // Marked fibres are cancelled on the next update, without waiting out the sleep.
+  marked_id.markForCancellation();
+  EXPECT_TRUE(marked_id.running());
+  scheduler.update();
+  EXPECT_FALSE(marked_id.running());
+  EXPECT_TRUE(scheduler.empty());
+}
+}  // namespace morai
@@ -0,0 +1,181 @@
+#include <morai/WorkStealingDeque.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace morai
+{
+namespace
+{
+Fibre idleFibre()
+{
+  for (;;)
+  {
+    co_yield {};
+  }
+}
+}  // namespace
+
+TEST(WorkStealingDeque, order)
+{
+  // Owner pops LIFO while thieves steal FIFO. Push enough to force the deque to grow.
+  WorkStealingDeque deque{ 16 };
+  std::vector<Id> ids;
+  for (int i = 0; i < 100; ++i)
+  {
+    Fibre fibre = idleFibre();
+    ids.emplace_back(fibre.id());
+    deque.push(std::move(fibre));
+  }
+  EXPECT_EQ(deque.size(), ids.size());
+
+  for (std::size_t i = 0; i < ids.size() / 2; ++i)
+  {
+    Fibre fibre = deque.steal();
+    ASSERT_TRUE(fibre.valid());
+    EXPECT_EQ(fibre.id(), ids[i]);
+  }
+
+  for (std::size_t i = ids.size(); i > ids.size() / 2; --i)
+  {
+    Fibre fibre = deque.pop();
+    ASSERT_TRUE(fibre.valid());
+    EXPECT_EQ(fibre.id(), ids[i - 1]);
+  }
+
+  EXPECT_TRUE(deque.empty());
+  EXPECT_FALSE(deque.pop().valid());
+  EXPECT_FALSE(deque.steal().valid());
+}
+
+TEST(WorkStealingDeque, concurrentSteal)
+{
+  // The owner pushes and pops while thieves steal. Every fibre must be taken exactly once.
+  WorkStealingDeque deque{ 16 };
+  const int fibre_count = 20000;
+  const int thief_count = 4;
+  std::atomic_flag done = ATOMIC_FLAG_INIT;
+  std::vector<std::vector<uint64_t>> stolen(thief_count);
+
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < thief_count; ++i)
+  {
+    thieves.emplace_back([&deque, &done, &taken = stolen[i]]() {
+      while (!done.test() || !deque.empty())
+      {
+        Fibre fibre = deque.steal();
+        if (fibre.valid())
+        {
+          taken.emplace_back(fibre.id().id());
+        }
+      }
+    });
+  }
+
+  std::vector<uint64_t> pushed;
+  std::vector<uint64_t> popped;
+  for (int i = 0; i < fibre_count; ++i)
+  {
+    Fibre fibre = idleFibre();
+    pushed.emplace_back(fibre.id().id());
+    deque.push(std::move(fibre));
+    if (i % 3 == 0)
+    {
+      Fibre own = deque.pop();
+      if (own.valid())
+      {
+        popped.emplace_back(own.id().id());
+      }
+    }
+  }
+  done.test_and_set();
+  for (auto &thief : thieves)
+  {
+    thief.join();
+  }
+
+  std::vector<uint64_t> taken = popped;
+  for (const auto &ids : stolen)
+  {
+    taken.insert(taken.end(), ids.begin(), ids.end());
+  }
+  std::ranges::sort(pushed);
+  std::ranges::sort(taken);
+  EXPECT_EQ(taken, pushed);
+}
+
+TEST(WorkStealingDeque, takeOldest)
+{
+  // The owner takes batches from the top while thieves steal. Every fibre must be taken exactly
+  // once and each batch must be in FIFO order.
+  WorkStealingDeque deque{ 16 };
+  const int fibre_count = 20000;
+  const int thief_count = 4;
+  std::atomic_flag done = ATOMIC_FLAG_INIT;
+  std::vector<std::vector<uint64_t>> stolen(thief_count);
+
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < thief_count; ++i)
+  {
+    thieves.emplace_back([&deque, &done, &taken = stolen[i]]() {
+      while (!done.test() || !deque.empty())
+      {
+        Fibre fibre = deque.steal();
+        if (fibre.valid())
+        {
+          taken.emplace_back(fibre.id().id());
+        }
+      }
+    });
+  }
+
+  std::vector<uint64_t> pushed;
+  std::unordered_map<uint64_t, int> push_order;
+  std::vector<uint64_t> batched;
+  std::vector<Fibre> batch(8);
+  for (int i = 0; i < fibre_count; ++i)
+  {
+    Fibre fibre = idleFibre();
+    pushed.emplace_back(fibre.id().id());
+    push_order[fibre.id().id()] = i;
+    deque.push(std::move(fibre));
+    if (i % 16 == 0)
+    {
+      const std::size_t count = deque.takeOldest(batch);
+      for (std::size_t j = 0; j < count; ++j)
+      {
+        ASSERT_TRUE(batch[j].valid());
+        if (j > 0)
+        {
+          EXPECT_LT(push_order[batch[j - 1].id().id()], push_order[batch[j].id().id()]);
+        }
+        batched.emplace_back(batch[j].id().id());
+      }
+      for (Fibre &taken : batch)
+      {
+        taken = Fibre{};
+      }
+    }
+  }
+  done.test_and_set();
+  for (auto &thief : thieves)
+  {
+    thief.join();
+  }
+
+  std::vector<uint64_t> taken = batched;
+  for (const auto &ids : stolen)
+  {
+    taken.insert(taken.end(), ids.begin(), ids.end());
+  }
+  std::ranges::sort(pushed);
+  std::ranges::sort(taken);
+  EXPECT_EQ(taken, pushed);
+  EXPECT_FALSE(batched.empty());
+}
+}  // namespace morai